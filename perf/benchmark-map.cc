@@ -0,0 +1,82 @@
+/*
+ * Micro-benchmark for hb_map_t insertion, lookup and deletion, with keys
+ * shaped like the subsetter's glyph and codepoint maps.
+ *
+ * Build and run with map.sh.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hb.h"
+
+#define NUM_KEYS 65536
+
+template <typename Func>
+static void
+bench (const char *name, unsigned int iterations, Func func)
+{
+  auto start = std::chrono::steady_clock::now ();
+  unsigned int sink = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    sink += func ();
+  auto end = std::chrono::steady_clock::now ();
+  double us = std::chrono::duration<double, std::micro> (end - start).count ();
+  printf ("%-24s %10.3f us/iter   (%u)\n", name, us / iterations, sink);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = argc > 1 ? atoi (argv[1]) : 200;
+
+  static hb_codepoint_t keys[NUM_KEYS];
+  static const char *names[] = {"glyphs", "codepoints"};
+  for (unsigned int kind = 0; kind < 2; kind++)
+  {
+    /* Dense glyph ids, or codepoints scattered over the BMP and beyond. */
+    srand (1);
+    for (unsigned int i = 0; i < NUM_KEYS; i++)
+      keys[i] = kind ? (hb_codepoint_t) rand () % 0x30000 : i;
+    printf ("%s:\n", names[kind]);
+
+    hb_map_t *m = hb_map_create ();
+    bench ("insert", iterations, [&] () {
+      hb_map_clear (m);
+      for (unsigned int i = 0; i < NUM_KEYS; i++)
+	hb_map_set (m, keys[i], i);
+      return hb_map_get_population (m);
+    });
+    bench ("get (hit)", iterations, [&] () {
+      unsigned int sum = 0;
+      for (unsigned int i = 0; i < NUM_KEYS; i++)
+	sum += hb_map_get (m, keys[i]);
+      return sum;
+    });
+    bench ("get (miss)", iterations, [&] () {
+      unsigned int count = 0;
+      for (unsigned int i = 0; i < NUM_KEYS; i++)
+	count += hb_map_has (m, keys[i] + 0x40000);
+      return count;
+    });
+    bench ("insert + del", iterations, [&] () {
+      for (unsigned int i = 0; i < NUM_KEYS; i++)
+	hb_map_set (m, keys[i], i);
+      for (unsigned int i = 0; i < NUM_KEYS; i += 2)
+	hb_map_del (m, keys[i]);
+      return hb_map_get_population (m);
+    });
+    bench ("create + insert", iterations, [&] () {
+      hb_map_t *n = hb_map_create ();
+      for (unsigned int i = 0; i < NUM_KEYS; i++)
+	hb_map_set (n, keys[i], i);
+      unsigned int population = hb_map_get_population (n);
+      hb_map_destroy (n);
+      return population;
+    });
+    hb_map_destroy (m);
+  }
+
+  return 0;
+}
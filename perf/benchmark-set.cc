@@ -0,0 +1,113 @@
+/*
+ * Micro-benchmark for hb_set_t algebra, population counts and iteration,
+ * on sets the size of a large font's glyph set.
+ *
+ * Build and run with set.sh.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hb.h"
+
+#define NUM_GLYPHS 65536
+
+static hb_set_t *
+create_set (unsigned int density_percent, unsigned int seed)
+{
+  hb_set_t *set = hb_set_create ();
+  srand (seed);
+  for (unsigned int g = 0; g < NUM_GLYPHS; g++)
+    if ((unsigned int) rand () % 100 < density_percent)
+      hb_set_add (set, g);
+  return set;
+}
+
+template <typename Func>
+static void
+bench (const char *name, unsigned int iterations, Func func)
+{
+  auto start = std::chrono::steady_clock::now ();
+  unsigned int sink = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    sink += func ();
+  auto end = std::chrono::steady_clock::now ();
+  double us = std::chrono::duration<double, std::micro> (end - start).count ();
+  printf ("%-24s %10.3f us/iter   (%u)\n", name, us / iterations, sink);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = argc > 1 ? atoi (argv[1]) : 2000;
+
+  static const unsigned int densities[] = {2, 50};
+  for (unsigned int density : densities)
+  {
+    printf ("density %u%%:\n", density);
+    hb_set_t *a = create_set (density, 1);
+    hb_set_t *b = create_set (density, 2);
+    hb_set_t *r = hb_set_create ();
+
+#define BENCH_OP(op) \
+    bench (#op, iterations, [&] () { \
+      hb_set_set (r, a); \
+      hb_set_##op (r, b); \
+      return hb_set_get_population (r); \
+    })
+    BENCH_OP (union);
+    BENCH_OP (intersect);
+    BENCH_OP (subtract);
+    BENCH_OP (symmetric_difference);
+#undef BENCH_OP
+
+    bench ("is_empty", iterations, [&] () {
+      hb_set_set (r, a);
+      hb_set_subtract (r, a);
+      return (unsigned int) hb_set_is_empty (r);
+    });
+    bench ("next", iterations / 10 + 1, [&] () {
+      unsigned int count = 0;
+      hb_codepoint_t g = HB_SET_VALUE_INVALID;
+      while (hb_set_next (a, &g))
+	count++;
+      return count;
+    });
+    bench ("next_range", iterations / 10 + 1, [&] () {
+      unsigned int count = 0;
+      hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+      while (hb_set_next_range (a, &first, &last))
+	count++;
+      return count;
+    });
+
+    hb_set_destroy (r);
+    hb_set_destroy (b);
+    hb_set_destroy (a);
+  }
+
+  printf ("runs:\n");
+  hb_set_t *runs = hb_set_create ();
+  for (unsigned int g = 0; g < NUM_GLYPHS; g += 1024)
+    hb_set_add_range (runs, g, g + 700);
+  auto bench_ranges = [&] () {
+    unsigned int count = 0;
+    hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+    while (hb_set_next_range (runs, &first, &last))
+      count++;
+    return count;
+  };
+  bench ("next_range", iterations, bench_ranges);
+  hb_set_invert (runs);
+  bench ("next_range (inverted)", iterations, bench_ranges);
+  bench ("has (inverted)", iterations / 10 + 1, [&] () {
+    unsigned int count = 0;
+    for (hb_codepoint_t g = 0; g < NUM_GLYPHS; g++)
+      count += hb_set_has (runs, g);
+    return count;
+  });
+  hb_set_destroy (runs);
+
+  return 0;
+}
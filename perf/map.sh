@@ -0,0 +1,11 @@
+#!/bin/bash
+# Micro-benchmarks hb_map_t operations.
+CXX=clang++
+ITERATIONS=${ITERATIONS:-200}
+
+$CXX benchmark-map.cc ../src/harfbuzz.cc \
+  -lm -fno-rtti -fno-exceptions -fno-omit-frame-pointer -DHB_NO_MT \
+  -I../src $FLAGS $SOURCES \
+  -o benchmark-map -g -O2
+
+./benchmark-map $ITERATIONS
@@ -0,0 +1,12 @@
+#!/bin/bash
+# Micro-benchmarks hb_set_t operations.  Pass eg. FLAGS=-march=native to
+# see the wider vector and popcount code paths.
+CXX=clang++
+ITERATIONS=${ITERATIONS:-2000}
+
+$CXX benchmark-set.cc ../src/harfbuzz.cc \
+  -lm -fno-rtti -fno-exceptions -fno-omit-frame-pointer -DHB_NO_MT \
+  -I../src $FLAGS $SOURCES \
+  -o benchmark-set -g -O2
+
+./benchmark-set $ITERATIONS
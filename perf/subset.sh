@@ -0,0 +1,19 @@
+#!/bin/bash
+# Times hb-subset.  glyf/loca subsetting dominates on large TrueType fonts,
+# so point FONT at a ~65k glyph font (eg. a Noto Sans CJK .ttf build), eg.:
+#   FONT=NotoSansCJKsc-Regular.ttf ./subset.sh --retain-gids
+CXX=clang++
+FONT=${FONT:-fonts/Roboto-Regular.ttf}
+ITERATIONS=${ITERATIONS:-100}
+
+$CXX ../util/hb-subset.cc ../util/options.cc ../util/options-subset.cc \
+  ../src/harfbuzz.cc ../src/hb-subset*.cc \
+  -lm -fno-rtti -fno-exceptions -fno-omit-frame-pointer -DHB_NO_MT \
+  -I../src $FLAGS $SOURCES \
+  -DPACKAGE_NAME='""' -DPACKAGE_VERSION='""' \
+  -DHAVE_GLIB $(pkg-config --cflags --libs glib-2.0) \
+  -o hb-subset -g -O2
+
+perf stat ./hb-subset -o /dev/null $FONT --text='*' --num-iterations=$ITERATIONS "$@"
+#perf record -g ./hb-subset -o /dev/null $FONT --text='*' --num-iterations=$ITERATIONS "$@"
+#perf report -g
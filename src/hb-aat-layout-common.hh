@@ -29,6 +29,7 @@
 
 #include "hb-aat-layout.hh"
 #include "hb-open-type.hh"
+#include "hb-set-digest.hh"
 
 
 namespace AAT {
@@ -54,6 +55,14 @@ struct LookupFormat0
     return &arrayZ[glyph_id];
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, unsigned int num_glyphs, const filter_t &filter) const
+  {
+    for (unsigned int i = 0; i < num_glyphs; i++)
+      if (filter (arrayZ[i]))
+	glyphs.add (i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -112,6 +121,18 @@ struct LookupFormat2
     return v ? &v->value : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = segments.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+    {
+      const LookupSegmentSingle<T> &segment = segments[i];
+      if (filter (segment.value))
+	glyphs.add_range (segment.first, segment.last);
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -146,6 +167,16 @@ struct LookupSegmentArray
   int cmp (hb_codepoint_t g) const
   { return g < first ? -1 : g <= last ? 0 : +1; }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, const void *base, const filter_t &filter) const
+  {
+    if (unlikely (first > last)) return;
+    const UnsizedArrayOf<T> &values = base+valuesZ;
+    for (unsigned int i = 0, count = last - first + 1; i < count; i++)
+      if (filter (values[i]))
+	glyphs.add (first + i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c, const void *base) const
   {
     TRACE_SANITIZE (this);
@@ -183,6 +214,14 @@ struct LookupFormat4
     return v ? v->get_value (glyph_id, this) : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = segments.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+      segments[i].collect_glyphs_filtered (glyphs, this, filter);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -240,6 +279,18 @@ struct LookupFormat6
     return v ? &v->value : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = entries.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+    {
+      const LookupSingle<T> &entry = entries[i];
+      if (filter (entry.value))
+	glyphs.add (entry.glyph);
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -271,6 +322,15 @@ struct LookupFormat8
 	   &valueArrayZ[glyph_id - firstGlyph] : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = glyphCount;
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (valueArrayZ[i]))
+	glyphs.add (firstGlyph + i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -370,6 +430,23 @@ struct Lookup
     return v ? *v : outOfRange;
   }
 
+  /* Adds to glyphs every glyph this lookup has a value for that passes
+   * filter.  Format 10 is not supported, same as in get_value(). */
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs,
+				unsigned int num_glyphs,
+				const filter_t &filter) const
+  {
+    switch (u.format) {
+    case 0: u.format0.collect_glyphs_filtered (glyphs, num_glyphs, filter); return;
+    case 2: u.format2.collect_glyphs_filtered (glyphs, filter); return;
+    case 4: u.format4.collect_glyphs_filtered (glyphs, filter); return;
+    case 6: u.format6.collect_glyphs_filtered (glyphs, filter); return;
+    case 8: u.format8.collect_glyphs_filtered (glyphs, filter); return;
+    default:return;
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -475,6 +552,126 @@ struct Entry<void>
   DEFINE_SIZE_STATIC (4);
 };
 
+/*
+ * Subtable accelerator
+ *
+ * Built once per subtable when the face loads.  For state machines, holds
+ * the machine's glyph classes as a dense array over the span of glyphs its
+ * class table covers, replacing a binary search per glyph, and a digest
+ * of the glyphs the subtable may act upon.  A subtable is skippable when
+ * glyphs outside of the digest leave the machine idling in its start
+ * state; a buffer with none of the digest glyphs is then left untouched.
+ *
+ * For kerning pair lists, holds where the pairs of each left glyph start,
+ * such that a pair is only searched for among those of its left glyph.
+ */
+
+struct hb_aat_subtable_accelerator_t
+{
+  enum { MAX_DENSE_CLASSES = 16384 };
+
+  void init ()
+  {
+    digest.init ();
+    skippable = false;
+    first_glyph = 0;
+    classes.init ();
+    first_left = 0;
+    pair_starts.init ();
+  }
+  void fini ()
+  {
+    digest.fini ();
+    classes.fini ();
+    pair_starts.fini ();
+  }
+
+  bool has_classes () const { return classes.length; }
+
+  /* Only valid if has_classes (). */
+  unsigned int get_class (hb_codepoint_t glyph_id) const
+  {
+    if (unlikely (glyph_id == DELETED_GLYPH)) return 2; /* CLASS_DELETED_GLYPH */
+    unsigned int i = glyph_id - first_glyph;
+    return i < classes.length ? classes.arrayZ[i] : 1; /* CLASS_OUT_OF_BOUNDS */
+  }
+
+  bool has_pair_index () const { return pair_starts.length; }
+
+  /* Only valid if has_pair_index ().  Returns the run of pairs, as
+   * [*start, *end), that have left as their left glyph. */
+  void get_pair_range (hb_codepoint_t left,
+		       unsigned int *start, unsigned int *end) const
+  {
+    unsigned int i = left - first_left;
+    if (i < pair_starts.length - 1)
+    {
+      *start = pair_starts.arrayZ[i];
+      *end = pair_starts.arrayZ[i + 1];
+    }
+    else
+      *start = *end = 0;
+  }
+
+  bool may_have (hb_codepoint_t glyph_id) const
+  { return digest.may_have (glyph_id); }
+
+  bool may_apply (const hb_buffer_t *buffer) const
+  {
+    if (!skippable) return true;
+    const hb_glyph_info_t *info = buffer->info;
+    unsigned int count = buffer->len;
+    for (unsigned int i = 0; i < count; i++)
+      if (digest.may_have (info[i].codepoint))
+	return true;
+    return false;
+  }
+
+  hb_set_digest_adaptive_t digest;
+  bool skippable;
+  hb_codepoint_t first_glyph;
+  hb_vector_t<uint16_t> classes;
+  hb_codepoint_t first_left;
+  hb_vector_t<unsigned int> pair_starts;
+};
+
+
+/* Face-level accelerator for a table made of subtables, like 'morx' or
+ * 'kerx'.  T provides get_subtable_count () and init_accelerators (). */
+template <typename T>
+struct hb_aat_table_accelerator_t
+{
+  void init (hb_face_t *face)
+  {
+    this->table = hb_sanitize_context_t ().reference_table<T> (face);
+
+    this->subtable_count = table->get_subtable_count ();
+
+    this->accels = (hb_aat_subtable_accelerator_t *) calloc (this->subtable_count, sizeof (hb_aat_subtable_accelerator_t));
+    if (unlikely (!this->accels))
+      this->subtable_count = 0;
+
+    for (unsigned int i = 0; i < this->subtable_count; i++)
+      this->accels[i].init ();
+    table->init_accelerators (this->accels, this->subtable_count, face->get_num_glyphs ());
+  }
+
+  void fini ()
+  {
+    for (unsigned int i = 0; i < this->subtable_count; i++)
+      this->accels[i].fini ();
+    free (this->accels);
+    this->table.destroy ();
+  }
+
+  hb_array_t<const hb_aat_subtable_accelerator_t> get_subtable_accels () const
+  { return hb_array (this->accels, this->subtable_count); }
+
+  hb_blob_ptr_t<T> table;
+  unsigned int subtable_count;
+  hb_aat_subtable_accelerator_t *accels;
+};
+
 template <typename Types, typename Extra>
 struct StateTable
 {
@@ -507,6 +704,59 @@ struct StateTable
   const Entry<Extra> *get_entries () const
   { return (this+entryTable).arrayZ; }
 
+  /* Fills in accel for this machine.  is_actionable tells whether an
+   * entry may change the buffer; dont_advance is the DontAdvance flag of
+   * the subtable type. */
+  template <typename filter_t>
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs,
+			 const filter_t &is_actionable,
+			 unsigned int dont_advance) const
+  {
+    hb_set_t glyphs;
+    (this+classTable).collect_glyphs_filtered (glyphs, num_glyphs,
+					      [] (unsigned int klass)
+					      { return klass != CLASS_OUT_OF_BOUNDS; });
+
+    if (!glyphs.is_empty ())
+    {
+      hb_codepoint_t first = glyphs.get_min ();
+      unsigned int span = glyphs.get_max () - first + 1;
+      if (span <= hb_aat_subtable_accelerator_t::MAX_DENSE_CLASSES &&
+	  accel->classes.resize (span))
+      {
+	accel->first_glyph = first;
+	for (unsigned int i = 0; i < span; i++)
+	  accel->classes[i] = CLASS_OUT_OF_BOUNDS;
+	hb_codepoint_t g = HB_SET_VALUE_INVALID;
+	while (glyphs.next (&g))
+	  accel->classes[g - first] = get_class (g, num_glyphs);
+      }
+    }
+
+    /* Glyphs without a class of their own must not kick the machine out
+     * of its start state, and neither may end-of-text.  Deleted glyphs
+     * are only ever in the buffer after an earlier subtable ran, so
+     * rather than giving up, add them to the digest if they matter. */
+    accel->skippable = true;
+    const unsigned int idle_classes[] = {CLASS_END_OF_TEXT, CLASS_OUT_OF_BOUNDS, CLASS_DELETED_GLYPH};
+    for (unsigned int i = 0; i < ARRAY_LENGTH (idle_classes); i++)
+    {
+      unsigned int klass = idle_classes[i];
+      const Entry<Extra> &entry = get_entry (STATE_START_OF_TEXT, klass);
+      if (!is_actionable (entry) &&
+	  new_state (entry.newState) == STATE_START_OF_TEXT &&
+	  !(entry.flags & dont_advance))
+	continue;
+      if (klass == CLASS_DELETED_GLYPH)
+	glyphs.add (DELETED_GLYPH);
+      else
+	accel->skippable = false;
+    }
+
+    accel->digest.init (glyphs);
+  }
+
   const Entry<Extra> &get_entry (int state, unsigned int klass) const
   {
     if (unlikely (klass >= nClasses))
@@ -652,6 +902,17 @@ struct ClassTable
   {
     return get_class (glyph_id, outOfRange);
   }
+
+  template <typename set_t, typename filter_t>
+  void collect_glyphs_filtered (set_t &glyphs,
+				unsigned int num_glyphs HB_UNUSED,
+				const filter_t &filter) const
+  {
+    unsigned int count = classArray.len;
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (classArray.arrayZ[i]))
+	glyphs.add (firstGlyph + i);
+  }
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -731,10 +992,18 @@ struct StateTableDriver
 {
   StateTableDriver (const StateTable<Types, EntryData> &machine_,
 		    hb_buffer_t *buffer_,
-		    hb_face_t *face_) :
+		    hb_face_t *face_,
+		    const hb_aat_subtable_accelerator_t *accel_ = nullptr) :
 	      machine (machine_),
 	      buffer (buffer_),
-	      num_glyphs (face_->get_num_glyphs ()) {}
+	      num_glyphs (face_->get_num_glyphs ()),
+	      accel (accel_ && accel_->has_classes () ? accel_ : nullptr) {}
+
+  unsigned int get_class (hb_codepoint_t glyph_id) const
+  {
+    return accel ? accel->get_class (glyph_id) :
+		   machine.get_class (glyph_id, num_glyphs);
+  }
 
   template <typename context_t>
   void drive (context_t *c)
@@ -746,7 +1015,7 @@ struct StateTableDriver
     for (buffer->idx = 0; buffer->successful;)
     {
       unsigned int klass = buffer->idx < buffer->len ?
-			   machine.get_class (buffer->info[buffer->idx].codepoint, num_glyphs) :
+			   get_class (buffer->info[buffer->idx].codepoint) :
 			   (unsigned) StateTable<Types, EntryData>::CLASS_END_OF_TEXT;
       DEBUG_MSG (APPLY, nullptr, "c%u at %u", klass, buffer->idx);
       const Entry<EntryData> &entry = machine.get_entry (state, klass);
@@ -797,6 +1066,8 @@ struct StateTableDriver
   const StateTable<Types, EntryData> &machine;
   hb_buffer_t *buffer;
   unsigned int num_glyphs;
+  private:
+  const hb_aat_subtable_accelerator_t *accel;
 };
 
 
@@ -818,7 +1089,11 @@ struct hb_aat_apply_context_t :
   hb_sanitize_context_t sanitizer;
   const ankr *ankr_table;
 
-  /* Unused. For debug tracing only. */
+  /* Accelerators of the subtables being applied, if any, indexed by
+   * lookup_index; subtable_accel is the current one, or nullptr. */
+  hb_array_t<const hb_aat_subtable_accelerator_t> subtable_accels;
+  const hb_aat_subtable_accelerator_t *subtable_accel;
+
   unsigned int lookup_index;
   unsigned int debug_depth;
 
@@ -831,7 +1106,11 @@ struct hb_aat_apply_context_t :
 
   HB_INTERNAL void set_ankr_table (const AAT::ankr *ankr_table_);
 
-  void set_lookup_index (unsigned int i) { lookup_index = i; }
+  void set_lookup_index (unsigned int i)
+  {
+    lookup_index = i;
+    subtable_accel = i < subtable_accels.length ? &subtable_accels[i] : nullptr;
+  }
 };
 
 
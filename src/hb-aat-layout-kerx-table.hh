@@ -68,6 +68,12 @@ struct KernPair
 {
   int get_kerning () const { return value; }
 
+  hb_glyph_pair_t get_pair () const
+  {
+    hb_glyph_pair_t pair = {left, right};
+    return pair;
+  }
+
   int cmp (const hb_glyph_pair_t &o) const
   {
     int ret = left.cmp (o.left);
@@ -96,10 +102,46 @@ struct KerxSubTableFormat0
 		   hb_aat_apply_context_t *c = nullptr) const
   {
     hb_glyph_pair_t pair = {left, right};
-    int v = pairs.bsearch (pair).get_kerning ();
+    int v;
+    const hb_aat_subtable_accelerator_t *accel = c ? c->subtable_accel : nullptr;
+    if (accel && accel->has_pair_index ())
+    {
+      unsigned int start, end;
+      accel->get_pair_range (left, &start, &end);
+      const KernPair *p = pairs.as_array ().sub_array (start, end - start).bsearch (pair);
+      v = p ? p->get_kerning () : 0;
+    }
+    else
+      v = pairs.bsearch (pair).get_kerning ();
     return kerxTupleKern (v, header.tuple_count (), this, c);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs HB_UNUSED) const
+  {
+    /* Only index strictly sorted pairs; for those, searching the run of
+     * the left glyph finds exactly what searching all pairs would. */
+    unsigned int count = pairs.len;
+    if (!count) return;
+    for (unsigned int i = 1; i < count; i++)
+      if (pairs[i - 1].cmp (pairs[i].get_pair ()) <= 0)
+	return;
+
+    hb_codepoint_t first = pairs[0].get_pair ().left;
+    hb_codepoint_t last = pairs[count - 1].get_pair ().left;
+    if (unlikely (!accel->pair_starts.resize (last - first + 2)))
+      return;
+
+    accel->first_left = first;
+    unsigned int j = 0;
+    for (hb_codepoint_t g = first; g <= last + 1; g++)
+    {
+      while (j < count && pairs[j].get_pair ().left < g)
+	j++;
+      accel->pair_starts[g - first] = j;
+    }
+  }
+
   bool apply (hb_aat_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -782,6 +824,15 @@ struct KerxSubTable
     }
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    switch (get_type ()) {
+    case 0:	u.format0.init_accelerator (accel, num_glyphs); return;
+    default:	return;
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -865,6 +916,22 @@ struct KerxTable
     return v;
   }
 
+  unsigned int get_subtable_count () const { return thiz()->tableCount; }
+
+  void init_accelerators (hb_aat_subtable_accelerator_t *accels,
+			  unsigned int count,
+			  unsigned int num_glyphs) const
+  {
+    typedef typename T::SubTable SubTable;
+
+    const SubTable *st = &thiz()->firstSubTable;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      st->init_accelerator (&accels[i], num_glyphs);
+      st = &StructAfter<SubTable> (*st);
+    }
+  }
+
   bool apply (AAT::hb_aat_apply_context_t *c) const
   {
     typedef typename T::SubTable SubTable;
@@ -977,6 +1044,8 @@ struct kerx : KerxTable<kerx>
 
   bool has_data () const { return version; }
 
+  typedef hb_aat_table_accelerator_t<kerx> accelerator_t;
+
   protected:
   HBUINT16	version;	/* The version number of the extended kerning table
 				 * (currently 2, 3, or 4). */
@@ -990,6 +1059,8 @@ struct kerx : KerxTable<kerx>
   DEFINE_SIZE_MIN (8);
 };
 
+struct kerx_accelerator_t : kerx::accelerator_t {};
+
 
 } /* namespace AAT */
 
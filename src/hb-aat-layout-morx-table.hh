@@ -167,12 +167,21 @@ struct RearrangementSubtable
 
     driver_context_t dc (this);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, c->subtable_accel);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    machine.init_accelerator (accel, num_glyphs,
+			      [] (const Entry<EntryData> &entry)
+			      { return bool (entry.flags & driver_context_t::Verb); },
+			      driver_context_t::DontAdvance);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -313,12 +322,26 @@ struct ContextualSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, c->subtable_accel);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    /* 'mort' substitution indices are offsets with no "none" value. */
+    machine.init_accelerator (accel, num_glyphs,
+			      [] (const Entry<EntryData> &entry)
+			      {
+				return !Types::extended ||
+				       entry.data.markIndex != 0xFFFF ||
+				       entry.data.currentIndex != 0xFFFF;
+			      },
+			      driver_context_t::DontAdvance);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -565,12 +588,21 @@ struct LigatureSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, c->subtable_accel);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    machine.init_accelerator (accel, num_glyphs,
+			      [] (const Entry<EntryData> &entry)
+			      { return LigatureEntryT::performAction (entry); },
+			      driver_context_t::DontAdvance);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -601,11 +633,14 @@ struct NoncontextualSubtable
 
     bool ret = false;
     unsigned int num_glyphs = c->face->get_num_glyphs ();
+    const hb_aat_subtable_accelerator_t *accel = c->subtable_accel;
 
     hb_glyph_info_t *info = c->buffer->info;
     unsigned int count = c->buffer->len;
     for (unsigned int i = 0; i < count; i++)
     {
+      if (accel && !accel->may_have (info[i].codepoint))
+	continue;
       const HBGlyphID *replacement = substitute.get_value (info[i].codepoint, num_glyphs);
       if (replacement)
       {
@@ -617,6 +652,16 @@ struct NoncontextualSubtable
     return_trace (ret);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    hb_set_t glyphs;
+    substitute.collect_glyphs_filtered (glyphs, num_glyphs,
+					[] (const HBGlyphID &) { return true; });
+    accel->digest.init (glyphs);
+    accel->skippable = true;
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -802,12 +847,24 @@ struct InsertionSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, c->subtable_accel);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    machine.init_accelerator (accel, num_glyphs,
+			      [] (const Entry<EntryData> &entry)
+			      {
+				return entry.data.currentInsertIndex != 0xFFFF ||
+				       entry.data.markedInsertIndex != 0xFFFF;
+			      },
+			      driver_context_t::DontAdvance);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -905,6 +962,19 @@ struct ChainSubtable
     return_trace (dispatch (c));
   }
 
+  void init_accelerator (hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    switch (get_type ()) {
+    case Rearrangement:	u.rearrangement.init_accelerator (accel, num_glyphs); return;
+    case Contextual:	u.contextual.init_accelerator (accel, num_glyphs); return;
+    case Ligature:	u.ligature.init_accelerator (accel, num_glyphs); return;
+    case Noncontextual:	u.noncontextual.init_accelerator (accel, num_glyphs); return;
+    case Insertion:	u.insertion.init_accelerator (accel, num_glyphs); return;
+    default:		return;
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -985,6 +1055,9 @@ struct Chain
 	  bool (subtable->get_coverage() & ChainSubtable<Types>::Vertical))
 	goto skip;
 
+      if (c->subtable_accel && !c->subtable_accel->may_apply (c->buffer))
+	goto skip;
+
       /* Buffer contents is always in logical direction.  Determine if
        * we need to reverse before applying this subtable.  We reverse
        * back after if we did reverse indeed.
@@ -1038,6 +1111,23 @@ struct Chain
     }
   }
 
+  unsigned int get_subtable_count () const { return subtableCount; }
+
+  /* Returns the number of accelerators used. */
+  unsigned int init_accelerators (hb_aat_subtable_accelerator_t *accels,
+				  unsigned int accel_count,
+				  unsigned int num_glyphs) const
+  {
+    const ChainSubtable<Types> *subtable = &StructAfter<ChainSubtable<Types>> (featureZ.as_array (featureCount));
+    unsigned int count = hb_min ((unsigned int) subtableCount, accel_count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      subtable->init_accelerator (&accels[i], num_glyphs);
+      subtable = &StructAfter<ChainSubtable<Types>> (*subtable);
+    }
+    return count;
+  }
+
   unsigned int get_size () const { return length; }
 
   bool sanitize (hb_sanitize_context_t *c, unsigned int version HB_UNUSED) const
@@ -1115,6 +1205,33 @@ struct mortmorx
     }
   }
 
+  void init_accelerators (hb_aat_subtable_accelerator_t *accels,
+			  unsigned int count,
+			  unsigned int num_glyphs) const
+  {
+    unsigned int index = 0;
+    const Chain<Types> *chain = &firstChain;
+    unsigned int chain_count = chainCount;
+    for (unsigned int i = 0; i < chain_count; i++)
+    {
+      index += chain->init_accelerators (accels + index, count - index, num_glyphs);
+      chain = &StructAfter<Chain<Types>> (*chain);
+    }
+  }
+
+  unsigned int get_subtable_count () const
+  {
+    unsigned int count = 0;
+    const Chain<Types> *chain = &firstChain;
+    unsigned int chain_count = chainCount;
+    for (unsigned int i = 0; i < chain_count; i++)
+    {
+      count += chain->get_subtable_count ();
+      chain = &StructAfter<Chain<Types>> (*chain);
+    }
+    return count;
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -1145,8 +1262,17 @@ struct mortmorx
   DEFINE_SIZE_MIN (8);
 };
 
-struct morx : mortmorx<ExtendedTypes, HB_AAT_TAG_morx> {};
-struct mort : mortmorx<ObsoleteTypes, HB_AAT_TAG_mort> {};
+struct morx : mortmorx<ExtendedTypes, HB_AAT_TAG_morx>
+{
+  typedef hb_aat_table_accelerator_t<morx> accelerator_t;
+};
+struct mort : mortmorx<ObsoleteTypes, HB_AAT_TAG_mort>
+{
+  typedef hb_aat_table_accelerator_t<mort> accelerator_t;
+};
+
+struct morx_accelerator_t : morx::accelerator_t {};
+struct mort_accelerator_t : mort::accelerator_t {};
 
 
 } /* namespace AAT */
@@ -1018,6 +1018,14 @@ struct hb_bitwise_sub
   operator () (const T &a, const T &b) const HB_AUTO_RETURN (a & ~b)
 }
 HB_FUNCOBJ (hb_bitwise_sub);
+struct hb_bitwise_lt
+{ HB_PARTIALIZE(2);
+  static constexpr bool passthru_left = false;
+  static constexpr bool passthru_right = true;
+  template <typename T> constexpr auto
+  operator () (const T &a, const T &b) const HB_AUTO_RETURN (~a & b)
+}
+HB_FUNCOBJ (hb_bitwise_lt);
 struct
 {
   template <typename T> constexpr auto
@@ -1083,6 +1091,25 @@ HB_FUNCOBJ (hb_dec);
 
 /* Compiler-assisted vectorization. */
 
+/* Width in bits of the native vectors hb_vector_size_t operations are done
+ * in, or 0 to use plain loops over its elements.  Chosen at compile-time
+ * from the instruction sets the compiler targets. */
+#ifndef HB_VECTOR_SIZE
+#  if !(defined(__GNUC__) || defined(__clang__))
+#    define HB_VECTOR_SIZE 0
+#  elif defined(__AVX2__)
+#    define HB_VECTOR_SIZE 256
+#  elif defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define HB_VECTOR_SIZE 128
+#  else
+#    define HB_VECTOR_SIZE 0
+#  endif
+#endif
+
+#if HB_VECTOR_SIZE
+typedef unsigned long long hb_vector_native_t __attribute__((vector_size (HB_VECTOR_SIZE / 8)));
+#endif
+
 /* Type behaving similar to vectorized vars defined using __attribute__((vector_size(...))),
  * basically a fixed-size bitset. */
 template <typename elt_t, unsigned int byte_size>
@@ -1097,6 +1124,14 @@ struct hb_vector_size_t
   hb_vector_size_t process (const Op& op) const
   {
     hb_vector_size_t r;
+#if HB_VECTOR_SIZE
+    if (native_count)
+    {
+      for (unsigned int i = 0; i < native_count; i++)
+	r.store_native (i, op (load_native (i)));
+      return r;
+    }
+#endif
     for (unsigned int i = 0; i < ARRAY_LENGTH (v); i++)
       r.v[i] = op (v[i]);
     return r;
@@ -1105,6 +1140,14 @@ struct hb_vector_size_t
   hb_vector_size_t process (const Op& op, const hb_vector_size_t &o) const
   {
     hb_vector_size_t r;
+#if HB_VECTOR_SIZE
+    if (native_count)
+    {
+      for (unsigned int i = 0; i < native_count; i++)
+	r.store_native (i, op (load_native (i), o.load_native (i)));
+      return r;
+    }
+#endif
     for (unsigned int i = 0; i < ARRAY_LENGTH (v); i++)
       r.v[i] = op (v[i], o.v[i]);
     return r;
@@ -1118,8 +1161,75 @@ struct hb_vector_size_t
   hb_vector_size_t operator ~ () const
   { return process (hb_bitwise_neg); }
 
+  bool is_zero () const
+  {
+#if HB_VECTOR_SIZE
+    if (native_count)
+    {
+      hb_vector_native_t acc = load_native (0);
+      for (unsigned int i = 1; i < native_count; i++)
+	acc |= load_native (i);
+      unsigned long long r = 0;
+      for (unsigned int j = 0; j < sizeof (acc) / sizeof (acc[0]); j++)
+	r |= acc[j];
+      return !r;
+    }
+#endif
+    for (unsigned int i = 0; i < ARRAY_LENGTH (v); i++)
+      if (v[i])
+	return false;
+    return true;
+  }
+
+  unsigned int get_population () const
+  {
+#if HB_VECTOR_SIZE && !defined(__POPCNT__) && !defined(__aarch64__)
+    /* Without a popcount instruction, count the bits of all lanes in
+     * parallel, accumulating per-byte counts; each byte takes at most
+     * 8 bits per native vector, so this is good for 31 of them. */
+    if (native_count && native_count < 32)
+    {
+      const hb_vector_native_t m1 = hb_vector_native_t () + 0x5555555555555555ULL;
+      const hb_vector_native_t m2 = hb_vector_native_t () + 0x3333333333333333ULL;
+      const hb_vector_native_t m4 = hb_vector_native_t () + 0x0F0F0F0F0F0F0F0FULL;
+      const hb_vector_native_t m8 = hb_vector_native_t () + 0x00FF00FF00FF00FFULL;
+      hb_vector_native_t acc = hb_vector_native_t ();
+      for (unsigned int i = 0; i < native_count; i++)
+      {
+	hb_vector_native_t x = load_native (i);
+	x = x - ((x >> 1) & m1);
+	x = (x & m2) + ((x >> 2) & m2);
+	acc += (x + (x >> 4)) & m4;
+      }
+      acc = (acc & m8) + ((acc >> 8) & m8);
+      unsigned int pop = 0;
+      for (unsigned int j = 0; j < sizeof (acc) / sizeof (acc[0]); j++)
+	pop += (acc[j] * 0x0001000100010001ULL) >> 48;
+      return pop;
+    }
+#endif
+    unsigned int pop = 0;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (v); i++)
+      pop += hb_popcount (v[i]);
+    return pop;
+  }
+
   private:
   static_assert (0 == byte_size % sizeof (elt_t), "");
+#if HB_VECTOR_SIZE
+  /* Storage is not necessarily aligned for the native vectors; go through
+   * memcpy, which compiles to unaligned loads and stores. */
+  static constexpr unsigned native_count = byte_size % sizeof (hb_vector_native_t) ? 0 :
+					   byte_size / sizeof (hb_vector_native_t);
+  hb_vector_native_t load_native (unsigned int i) const
+  {
+    hb_vector_native_t r;
+    memcpy (&r, (const char *) v + i * sizeof (r), sizeof (r));
+    return r;
+  }
+  void store_native (unsigned int i, const hb_vector_native_t &x)
+  { memcpy ((char *) v + i * sizeof (x), &x, sizeof (x)); }
+#endif
   elt_t v[byte_size / sizeof (elt_t)];
 };
 
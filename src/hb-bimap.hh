@@ -30,11 +30,129 @@
 #include "hb.hh"
 #include "hb-map.hh"
 
+/* Map over a bounded range of keys, like glyph ids: the values live in an
+ * array indexed by key, so lookups need no hashing and iteration is in key
+ * order.  The array grows to cover the largest key set. */
+struct hb_dense_map_t
+{
+  HB_DELETE_COPY_ASSIGN (hb_dense_map_t);
+  hb_dense_map_t ()  { init (); }
+  ~hb_dense_map_t () { fini (); }
+
+  unsigned int population;
+  hb_vector_t<hb_codepoint_t> items;
+
+  void init ()
+  {
+    population = 0;
+    items.init ();
+  }
+
+  void fini ()
+  {
+    population = 0;
+    items.fini ();
+  }
+
+  void reset ()
+  {
+    fini ();
+    init ();
+  }
+
+  bool in_error () const { return items.in_error (); }
+
+  /* Reserves room for keys below key_range. */
+  bool resize (unsigned int key_range)
+  {
+    unsigned int old_length = items.length;
+    if (key_range <= old_length) return !in_error ();
+    if (unlikely (!items.resize (key_range))) return false;
+    memset (items.arrayZ + old_length, 0xFF, (key_range - old_length) * sizeof (items[0]));
+    return true;
+  }
+
+  void set (hb_codepoint_t key, hb_codepoint_t value)
+  {
+    if (unlikely (key == HB_MAP_VALUE_INVALID)) return;
+    if (key >= items.length)
+    {
+      if (value == HB_MAP_VALUE_INVALID) return;
+      if (unlikely (!resize (key + 1))) return;
+    }
+    hb_codepoint_t &v = items.arrayZ[key];
+    if (v == HB_MAP_VALUE_INVALID) population++;
+    if (value == HB_MAP_VALUE_INVALID) population--;
+    v = value;
+  }
+
+  hb_codepoint_t get (hb_codepoint_t key) const
+  { return key < items.length ? items.arrayZ[key] : HB_MAP_VALUE_INVALID; }
+
+  void del (hb_codepoint_t key) { set (key, HB_MAP_VALUE_INVALID); }
+
+  /* Has interface. */
+  static constexpr hb_codepoint_t SENTINEL = HB_MAP_VALUE_INVALID;
+  typedef hb_codepoint_t value_t;
+  value_t operator [] (hb_codepoint_t k) const { return get (k); }
+  bool has (hb_codepoint_t k, hb_codepoint_t *vp = nullptr) const
+  {
+    hb_codepoint_t v = get (k);
+    if (vp) *vp = v;
+    return v != SENTINEL;
+  }
+  /* Projection. */
+  hb_codepoint_t operator () (hb_codepoint_t k) const { return get (k); }
+
+  void clear ()
+  {
+    if (items.length)
+      memset (items.arrayZ, 0xFF, items.length * sizeof (items[0]));
+    population = 0;
+  }
+
+  bool is_empty () const { return population == 0; }
+
+  unsigned int get_population () const { return population; }
+
+  /*
+   * Iterator
+   */
+  static bool is_real (hb_codepoint_t v) { return v != HB_MAP_VALUE_INVALID; }
+  static hb_pair_t<hb_codepoint_t, hb_codepoint_t>
+  get_pair (hb_pair_t<unsigned int, const hb_codepoint_t &> p)
+  { return hb_pair_t<hb_codepoint_t, hb_codepoint_t> (p.first, p.second); }
+
+  auto iter () const HB_AUTO_RETURN
+  (
+    + hb_zip (hb_range (items.length), hb_iter (items))
+    | hb_filter (&hb_dense_map_t::is_real, hb_second)
+    | hb_map (&hb_dense_map_t::get_pair)
+  )
+  auto keys () const HB_AUTO_RETURN
+  (
+    + hb_zip (hb_range (items.length), hb_iter (items))
+    | hb_filter (&hb_dense_map_t::is_real, hb_second)
+    | hb_map (hb_first)
+  )
+  auto values () const HB_AUTO_RETURN
+  (
+    + hb_iter (items)
+    | hb_filter (&hb_dense_map_t::is_real)
+    | hb_map (hb_ridentity)
+  )
+
+  /* Sink interface. */
+  hb_dense_map_t& operator << (const hb_pair_t<hb_codepoint_t, hb_codepoint_t>& v)
+  { set (v.first, v.second); return *this; }
+};
+
 /* Bi-directional map */
-struct hb_bimap_t
+template <typename map_t>
+struct hb_bimap_impl_t
 {
-  hb_bimap_t () { init (); }
-  ~hb_bimap_t () { fini (); }
+  hb_bimap_impl_t () { init (); }
+  ~hb_bimap_impl_t () { fini (); }
 
   void init ()
   {
@@ -56,6 +174,10 @@ struct hb_bimap_t
 
   bool in_error () const { return forw_map.in_error () || back_map.in_error (); }
 
+  /* Reserves room for the expected lhs and rhs values. */
+  bool resize (unsigned int lhs_range, unsigned int rhs_range)
+  { return forw_map.resize (lhs_range) && back_map.resize (rhs_range); }
+
   void set (hb_codepoint_t lhs, hb_codepoint_t rhs)
   {
     if (unlikely (lhs == HB_MAP_VALUE_INVALID)) return;
@@ -86,11 +208,24 @@ struct hb_bimap_t
 
   unsigned int get_population () const { return forw_map.get_population (); }
 
+  const map_t &forward_map () const { return forw_map; }
+  const map_t &backward_map () const { return back_map; }
+
+  /* Sink interface. */
+  hb_bimap_impl_t& operator << (const hb_pair_t<hb_codepoint_t, hb_codepoint_t>& v)
+  { set (v.first, v.second); return *this; }
+
   protected:
-  hb_map_t  forw_map;
-  hb_map_t  back_map;
+  map_t  forw_map;
+  map_t  back_map;
 };
 
+typedef hb_bimap_impl_t<hb_map_t> hb_bimap_t;
+
+/* Bimap between glyph ids, which are bounded by the font's num_glyphs:
+ * both directions are dense arrays. */
+typedef hb_bimap_impl_t<hb_dense_map_t> hb_glyph_bimap_t;
+
 /* Inremental bimap: only lhs is given, rhs is incrementally assigned */
 struct hb_inc_bimap_t : hb_bimap_t
 {
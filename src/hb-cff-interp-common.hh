@@ -370,7 +370,10 @@ struct byte_str_ref_t
 
 typedef hb_vector_t<byte_str_t> byte_str_array_t;
 
-/* stack */
+/* stack
+ *
+ * Elements are stored inline, such that setting up an interpreter
+ * environment for a charstring does not allocate. */
 template <typename ELEM, int LIMIT>
 struct cff_stack_t
 {
@@ -378,29 +381,35 @@ struct cff_stack_t
   {
     error = false;
     count = 0;
-    elements.init ();
-    elements.resize (kSizeLimit);
-    for (unsigned int i = 0; i < elements.length; i++)
+    for (unsigned int i = 0; i < kSizeLimit; i++)
       elements[i].init ();
   }
-  void fini () { elements.fini_deep (); }
+  void fini ()
+  {
+    for (unsigned int i = 0; i < kSizeLimit; i++)
+      elements[i].fini ();
+  }
 
   ELEM& operator [] (unsigned int i)
   {
-    if (unlikely (i >= count)) set_error ();
+    if (unlikely (i >= count))
+    {
+      set_error ();
+      if (unlikely (i >= kSizeLimit)) return Crap (ELEM);
+    }
     return elements[i];
   }
 
   void push (const ELEM &v)
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       elements[count++] = v;
     else
       set_error ();
   }
   ELEM &push ()
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       return elements[count++];
     else
     {
@@ -429,7 +438,7 @@ struct cff_stack_t
 
   const ELEM& peek ()
   {
-    if (unlikely (count < 0))
+    if (unlikely (!count))
     {
       set_error ();
       return Null (ELEM);
@@ -439,7 +448,7 @@ struct cff_stack_t
 
   void unpop ()
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       count++;
     else
       set_error ();
@@ -447,7 +456,7 @@ struct cff_stack_t
 
   void clear () { count = 0; }
 
-  bool in_error () const { return (error || elements.in_error ()); }
+  bool in_error () const { return error; }
   void set_error ()      { error = true; }
 
   unsigned int get_count () const { return count; }
@@ -458,7 +467,7 @@ struct cff_stack_t
   protected:
   bool error;
   unsigned int count;
-  hb_vector_t<ELEM> elements;
+  ELEM elements[LIMIT];
 };
 
 /* argument stack */
@@ -514,7 +523,7 @@ struct arg_stack_t : cff_stack_t<ARG, 513>
   }
 
   hb_array_t<const ARG> get_subarray (unsigned int start) const
-  { return S::elements.sub_array (start); }
+  { return hb_array (S::elements).sub_array (start); }
 
   private:
   typedef cff_stack_t<ARG, 513> S;
@@ -37,8 +37,12 @@ typedef biased_subrs_t<CFF1Subrs>   cff1_biased_subrs_t;
 
 struct cff1_cs_interp_env_t : cs_interp_env_t<number_t, CFF1Subrs>
 {
+  /* CFF1 charstrings don't vary; coords are accepted for symmetry with
+   * cff2_cs_interp_env_t and ignored. */
   template <typename ACC>
-  void init (const byte_str_t &str, ACC &acc, unsigned int fd)
+  void init (const byte_str_t &str, ACC &acc, unsigned int fd,
+	     const int *coords_ HB_UNUSED = nullptr,
+	     unsigned int num_coords_ HB_UNUSED = 0)
   {
     SUPER::init (str, acc.globalSubrs, acc.privateDicts[fd].localSubrs);
     processed_width = false;
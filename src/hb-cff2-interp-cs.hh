@@ -38,6 +38,7 @@ struct blend_arg_t : number_t
   void init ()
   {
     number_t::init ();
+    numValues = valueIndex = numBlends = 0;
     deltas.init ();
   }
 
@@ -51,25 +52,36 @@ struct blend_arg_t : number_t
   void set_fixed (int32_t v) { reset_blends (); number_t::set_fixed (v); }
   void set_real (double v) { reset_blends (); number_t::set_real (v); }
 
+  /* Marks this value as the valueIndex'th of numValues blended ones.
+   * The deltas themselves are only kept if blends_ is given; otherwise
+   * they were either folded into the value already or are not needed. */
   void set_blends (unsigned int numValues_, unsigned int valueIndex_,
-			  unsigned int numBlends, hb_array_t<const blend_arg_t> blends_)
+		   unsigned int numBlends_,
+		   hb_array_t<const blend_arg_t> blends_ = hb_array_t<const blend_arg_t> ())
   {
     numValues = numValues_;
     valueIndex = valueIndex_;
+    numBlends = numBlends_;
+    if (!blends_.length)
+    {
+      deltas.resize (0);
+      return;
+    }
     deltas.resize (numBlends);
     for (unsigned int i = 0; i < numBlends; i++)
       deltas[i] = blends_[i];
   }
 
-  bool blending () const { return deltas.length > 0; }
+  bool blending () const { return numBlends > 0; }
   void reset_blends ()
   {
-    numValues = valueIndex = 0;
+    numValues = valueIndex = numBlends = 0;
     deltas.resize (0);
   }
 
   unsigned int numValues;
   unsigned int valueIndex;
+  unsigned int numBlends;
   hb_vector_t<number_t> deltas;
 };
 
@@ -80,23 +92,23 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
 {
   template <typename ACC>
   void init (const byte_str_t &str, ACC &acc, unsigned int fd,
-	     const int *coords_=nullptr, unsigned int num_coords_=0)
+	     const int *coords_=nullptr, unsigned int num_coords_=0,
+	     const float *region_scalars_=nullptr)
   {
     SUPER::init (str, acc.globalSubrs, acc.privateDicts[fd].localSubrs);
 
     coords = coords_;
     num_coords = num_coords_;
+    region_scalars = region_scalars_;
     varStore = acc.varStore;
     seen_blend = false;
     seen_vsindex_ = false;
-    scalars.init ();
     do_blend = num_coords && coords && varStore->size;
     set_ivs (acc.privateDicts[fd].ivs);
   }
 
   void fini ()
   {
-    scalars.fini ();
     SUPER::fini ();
   }
 
@@ -131,11 +143,20 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
     if (!seen_blend)
     {
       region_count = varStore->varStore.get_region_index_count (get_ivs ());
+      /* More regions than fit on the stack can never be blended. */
+      if (unlikely (region_count > ARRAY_LENGTH (scalars)))
+	do_blend = false;
       if (do_blend)
       {
-	scalars.resize (region_count);
-	varStore->varStore.get_scalars (get_ivs (), coords, num_coords,
-					&scalars[0], region_count);
+	/* Pick the scalars from the ones evaluated for the font if we have
+	 * them, instead of evaluating the regions once more. */
+	if (region_scalars)
+	  varStore->varStore.get_scalars (get_ivs (),
+					  region_scalars, varStore->varStore.get_region_count (),
+					  scalars, region_count);
+	else
+	  varStore->varStore.get_scalars (get_ivs (), coords, num_coords,
+					  scalars, region_count);
       }
       seen_blend = true;
     }
@@ -161,31 +182,45 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
   void	 set_ivs (unsigned int ivs_) { ivs = ivs_; }
   bool	 seen_vsindex () const { return seen_vsindex_; }
 
+  /* Sets the valueIndex'th of numValues values to blend at the current
+   * location, with deltas being its numBlends deltas.  When blending, the
+   * deltas are folded in right away; otherwise they are only copied for
+   * keep_deltas, as their values are not otherwise needed. */
+  void set_blends (blend_arg_t &arg,
+		   unsigned int numValues, unsigned int valueIndex,
+		   hb_array_t<const blend_arg_t> deltas,
+		   bool keep_deltas)
+  {
+    if (do_blend)
+    {
+      double v = arg.to_real ();
+      for (unsigned int i = 0; i < deltas.length; i++)
+	v += (double) scalars[i] * deltas[i].to_real ();
+      arg.set_real (v);
+      arg.set_blends (numValues, valueIndex, deltas.length);
+    }
+    else if (keep_deltas)
+      arg.set_blends (numValues, valueIndex, deltas.length, deltas);
+    else
+      arg.set_blends (numValues, valueIndex, deltas.length);
+  }
+
   protected:
   void blend_arg (blend_arg_t &arg)
   {
+    /* Deltas were folded in by set_blends () already. */
     if (do_blend && arg.blending ())
-    {
-      if (likely (scalars.length == arg.deltas.length))
-      {
-	double v = arg.to_real ();
-	for (unsigned int i = 0; i < scalars.length; i++)
-	{
-	  v += (double)scalars[i] * arg.deltas[i].to_real ();
-	}
-	arg.set_real (v);
-	arg.deltas.resize (0);
-      }
-    }
+      arg.numBlends = 0;
   }
 
   protected:
   const int     *coords;
   unsigned int  num_coords;
+  const float	*region_scalars;
   const	 CFF2VariationStore *varStore;
   unsigned int  region_count;
   unsigned int  ivs;
-  hb_vector_t<float>  scalars;
+  float		scalars[arg_stack_t<blend_arg_t>::kSizeLimit];
   bool	  do_blend;
   bool	  seen_vsindex_;
   bool	  seen_blend;
@@ -195,6 +230,10 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
 template <typename OPSET, typename PARAM, typename PATH=path_procs_null_t<cff2_cs_interp_env_t, PARAM>>
 struct cff2_cs_opset_t : cs_opset_t<blend_arg_t, OPSET, cff2_cs_interp_env_t, PARAM, PATH>
 {
+  /* Whether blended values need their deltas, as opposed to just being
+   * blended at the current location.  Only true for re-encoding them. */
+  static constexpr bool keep_blend_deltas = false;
+
   static void process_op (op_code_t op, cff2_cs_interp_env_t &env, PARAM& param)
   {
     switch (op) {
@@ -244,8 +283,8 @@ struct cff2_cs_opset_t : cs_opset_t<blend_arg_t, OPSET, cff2_cs_interp_env_t, PA
     }
     for (unsigned int i = 0; i < n; i++)
     {
-      const hb_array_t<const blend_arg_t>	blends = env.argStack.get_subarray (start + n + (i * k));
-      env.argStack[start + i].set_blends (n, i, k, blends);
+      const hb_array_t<const blend_arg_t>	blends = env.argStack.get_subarray (start + n + (i * k)).sub_array (0, k);
+      env.set_blends (env.argStack[start + i], n, i, blends, OPSET::keep_blend_deltas);
     }
 
     /* pop off blend values leaving default values now adorned with blend values */
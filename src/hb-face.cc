@@ -629,32 +629,112 @@ _hb_face_builder_data_destroy (void *user_data)
   free (data);
 }
 
-static hb_blob_t *
-_hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
+static unsigned int
+_hb_face_builder_data_get_length (hb_face_builder_data_t *data)
 {
-
   unsigned int table_count = data->tables.length;
   unsigned int face_length = table_count * 16 + 12;
 
   for (unsigned int i = 0; i < table_count; i++)
     face_length += hb_ceil_to_4 (hb_blob_get_length (data->tables[i].blob));
 
-  char *buf = (char *) malloc (face_length);
-  if (unlikely (!buf))
-    return nullptr;
+  return face_length;
+}
+
+static bool
+_hb_face_builder_data_write (hb_face_t *face,
+			     hb_face_builder_data_t *data,
+			     hb_face_builder_write_func_t func,
+			     void *user_data)
+{
+  if (unlikely (data->tables.in_error ())) return false;
+
+  unsigned int table_count = data->tables.length;
+  unsigned int dir_length = table_count * 16 + 12;
 
-  hb_serialize_context_t c (buf, face_length);
-  c.propagate_error (data->tables);
+  /* Only the directory is assembled here; table data is handed to
+   * @func straight out of the table blobs. */
+  hb_vector_t<char> dir;
+  if (unlikely (!dir.resize (dir_length))) return false;
+
+  hb_serialize_context_t c (dir.arrayZ, dir_length);
   OT::OpenTypeFontFile *f = c.start_serialize<OT::OpenTypeFontFile> ();
 
   bool is_cff = data->tables.lsearch (HB_TAG ('C','F','F',' ')) || data->tables.lsearch (HB_TAG ('C','F','F','2'));
   hb_tag_t sfnt_tag = is_cff ? OT::OpenTypeFontFile::CFFTag : OT::OpenTypeFontFile::TrueTypeTag;
 
-  bool ret = f->serialize_single (&c, sfnt_tag, data->tables.as_array ());
+  uint32_t checksum_adjustment = 0;
+  bool ret = f->serialize_single_directory (&c, sfnt_tag, data->tables.as_array (), &checksum_adjustment);
 
   c.end_serialize ();
+  ret = ret && !c.in_error ();
+  if (unlikely (!ret)) return false;
+
+  if (unlikely (!func (face, dir.arrayZ, dir_length, user_data)))
+    return false;
+
+  static const char padding[4] = {0};
+  for (unsigned int i = 0; i < table_count; i++)
+  {
+    hb_blob_t *blob = data->tables[i].blob;
+    const char *table = blob->data;
+    unsigned int length = blob->length;
+
+    if (data->tables[i].tag == HB_OT_TAG_head &&
+	length >= OT::head::static_size)
+    {
+      OT::head h = *(const OT::head *) table;
+      h.set_checksum_adjustment (checksum_adjustment);
+      if (unlikely (!func (face, (const char *) &h, OT::head::static_size, user_data)))
+	return false;
+      table += OT::head::static_size;
+      length -= OT::head::static_size;
+    }
+
+    if (length && unlikely (!func (face, table, length, user_data)))
+      return false;
+
+    unsigned int pad = hb_ceil_to_4 (blob->length) - blob->length;
+    if (pad && unlikely (!func (face, padding, pad, user_data)))
+      return false;
+  }
+
+  return true;
+}
+
+struct hb_face_builder_buffer_t
+{
+  char *buffer;
+  unsigned int size;
+  unsigned int pos;
+};
+
+static hb_bool_t
+_hb_face_builder_write_to_buffer (hb_face_t *face HB_UNUSED,
+				  const char *data,
+				  unsigned int length,
+				  void *user_data)
+{
+  hb_face_builder_buffer_t *out = (hb_face_builder_buffer_t *) user_data;
+  if (unlikely (length > out->size - out->pos))
+    return false;
+
+  memcpy (out->buffer + out->pos, data, length);
+  out->pos += length;
+  return true;
+}
+
+static hb_blob_t *
+_hb_face_builder_data_reference_blob (hb_face_t *face, hb_face_builder_data_t *data)
+{
+  unsigned int face_length = _hb_face_builder_data_get_length (data);
 
-  if (unlikely (!ret))
+  char *buf = (char *) malloc (face_length);
+  if (unlikely (!buf))
+    return nullptr;
+
+  hb_face_builder_buffer_t out = {buf, face_length, 0};
+  if (unlikely (!_hb_face_builder_data_write (face, data, _hb_face_builder_write_to_buffer, &out)))
   {
     free (buf);
     return nullptr;
@@ -664,12 +744,12 @@ _hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
 }
 
 static hb_blob_t *
-_hb_face_builder_reference_table (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data)
+_hb_face_builder_reference_table (hb_face_t *face, hb_tag_t tag, void *user_data)
 {
   hb_face_builder_data_t *data = (hb_face_builder_data_t *) user_data;
 
   if (!tag)
-    return _hb_face_builder_data_reference_blob (data);
+    return _hb_face_builder_data_reference_blob (face, data);
 
   hb_face_builder_data_t::table_entry_t *entry = data->tables.lsearch (tag);
   if (entry)
@@ -723,3 +803,80 @@ hb_face_builder_add_table (hb_face_t *face, hb_tag_t tag, hb_blob_t *blob)
 
   return true;
 }
+
+/**
+ * hb_face_builder_get_serialized_length:
+ * @face: a face created using hb_face_builder_create().
+ *
+ * Returns the size in bytes of the binary font file that
+ * hb_face_builder_serialize() would write for @face, including
+ * the table directory and padding.
+ *
+ * Return value: font file length, or zero if @face is not a builder face.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_builder_get_serialized_length (hb_face_t *face)
+{
+  if (unlikely (face->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy))
+    return 0;
+
+  hb_face_builder_data_t *data = (hb_face_builder_data_t *) face->user_data;
+  return _hb_face_builder_data_get_length (data);
+}
+
+/**
+ * hb_face_builder_serialize:
+ * @face: a face created using hb_face_builder_create().
+ * @func: (scope call): function to write data with.
+ * @user_data: data to pass to @func.
+ *
+ * Compiles the tables added to @face into a binary font file and
+ * passes it to @func piece by piece, in file order.  Unlike
+ * hb_face_reference_blob(), no contiguous copy of the font file is
+ * made; table data is passed straight from the added table blobs.
+ * The table directory, table checksums and head.checkSumAdjustment
+ * are computed up front.
+ *
+ * Return value: %true if the font was written in full, %false if
+ * @face is not a builder face or @func returned %false.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_face_builder_serialize (hb_face_t *face,
+			   hb_face_builder_write_func_t func,
+			   void *user_data)
+{
+  if (unlikely (face->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy))
+    return false;
+
+  hb_face_builder_data_t *data = (hb_face_builder_data_t *) face->user_data;
+  return _hb_face_builder_data_write (face, data, func, user_data);
+}
+
+/**
+ * hb_face_builder_serialize_to_buffer:
+ * @face: a face created using hb_face_builder_create().
+ * @buffer: (array length=buffer_size): buffer to write the font file to.
+ * @buffer_size: size of @buffer in bytes.
+ *
+ * Compiles the tables added to @face into a binary font file in the
+ * caller-provided @buffer, which must be at least
+ * hb_face_builder_get_serialized_length() bytes long.
+ *
+ * Return value: number of bytes written, or zero on failure.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_builder_serialize_to_buffer (hb_face_t *face,
+				     char *buffer,
+				     unsigned int buffer_size)
+{
+  hb_face_builder_buffer_t out = {buffer, buffer_size, 0};
+  if (unlikely (!hb_face_builder_serialize (face, _hb_face_builder_write_to_buffer, &out)))
+    return 0;
+  return out.pos;
+}
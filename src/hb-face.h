@@ -152,6 +152,35 @@ hb_face_builder_add_table (hb_face_t *face,
 			   hb_tag_t   tag,
 			   hb_blob_t *blob);
 
+/**
+ * hb_face_builder_write_func_t:
+ * @face: the builder face being serialized.
+ * @data: (array length=length): next chunk of the font file.
+ * @length: length of @data in bytes.
+ * @user_data: user data passed to hb_face_builder_serialize().
+ *
+ * Return value: %true to continue writing, %false to abort.
+ *
+ * Since: REPLACEME
+ **/
+typedef hb_bool_t (*hb_face_builder_write_func_t) (hb_face_t  *face,
+						   const char *data,
+						   unsigned int length,
+						   void       *user_data);
+
+HB_EXTERN unsigned int
+hb_face_builder_get_serialized_length (hb_face_t *face);
+
+HB_EXTERN hb_bool_t
+hb_face_builder_serialize (hb_face_t *face,
+			   hb_face_builder_write_func_t func,
+			   void *user_data);
+
+HB_EXTERN unsigned int
+hb_face_builder_serialize_to_buffer (hb_face_t *face,
+				     char *buffer,
+				     unsigned int buffer_size);
+
 
 HB_END_DECLS
 
@@ -339,6 +339,46 @@ hb_font_get_glyph_v_origin_default (hb_font_t *font,
   return ret;
 }
 
+#define hb_font_get_glyph_v_origins_nil hb_font_get_glyph_v_origins_default
+static unsigned int
+hb_font_get_glyph_v_origins_default (hb_font_t *font,
+				     void *font_data HB_UNUSED,
+				     unsigned int count,
+				     const hb_codepoint_t *first_glyph,
+				     unsigned int glyph_stride,
+				     hb_position_t *first_x,
+				     unsigned int x_stride,
+				     hb_position_t *first_y,
+				     unsigned int y_stride,
+				     void *user_data HB_UNUSED)
+{
+  if (font->has_glyph_v_origin_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (!font->get_glyph_v_origin (*first_glyph, first_x, first_y))
+	return i;
+
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+      first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+    }
+    return count;
+  }
+
+  unsigned int ret = font->parent->get_glyph_v_origins (count,
+							 first_glyph, glyph_stride,
+							 first_x, x_stride,
+							 first_y, y_stride);
+  for (unsigned int i = 0; i < ret; i++)
+  {
+    font->parent_scale_position (first_x, first_y);
+    first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+    first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+  }
+  return ret;
+}
+
 static hb_position_t
 hb_font_get_glyph_h_kerning_nil (hb_font_t *font HB_UNUSED,
 				 void *font_data HB_UNUSED,
@@ -404,6 +444,39 @@ hb_font_get_glyph_extents_default (hb_font_t *font,
   return ret;
 }
 
+#define hb_font_get_glyph_extents_batch_nil hb_font_get_glyph_extents_batch_default
+static void
+hb_font_get_glyph_extents_batch_default (hb_font_t *font,
+					 void *font_data HB_UNUSED,
+					 unsigned int count,
+					 const hb_codepoint_t *first_glyph,
+					 unsigned int glyph_stride,
+					 hb_glyph_extents_t *first_extents,
+					 unsigned int extents_stride,
+					 void *user_data HB_UNUSED)
+{
+  if (font->has_glyph_extents_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      font->get_glyph_extents (*first_glyph, first_extents);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+    }
+    return;
+  }
+
+  font->parent->get_glyph_extents_batch (count,
+					 first_glyph, glyph_stride,
+					 first_extents, extents_stride);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    font->parent_scale_position (&first_extents->x_bearing, &first_extents->y_bearing);
+    font->parent_scale_distance (&first_extents->width, &first_extents->height);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+}
+
 static hb_bool_t
 hb_font_get_glyph_contour_point_nil (hb_font_t *font HB_UNUSED,
 				     void *font_data HB_UNUSED,
@@ -954,6 +1027,40 @@ hb_font_get_glyph_v_origin (hb_font_t *font,
   return font->get_glyph_v_origin (glyph, x, y);
 }
 
+/**
+ * hb_font_get_glyph_v_origins:
+ * @font: a font.
+ * @count: number of glyphs.
+ * @first_glyph: first glyph to get the origin of.
+ * @glyph_stride: distance in bytes between consecutive glyphs.
+ * @first_x: (out): first origin x coordinate to fill in.
+ * @x_stride: distance in bytes between consecutive x coordinates.
+ * @first_y: (out): first origin y coordinate to fill in.
+ * @y_stride: distance in bytes between consecutive y coordinates.
+ *
+ * Fetches the vertical origins of @count glyphs, as hb_font_get_glyph_v_origin()
+ * would one by one, stopping at the first glyph that has none.
+ *
+ * Return value: the number of leading glyphs whose origin was fetched.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_get_glyph_v_origins (hb_font_t *font,
+			     unsigned int count,
+			     const hb_codepoint_t *first_glyph,
+			     unsigned int glyph_stride,
+			     hb_position_t *first_x,
+			     unsigned int x_stride,
+			     hb_position_t *first_y,
+			     unsigned int y_stride)
+{
+  return font->get_glyph_v_origins (count,
+				    first_glyph, glyph_stride,
+				    first_x, x_stride,
+				    first_y, y_stride);
+}
+
 /**
  * hb_font_get_glyph_h_kerning:
  * @font: a font.
@@ -1015,6 +1122,31 @@ hb_font_get_glyph_extents (hb_font_t *font,
   return font->get_glyph_extents (glyph, extents);
 }
 
+/**
+ * hb_font_get_glyph_extents_batch:
+ * @font: a font.
+ * @count: number of glyphs.
+ * @first_glyph: first glyph to get extents for.
+ * @glyph_stride: distance in bytes between consecutive glyphs.
+ * @first_extents: (out): first extents to fill in.
+ * @extents_stride: distance in bytes between consecutive extents.
+ *
+ * Fetches the extents of @count glyphs, as hb_font_get_glyph_extents() would
+ * one by one.  Extents of glyphs for which none are available are zero.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_get_glyph_extents_batch (hb_font_t *font,
+				 unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned glyph_stride,
+				 hb_glyph_extents_t *first_extents,
+				 unsigned extents_stride)
+{
+  font->get_glyph_extents_batch (count, first_glyph, glyph_stride, first_extents, extents_stride);
+}
+
 /**
  * hb_font_get_glyph_contour_point:
  * @font: a font.
@@ -1400,6 +1532,8 @@ _hb_font_adopt_var_coords (hb_font_t *font,
   font->coords = coords;
   font->design_coords = design_coords;
   font->num_coords = coords_length;
+
+  font->drop_ot_cache ();
 }
 
 /**
@@ -1508,6 +1642,7 @@ hb_font_destroy (hb_font_t *font)
 
   free (font->coords);
   free (font->design_coords);
+  font->drop_ot_cache ();
 
   free (font);
 }
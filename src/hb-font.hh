@@ -51,9 +51,11 @@
   HB_FONT_FUNC_IMPLEMENT (glyph_v_advances) \
   HB_FONT_FUNC_IMPLEMENT (glyph_h_origin) \
   HB_FONT_FUNC_IMPLEMENT (glyph_v_origin) \
+  HB_FONT_FUNC_IMPLEMENT (glyph_v_origins) \
   HB_FONT_FUNC_IMPLEMENT (glyph_h_kerning) \
   HB_IF_NOT_DEPRECATED (HB_FONT_FUNC_IMPLEMENT (glyph_v_kerning)) \
   HB_FONT_FUNC_IMPLEMENT (glyph_extents) \
+  HB_FONT_FUNC_IMPLEMENT (glyph_extents_batch) \
   HB_FONT_FUNC_IMPLEMENT (glyph_contour_point) \
   HB_FONT_FUNC_IMPLEMENT (glyph_name) \
   HB_FONT_FUNC_IMPLEMENT (glyph_from_name) \
@@ -100,6 +102,9 @@ DECLARE_NULL_INSTANCE (hb_font_funcs_t);
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
 
+struct hb_ot_font_cache_t;
+HB_INTERNAL void hb_ot_font_cache_destroy (hb_ot_font_cache_t *cache);
+
 struct hb_font_t
 {
   hb_object_header_t header;
@@ -126,6 +131,10 @@ struct hb_font_t
   void              *user_data;
   hb_destroy_func_t  destroy;
 
+  /* Values the OpenType tables derived from the scale and coords;
+   * see hb-ot-font-cache.hh. */
+  hb_atomic_ptr_t<hb_ot_font_cache_t> ot_cache;
+
   hb_shaper_object_dataset_t<hb_font_t> data; /* Various shaper data. */
 
 
@@ -304,6 +313,22 @@ struct hb_font_t
 					klass->user_data.glyph_v_origin);
   }
 
+  unsigned int get_glyph_v_origins (unsigned int count,
+				    const hb_codepoint_t *first_glyph,
+				    unsigned int glyph_stride,
+				    hb_position_t *first_x,
+				    unsigned int x_stride,
+				    hb_position_t *first_y,
+				    unsigned int y_stride)
+  {
+    return klass->get.f.glyph_v_origins (this, user_data,
+					 count,
+					 first_glyph, glyph_stride,
+					 first_x, x_stride,
+					 first_y, y_stride,
+					 klass->user_data.glyph_v_origins);
+  }
+
   hb_position_t get_glyph_h_kerning (hb_codepoint_t left_glyph,
 				     hb_codepoint_t right_glyph)
   {
@@ -338,6 +363,19 @@ struct hb_font_t
 				       klass->user_data.glyph_extents);
   }
 
+  void get_glyph_extents_batch (unsigned int count,
+				const hb_codepoint_t *first_glyph,
+				unsigned int glyph_stride,
+				hb_glyph_extents_t *first_extents,
+				unsigned int extents_stride)
+  {
+    return klass->get.f.glyph_extents_batch (this, user_data,
+					     count,
+					     first_glyph, glyph_stride,
+					     first_extents, extents_stride,
+					     klass->user_data.glyph_extents_batch);
+  }
+
   hb_bool_t get_glyph_contour_point (hb_codepoint_t glyph, unsigned int point_index,
 					    hb_position_t *x, hb_position_t *y)
   {
@@ -615,6 +653,14 @@ struct hb_font_t
     signed upem = face->get_upem ();
     x_mult = ((int64_t) x_scale << 16) / upem;
     y_mult = ((int64_t) y_scale << 16) / upem;
+
+    drop_ot_cache ();
+  }
+
+  void drop_ot_cache ()
+  {
+    hb_ot_font_cache_destroy (ot_cache.get_relaxed ());
+    ot_cache.set_relaxed (nullptr);
   }
 
   hb_position_t em_mult (int16_t v, int64_t mult)
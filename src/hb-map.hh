@@ -50,33 +50,65 @@ struct hb_hashmap_t
   {
     K key;
     V value;
-    uint32_t hash;
 
-    void clear () { key = kINVALID; value = vINVALID; hash = 0; }
+    void clear () { key = kINVALID; value = vINVALID; }
 
     bool operator == (K o) { return hb_deref (key) == hb_deref (o); }
     bool operator == (const item_t &o) { return *this == o.key; }
-    bool is_unused () const    { return key == kINVALID; }
-    bool is_tombstone () const { return key != kINVALID && value == vINVALID; }
     bool is_real () const { return key != kINVALID && value != vINVALID; }
     hb_pair_t<K, V> get_pair() const { return hb_pair_t<K, V> (key, value); }
   };
 
+  /* Each item has a control byte: EMPTY, DELETED, or seven bits of the
+   * item's hash when in use.  Lookups scan the control bytes of a group of
+   * items at once, and only compare keys whose hash bits match. */
+  enum { EMPTY = 0x80, DELETED = 0xFE };
+  static bool is_full (uint8_t c) { return !(c & 0x80); }
+
+  struct group_t
+  {
+    enum { SIZE = 8 };
+
+    /* Compilers turn this into a single load on little-endian machines. */
+    group_t (const uint8_t *c) :
+      w ((uint64_t) c[0]       | (uint64_t) c[1] <<  8 |
+	 (uint64_t) c[2] << 16 | (uint64_t) c[3] << 24 |
+	 (uint64_t) c[4] << 32 | (uint64_t) c[5] << 40 |
+	 (uint64_t) c[6] << 48 | (uint64_t) c[7] << 56) {}
+
+    /* Each returns a mask with the high bit of each matching byte set. */
+    uint64_t match (uint8_t h2) const
+    {
+      /* May report a byte following a true match as matching; callers
+       * compare keys anyway. */
+      uint64_t x = w ^ (LSBS * h2);
+      return (x - LSBS) & ~x & MSBS;
+    }
+    uint64_t match_empty () const { return w & ~(w << 6) & MSBS; }
+    uint64_t match_empty_or_deleted () const { return w & ~(w << 7) & MSBS; }
+
+    static unsigned int first (uint64_t m) { return hb_ctz (m) / 8; }
+
+    static constexpr uint64_t LSBS = 0x0101010101010101ull;
+    static constexpr uint64_t MSBS = 0x8080808080808080ull;
+    uint64_t w;
+  };
+
   hb_object_header_t header;
   bool successful; /* Allocations successful */
   unsigned int population; /* Not including tombstones. */
   unsigned int occupancy; /* Including tombstones. */
   unsigned int mask;
-  unsigned int prime;
   item_t *items;
+  uint8_t *ctrl; /* Allocated together with items. */
 
   void init_shallow ()
   {
     successful = true;
     population = occupancy = 0;
     mask = 0;
-    prime = 0;
     items = nullptr;
+    ctrl = nullptr;
   }
   void init ()
   {
@@ -87,6 +119,8 @@ struct hb_hashmap_t
   {
     free (items);
     items = nullptr;
+    ctrl = nullptr;
+    mask = 0;
     population = occupancy = 0;
   }
   void fini ()
@@ -105,13 +139,17 @@ struct hb_hashmap_t
 
   bool in_error () const { return !successful; }
 
-  bool resize ()
+  /* Makes room for at least new_population items without further
+   * allocation; call before inserting many items at once. */
+  bool resize (unsigned int new_population = 0)
   {
     if (unlikely (!successful)) return false;
 
-    unsigned int power = hb_bit_storage (population * 2 + 8);
+    unsigned int power = hb_bit_storage (hb_max (population, new_population) * 2 + 8);
     unsigned int new_size = 1u << power;
-    item_t *new_items = (item_t *) malloc ((size_t) new_size * sizeof (item_t));
+    if (items && new_size <= mask + 1 && occupancy == population)
+      return true; /* Never shrink a map without tombstones. */
+    item_t *new_items = (item_t *) malloc ((size_t) new_size * (sizeof (item_t) + 1));
     if (unlikely (!new_items))
     {
       successful = false;
@@ -127,16 +165,17 @@ struct hb_hashmap_t
     /* Switch to new, empty, array. */
     population = occupancy = 0;
     mask = new_size - 1;
-    prime = prime_for (power);
     items = new_items;
+    ctrl = (uint8_t *) (new_items + new_size);
+    memset (ctrl, EMPTY, new_size);
 
     /* Insert back old items. */
     if (old_items)
       for (unsigned int i = 0; i < old_size; i++)
 	if (old_items[i].is_real ())
-	  set_with_hash (old_items[i].key,
-			 old_items[i].hash,
-			 old_items[i].value);
+	  insert_new (old_items[i].key,
+		      hb_hash (old_items[i].key),
+		      old_items[i].value);
 
     free (old_items);
 
@@ -151,8 +190,22 @@ struct hb_hashmap_t
   V get (K key) const
   {
     if (unlikely (!items)) return vINVALID;
-    unsigned int i = bucket_for (key);
-    return items[i].is_real () && items[i] == key ? items[i].value : vINVALID;
+    uint32_t hash = hb_hash (key);
+    uint8_t h2 = h2_for_hash (hash);
+    unsigned int pos = start_for_hash (hash);
+    for (unsigned int step = group_t::SIZE; ; step += group_t::SIZE)
+    {
+      group_t g (ctrl + pos);
+      for (uint64_t m = g.match (h2); m; m &= m - 1)
+      {
+	unsigned int i = pos + group_t::first (m);
+	if (items[i] == key)
+	  return items[i].value;
+      }
+      if (g.match_empty ())
+	return vINVALID;
+      pos = (pos + step) & mask;
+    }
   }
 
   void del (K key) { set (key, vINVALID); }
@@ -175,9 +228,12 @@ struct hb_hashmap_t
     if (unlikely (hb_object_is_immutable (this)))
       return;
     if (items)
+    {
       + hb_iter (items, mask + 1)
       | hb_apply (&item_t::clear)
       ;
+      memset (ctrl, EMPTY, mask + 1);
+    }
 
     population = occupancy = 0;
   }
@@ -216,103 +272,106 @@ struct hb_hashmap_t
 
   protected:
 
+  /* Groups are narrower than the usual sixteen items, so keep a quarter
+   * of the items empty; that also guarantees probing terminates. */
+  unsigned int max_occupancy () const { return mask + 1 - (mask + 1) / 4; }
+
   void set_with_hash (K key, uint32_t hash, V value)
   {
     if (unlikely (!successful)) return;
     if (unlikely (key == kINVALID)) return;
-    if ((occupancy + occupancy / 2) >= mask && !resize ()) return;
+    if ((!items || occupancy >= max_occupancy ()) && !resize ()) return;
     unsigned int i = bucket_for_hash (key, hash);
 
-    if (value == vINVALID && items[i].key != key)
+    if (is_full (ctrl[i]))
+    {
+      if (value == vINVALID)
+	erase (i);
+      else
+	items[i].value = value;
+      return;
+    }
+
+    if (value == vINVALID)
       return; /* Trying to delete non-existent key. */
 
-    if (!items[i].is_unused ())
+    store (i, key, hash, value);
+  }
+
+  /* Inserts a key known not to be in the map, into a map known to have
+   * room for it. */
+  void insert_new (K key, uint32_t hash, V value)
+  {
+    unsigned int pos = start_for_hash (hash);
+    for (unsigned int step = group_t::SIZE; ; step += group_t::SIZE)
     {
-      occupancy--;
-      if (items[i].is_tombstone ())
-	population--;
+      uint64_t m = group_t (ctrl + pos).match_empty_or_deleted ();
+      if (m)
+      {
+	store (pos + group_t::first (m), key, hash, value);
+	return;
+      }
+      pos = (pos + step) & mask;
     }
+  }
 
+  void store (unsigned int i, K key, uint32_t hash, V value)
+  {
+    if (ctrl[i] == EMPTY)
+      occupancy++;
+    population++;
+    ctrl[i] = h2_for_hash (hash);
     items[i].key = key;
     items[i].value = value;
-    items[i].hash = hash;
-
-    occupancy++;
-    if (!items[i].is_tombstone ())
-      population++;
   }
 
-  unsigned int bucket_for (K key) const
+  void erase (unsigned int i)
   {
-    return bucket_for_hash (key, hb_hash (key));
+    population--;
+    /* Probing stops at the first group with an empty item, so no probe
+     * has ever continued past a group that still has one.  Such a group
+     * can free the item outright. */
+    if (group_t (ctrl + (i & ~(group_t::SIZE - 1))).match_empty ())
+    {
+      ctrl[i] = EMPTY;
+      occupancy--;
+    }
+    else
+      ctrl[i] = DELETED;
+    items[i].clear ();
   }
 
+  /* Returns the item holding key if present, otherwise the item key
+   * should be inserted at. */
   unsigned int bucket_for_hash (K key, uint32_t hash) const
   {
-    unsigned int i = hash % prime;
-    unsigned int step = 0;
+    uint8_t h2 = h2_for_hash (hash);
+    unsigned int pos = start_for_hash (hash);
     unsigned int tombstone = (unsigned) -1;
-    while (!items[i].is_unused ())
+    for (unsigned int step = group_t::SIZE; ; step += group_t::SIZE)
     {
-      if (items[i].hash == hash && items[i] == key)
-	return i;
-      if (tombstone == (unsigned) -1 && items[i].is_tombstone ())
-	tombstone = i;
-      i = (i + ++step) & mask;
+      group_t g (ctrl + pos);
+      for (uint64_t m = g.match (h2); m; m &= m - 1)
+      {
+	unsigned int i = pos + group_t::first (m);
+	if (items[i] == key)
+	  return i;
+      }
+      uint64_t free_items = g.match_empty_or_deleted ();
+      if (tombstone == (unsigned) -1 && free_items)
+	tombstone = pos + group_t::first (free_items);
+      if (g.match_empty ())
+	return tombstone;
+      pos = (pos + step) & mask;
     }
-    return tombstone == (unsigned) -1 ? i : tombstone;
   }
 
-  static unsigned int prime_for (unsigned int shift)
-  {
-    /* Following comment and table copied from glib. */
-    /* Each table size has an associated prime modulo (the first prime
-     * lower than the table size) used to find the initial bucket. Probing
-     * then works modulo 2^n. The prime modulo is necessary to get a
-     * good distribution with poor hash functions.
-     */
-    /* Not declaring static to make all kinds of compilers happy... */
-    /*static*/ const unsigned int prime_mod [32] =
-    {
-      1,          /* For 1 << 0 */
-      2,
-      3,
-      7,
-      13,
-      31,
-      61,
-      127,
-      251,
-      509,
-      1021,
-      2039,
-      4093,
-      8191,
-      16381,
-      32749,
-      65521,      /* For 1 << 16 */
-      131071,
-      262139,
-      524287,
-      1048573,
-      2097143,
-      4194301,
-      8388593,
-      16777213,
-      33554393,
-      67108859,
-      134217689,
-      268435399,
-      536870909,
-      1073741789,
-      2147483647  /* For 1 << 31 */
-    };
-
-    if (unlikely (shift >= ARRAY_LENGTH (prime_mod)))
-      return prime_mod[ARRAY_LENGTH (prime_mod) - 1];
-
-    return prime_mod[shift];
-  }
+  /* The hash functions in use leave their best bits at the top; fold
+   * them into the bits that pick the first group.  Groups are probed in
+   * triangular order, which visits all of them for power-of-two sizes. */
+  unsigned int start_for_hash (uint32_t hash) const
+  { return ((hash ^ (hash >> 16)) * group_t::SIZE) & mask; }
+  static uint8_t h2_for_hash (uint32_t hash) { return hash >> 25; }
 };
 
 /*
@@ -118,10 +118,16 @@ typedef struct OffsetTable
 
   public:
 
+  /* Serializes the sfnt header and table records only.  The tables
+   * themselves are expected to follow the directory in @items order,
+   * each padded to a four-byte boundary.  On return, @checksum_adjustment
+   * holds the value to store in head.checkSumAdjustment, if a head
+   * table is present. */
   template <typename item_t>
-  bool serialize (hb_serialize_context_t *c,
-		  hb_tag_t sfnt_tag,
-		  hb_array_t<item_t> items)
+  bool serialize_directory (hb_serialize_context_t *c,
+			    hb_tag_t sfnt_tag,
+			    hb_array_t<item_t> items,
+			    uint32_t *checksum_adjustment)
   {
     TRACE_SERIALIZE (this);
     /* Alloc 12 for the OTHeader. */
@@ -133,47 +139,36 @@ typedef struct OffsetTable
     if (unlikely (!tables.serialize (c, items.length))) return_trace (false);
 
     const char *dir_end = (const char *) c->head;
-    HBUINT32 *checksum_adjustment = nullptr;
+    unsigned int offset = dir_end - (const char *) this;
+    bool has_head = false;
 
-    /* Write OffsetTables, alloc for and write actual table blobs. */
+    /* Write OffsetTables; table data is not touched. */
     for (unsigned int i = 0; i < tables.len; i++)
     {
       TableRecord &rec = tables.arrayZ[i];
       hb_blob_t *blob = items[i].blob;
       rec.tag = items[i].tag;
       rec.length = blob->length;
-      rec.offset.serialize (c, this);
-
-      /* Allocate room for the table and copy it. */
-      char *start = (char *) c->allocate_size<void> (rec.length);
-      if (unlikely (!start)) return false;
-
-      if (likely (rec.length))
-	memcpy (start, blob->data, rec.length);
-
-      /* 4-byte alignment. */
-      c->align (4);
-      const char *end = (const char *) c->head;
+      rec.offset = offset;
+      rec.checkSum.set_for_unpadded_data (blob->data, blob->length);
 
       if (items[i].tag == HB_OT_TAG_head &&
-	  (unsigned) (end - start) >= head::static_size)
+	  blob->length >= head::static_size)
       {
-	head *h = (head *) start;
-	checksum_adjustment = &h->checkSumAdjustment;
-	*checksum_adjustment = 0;
+	/* checkSumAdjustment is taken to be zero for checksumming. */
+	const head *h = (const head *) blob->data;
+	rec.checkSum = rec.checkSum - h->checkSumAdjustment;
+	has_head = true;
       }
 
-      rec.checkSum.set_for_data (start, end - start);
+      offset += hb_ceil_to_4 (blob->length);
     }
 
     tables.qsort ();
 
-    if (checksum_adjustment)
+    if (has_head && checksum_adjustment)
     {
       CheckSum checksum;
-
-      /* The following line is a slower version of the following block. */
-      //checksum.set_for_data (this, (const char *) c->head - (const char *) this);
       checksum.set_for_data (this, dir_end - (const char *) this);
       for (unsigned int i = 0; i < items.length; i++)
       {
@@ -183,6 +178,8 @@ typedef struct OffsetTable
 
       *checksum_adjustment = 0xB1B0AFBAu - checksum;
     }
+    else if (checksum_adjustment)
+      *checksum_adjustment = 0;
 
     return_trace (true);
   }
@@ -483,14 +480,15 @@ struct OpenTypeFontFile
   }
 
   template <typename item_t>
-  bool serialize_single (hb_serialize_context_t *c,
-			 hb_tag_t sfnt_tag,
-			 hb_array_t<item_t> items)
+  bool serialize_single_directory (hb_serialize_context_t *c,
+				   hb_tag_t sfnt_tag,
+				   hb_array_t<item_t> items,
+				   uint32_t *checksum_adjustment)
   {
     TRACE_SERIALIZE (this);
     assert (sfnt_tag != TTCTag);
     if (unlikely (!c->extend_min (*this))) return_trace (false);
-    return_trace (u.fontFace.serialize (c, sfnt_tag, items));
+    return_trace (u.fontFace.serialize_directory (c, sfnt_tag, items, checksum_adjustment));
   }
 
   bool sanitize (hb_sanitize_context_t *c) const
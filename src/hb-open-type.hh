@@ -230,6 +230,22 @@ struct CheckSum : HBUINT32
   void set_for_data (const void *data, unsigned int length)
   { *this = CalcTableChecksum ((const HBUINT32 *) data, length); }
 
+  /* Like set_for_data(), but data may have any length; the missing
+   * padding bytes at the end are taken to be zero. */
+  void set_for_unpadded_data (const void *data, unsigned int length)
+  {
+    uint32_t sum = CalcTableChecksum ((const HBUINT32 *) data, length & ~3u);
+    unsigned int tail = length & 3u;
+    if (tail)
+    {
+      HBUINT32 last;
+      last = 0;
+      memcpy (&last, (const char *) data + (length & ~3u), tail);
+      sum += last;
+    }
+    *this = sum;
+  }
+
   public:
   DEFINE_SIZE_STATIC (4);
 };
@@ -328,6 +328,250 @@ struct cff1_extents_param_t
   const OT::cff1::accelerator_t *cff;
 };
 
+/*
+ * Decoded charstrings
+ *
+ * The first time a glyph is needed, its charstring is interpreted into the
+ * moveto, line and curve segments it makes, and the seac it ends with if
+ * any.  Extents, drawing and seac lookups then replay these instead of
+ * decoding numbers, calling subroutines and skipping hints again.  Points
+ * are kept at the interpreter's precision, such that replaying gives the
+ * same results as interpreting.
+ */
+
+static bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, bounds_t &bounds, bool in_seac=false);
+
+struct CFF::cff1_outline_t
+{
+  enum op_t : uint8_t { MOVE_TO, LINE_TO, CUBIC_TO };
+
+  static unsigned int get_size (unsigned int num_ops, unsigned int num_points)
+  { return sizeof (cff1_outline_t) + num_points * sizeof (point_t) + num_ops; }
+  unsigned int get_size () const { return get_size (num_ops, num_points); }
+
+  const point_t *points () const { return reinterpret_cast<const point_t *> (this + 1); }
+  const uint8_t *ops () const { return reinterpret_cast<const uint8_t *> (points () + num_points); }
+
+  /* Computes the bounds of the outline's own segments, as
+   * cff1_path_procs_extents_t does. */
+  void init_bounds ()
+  {
+    bool path_open = false;
+    bounds.init ();
+
+    point_t pt;
+    pt.init ();
+    const point_t *p = points ();
+    const uint8_t *op = ops ();
+    for (unsigned int i = 0; i < num_ops; i++)
+    {
+      if (op[i] == MOVE_TO)
+      {
+	path_open = false;
+	pt = *p++;
+	continue;
+      }
+      if (!path_open)
+      {
+	path_open = true;
+	bounds.update (pt);
+      }
+      if (op[i] == CUBIC_TO)
+      {
+	/* include control points */
+	bounds.update (*p++);
+	bounds.update (*p++);
+      }
+      pt = *p++;
+      bounds.update (pt);
+    }
+  }
+
+  /* Same as cff1_cs_opset_extents_t, resolving the seac if any. */
+  bool get_bounds (const OT::cff1::accelerator_t *cff, bounds_t &bounds_, bool in_seac) const
+  {
+    bounds_ = bounds;
+    if (has_seac)
+    {
+      bounds_t  base_bounds, accent_bounds;
+      if (unlikely (!(!in_seac && seac_base && seac_accent
+		      && _get_bounds (cff, seac_base, base_bounds, true)
+		      && _get_bounds (cff, seac_accent, accent_bounds, true))))
+	return false;
+      bounds_.merge (base_bounds);
+      accent_bounds.offset (seac_delta);
+      bounds_.merge (accent_bounds);
+    }
+    return true;
+  }
+
+  unsigned int	num_ops;
+  unsigned int	num_points;
+  bool		has_seac;
+  hb_codepoint_t	seac_base;
+  hb_codepoint_t	seac_accent;
+  point_t	seac_delta;
+  bounds_t	bounds;		/* Of the segments, not including the seac. */
+  /* point_t	pointsX[num_points]; */
+  /* uint8_t	opsX[num_ops]; */
+};
+
+struct cff1_outline_param_t
+{
+  void init (const OT::cff1::accelerator_t *_cff)
+  {
+    cff = _cff;
+    ops.init ();
+    points.init ();
+    has_seac = false;
+    seac_base = seac_accent = 0;
+    seac_delta.init ();
+  }
+  void fini ()
+  {
+    ops.fini ();
+    points.fini ();
+  }
+
+  cff1_outline_t *create_outline () const
+  {
+    if (unlikely (ops.in_error () || points.in_error ())) return nullptr;
+    cff1_outline_t *outline = (cff1_outline_t *) calloc (1, cff1_outline_t::get_size (ops.length, points.length));
+    if (unlikely (!outline)) return nullptr;
+    outline->num_ops = ops.length;
+    outline->num_points = points.length;
+    outline->has_seac = has_seac;
+    outline->seac_base = seac_base;
+    outline->seac_accent = seac_accent;
+    outline->seac_delta = seac_delta;
+    if (points.length)
+      memcpy ((void *) outline->points (), points.arrayZ, points.length * sizeof (point_t));
+    if (ops.length)
+      memcpy ((void *) outline->ops (), ops.arrayZ, ops.length);
+    outline->init_bounds ();
+    return outline;
+  }
+
+  hb_vector_t<uint8_t>	ops;
+  hb_vector_t<point_t>	points;
+  bool			has_seac;
+  hb_codepoint_t	seac_base;
+  hb_codepoint_t	seac_accent;
+  point_t		seac_delta;
+
+  const OT::cff1::accelerator_t *cff;
+};
+
+struct cff1_path_procs_outline_t : path_procs_t<cff1_path_procs_outline_t, cff1_cs_interp_env_t, cff1_outline_param_t>
+{
+  static void moveto (cff1_cs_interp_env_t &env, cff1_outline_param_t& param, const point_t &pt)
+  {
+    param.ops.push (cff1_outline_t::MOVE_TO);
+    param.points.push (pt);
+    env.moveto (pt);
+  }
+
+  static void line (cff1_cs_interp_env_t &env, cff1_outline_param_t& param, const point_t &pt1)
+  {
+    param.ops.push (cff1_outline_t::LINE_TO);
+    param.points.push (pt1);
+    env.moveto (pt1);
+  }
+
+  static void curve (cff1_cs_interp_env_t &env, cff1_outline_param_t& param, const point_t &pt1, const point_t &pt2, const point_t &pt3)
+  {
+    param.ops.push (cff1_outline_t::CUBIC_TO);
+    param.points.push (pt1);
+    param.points.push (pt2);
+    param.points.push (pt3);
+    env.moveto (pt3);
+  }
+};
+
+struct cff1_cs_opset_outline_t : cff1_cs_opset_t<cff1_cs_opset_outline_t, cff1_outline_param_t, cff1_path_procs_outline_t>
+{
+  static void process_seac (cff1_cs_interp_env_t &env, cff1_outline_param_t& param)
+  {
+    /* Components are resolved when replaying. */
+    unsigned int  n = env.argStack.get_count ();
+    param.has_seac = true;
+    param.seac_delta.x = env.argStack[n-4];
+    param.seac_delta.y = env.argStack[n-3];
+    param.seac_base = param.cff->std_code_to_glyph (env.argStack[n-2].to_int ());
+    param.seac_accent = param.cff->std_code_to_glyph (env.argStack[n-1].to_int ());
+  }
+};
+
+const cff1_outline_t *
+OT::cff1::accelerator_t::get_outline (hb_codepoint_t glyph) const
+{
+  if (!HB_CFF1_OUTLINE_CACHE_SIZE) return nullptr;
+  if (unlikely (!is_valid () || (glyph >= num_glyphs))) return nullptr;
+
+  hb_atomic_ptr_t<cff1_outline_t> *slots = outlines.get ();
+  if (likely (slots))
+  {
+    const cff1_outline_t *outline = slots[glyph].get ();
+    if (outline) return outline;
+  }
+
+  /* Once full, glyphs are interpreted every time; nothing is evicted,
+   * as other threads may be replaying cached outlines. */
+  if ((unsigned) outlines_size.get () >= HB_CFF1_OUTLINE_CACHE_SIZE) return nullptr;
+
+  if (unlikely (!slots))
+  {
+    unsigned int slots_size = num_glyphs * sizeof (slots[0]);
+    if (slots_size >= HB_CFF1_OUTLINE_CACHE_SIZE ||
+	unlikely (!(slots = (hb_atomic_ptr_t<cff1_outline_t> *) calloc (num_glyphs, sizeof (slots[0])))))
+    {
+      outlines_size.set (HB_CFF1_OUTLINE_CACHE_SIZE);
+      return nullptr;
+    }
+    if (unlikely (!outlines.cmpexch (nullptr, slots)))
+      free (slots);
+    else
+      (void) hb_atomic_int_impl_add (&outlines_size.v, slots_size);
+    slots = outlines.get ();
+  }
+
+  unsigned int fd = fdSelect->get_fd (glyph);
+  cff1_cs_interpreter_t<cff1_cs_opset_outline_t, cff1_outline_param_t> interp;
+  const byte_str_t str = (*charStrings)[glyph];
+  interp.env.init (str, *this, fd);
+  cff1_outline_param_t param;
+  param.init (this);
+  cff1_outline_t *outline = likely (interp.interpret (param)) ? param.create_outline () : nullptr;
+  param.fini ();
+  if (unlikely (!outline)) return nullptr;
+
+  unsigned int size = outline->get_size ();
+  if ((unsigned) hb_atomic_int_impl_add (&outlines_size.v, size) + size > HB_CFF1_OUTLINE_CACHE_SIZE)
+  {
+    outlines_size.set (HB_CFF1_OUTLINE_CACHE_SIZE);
+    free (outline);
+    return nullptr;
+  }
+  if (unlikely (!slots[glyph].cmpexch (nullptr, outline)))
+  {
+    (void) hb_atomic_int_impl_add (&outlines_size.v, -(int) size);
+    free (outline);
+    return slots[glyph].get ();
+  }
+  return outline;
+}
+
+void
+OT::cff1::accelerator_t::fini_outlines ()
+{
+  hb_atomic_ptr_t<cff1_outline_t> *slots = outlines.get ();
+  if (!slots) return;
+  for (unsigned int i = 0; i < num_glyphs; i++)
+    free (slots[i].get ());
+  free (slots);
+  outlines.init ();
+}
+
 struct cff1_path_procs_extents_t : path_procs_t<cff1_path_procs_extents_t, cff1_cs_interp_env_t, cff1_extents_param_t>
 {
   static void moveto (cff1_cs_interp_env_t &env, cff1_extents_param_t& param, const point_t &pt)
@@ -362,8 +606,6 @@ struct cff1_path_procs_extents_t : path_procs_t<cff1_path_procs_extents_t, cff1_
   }
 };
 
-static bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, bounds_t &bounds, bool in_seac=false);
-
 struct cff1_cs_opset_extents_t : cff1_cs_opset_t<cff1_cs_opset_extents_t, cff1_extents_param_t, cff1_path_procs_extents_t>
 {
   static void process_seac (cff1_cs_interp_env_t &env, cff1_extents_param_t& param)
@@ -394,6 +636,10 @@ bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, boun
   bounds.init ();
   if (unlikely (!cff->is_valid () || (glyph >= cff->num_glyphs))) return false;
 
+  const cff1_outline_t *outline = cff->get_outline (glyph);
+  if (likely (outline))
+    return outline->get_bounds (cff, bounds, in_seac);
+
   unsigned int fd = cff->fdSelect->get_fd (glyph);
   cff1_cs_interpreter_t<cff1_cs_opset_extents_t, cff1_extents_param_t> interp;
   const byte_str_t str = (*cff->charStrings)[glyph];
@@ -536,11 +782,58 @@ struct cff1_cs_opset_path_t : cff1_cs_opset_t<cff1_cs_opset_path_t, cff1_path_pa
   }
 };
 
+/* Same as cff1_path_procs_path_t and cff1_cs_opset_path_t. */
+static bool _draw_outline (const cff1_outline_t *outline, cff1_path_param_t &param, bool in_seac)
+{
+  const point_t *p = outline->points ();
+  const uint8_t *op = outline->ops ();
+  for (unsigned int i = 0; i < outline->num_ops; i++)
+    switch (op[i])
+    {
+    case cff1_outline_t::MOVE_TO:
+      param.move_to (p[0]);
+      p += 1;
+      break;
+    case cff1_outline_t::LINE_TO:
+      param.line_to (p[0]);
+      p += 1;
+      break;
+    default:
+      param.cubic_to (p[0], p[1], p[2]);
+      p += 3;
+      break;
+    }
+
+  if (outline->has_seac)
+  {
+    /* End previous path */
+    param.end_path ();
+
+    point_t delta = outline->seac_delta;
+    if (unlikely (!(!in_seac && outline->seac_base && outline->seac_accent
+		    && _get_path (param.cff, param.font, outline->seac_base, *param.draw_helper, true)
+		    && _get_path (param.cff, param.font, outline->seac_accent, *param.draw_helper, true, &delta))))
+      return false;
+  }
+  return true;
+}
+
 bool _get_path (const OT::cff1::accelerator_t *cff, hb_font_t *font, hb_codepoint_t glyph,
 		draw_helper_t &draw_helper, bool in_seac, point_t *delta)
 {
   if (unlikely (!cff->is_valid () || (glyph >= cff->num_glyphs))) return false;
 
+  const cff1_outline_t *outline = cff->get_outline (glyph);
+  if (likely (outline))
+  {
+    cff1_path_param_t param (cff, font, draw_helper, delta);
+    if (unlikely (!_draw_outline (outline, param, in_seac))) return false;
+
+    /* Let's end the path specially since it is called inside seac also */
+    param.end_path ();
+    return true;
+  }
+
   unsigned int fd = cff->fdSelect->get_fd (glyph);
   cff1_cs_interpreter_t<cff1_cs_opset_path_t, cff1_path_param_t> interp;
   const byte_str_t str = (*cff->charStrings)[glyph];
@@ -599,6 +892,16 @@ bool OT::cff1::accelerator_t::get_seac_components (hb_codepoint_t glyph, hb_code
 {
   if (unlikely (!is_valid () || (glyph >= num_glyphs))) return false;
 
+  const cff1_outline_t *outline = get_outline (glyph);
+  if (likely (outline))
+  {
+    if (!(outline->has_seac && outline->seac_base && outline->seac_accent))
+      return false;
+    *base = outline->seac_base;
+    *accent = outline->seac_accent;
+    return true;
+  }
+
   unsigned int fd = fdSelect->get_fd (glyph);
   cff1_cs_interpreter_t<cff1_cs_opset_seac_t, get_seac_param_t> interp;
   const byte_str_t str = (*charStrings)[glyph];
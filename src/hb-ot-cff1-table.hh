@@ -47,6 +47,13 @@ namespace CFF {
 
 #define CFF_UNDEF_SID   CFF_UNDEF_CODE
 
+/* Bytes of decoded charstrings cached per face; 0 disables the cache. */
+#ifndef HB_CFF1_OUTLINE_CACHE_SIZE
+#define HB_CFF1_OUTLINE_CACHE_SIZE (1u << 20)
+#endif
+
+struct cff1_outline_t;
+
 enum EncodingID { StandardEncoding = 0, ExpertEncoding = 1 };
 enum CharsetID { ISOAdobeCharset = 0, ExpertCharset = 1, ExpertSubsetCharset = 2 };
 
@@ -1270,6 +1277,9 @@ struct cff1
   {
     void init (hb_face_t *face)
     {
+      outlines.init ();
+      outlines_size.set_relaxed (0);
+
       SUPER::init (face);
 
       if (!is_valid ()) return;
@@ -1297,6 +1307,7 @@ struct cff1
     void fini ()
     {
       glyph_names.fini ();
+      fini_outlines ();
 
       SUPER::fini ();
     }
@@ -1350,7 +1361,13 @@ struct cff1
     HB_INTERNAL bool get_path (hb_font_t *font, hb_codepoint_t glyph, draw_helper_t &draw_helper) const;
 #endif
 
+    /* Returns the decoded charstring of glyph, decoding and caching it
+     * on first use, or nullptr if it is not cached and the cache is full. */
+    HB_INTERNAL const cff1_outline_t *get_outline (hb_codepoint_t glyph) const;
+
     private:
+    HB_INTERNAL void fini_outlines ();
+
     struct gname_t
     {
       hb_bytes_t	name;
@@ -1371,6 +1388,10 @@ struct cff1
 
     hb_sorted_vector_t<gname_t>	glyph_names;
 
+    /* Decoded charstrings by glyph, allocated on first use. */
+    hb_atomic_ptr_t<hb_atomic_ptr_t<cff1_outline_t>>	outlines;
+    mutable hb_atomic_int_t				outlines_size;
+
     typedef accelerator_templ_t<cff1_private_dict_opset_t, cff1_private_dict_values_t> SUPER;
   };
 
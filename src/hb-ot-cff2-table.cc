@@ -31,9 +31,37 @@
 #include "hb-ot-cff2-table.hh"
 #include "hb-cff2-interp-cs.hh"
 #include "hb-draw.hh"
+#include "hb-ot-font-cache.hh"
 
 using namespace CFF;
 
+/* Returns the scalars of all variation regions at the font's coordinates,
+ * evaluating them on first use, or nullptr if there is nothing to blend. */
+const float *
+OT::cff2::accelerator_t::get_region_scalars (hb_font_t *font) const
+{
+  if (!font->num_coords || !varStore->size) return nullptr;
+
+  hb_ot_font_cache_t *cache = hb_ot_font_cache_t::get (font);
+  if (unlikely (!cache)) return nullptr;
+
+retry:
+  float *scalars = cache->cff2_region_scalars.get ();
+  if (likely (scalars)) return scalars;
+
+  unsigned int count = varStore->varStore.get_region_count ();
+  scalars = (float *) calloc (hb_max (count, 1u), sizeof (float));
+  if (unlikely (!scalars)) return nullptr;
+  varStore->varStore.get_region_scalars (font->coords, font->num_coords, scalars, count);
+
+  if (unlikely (!cache->cff2_region_scalars.cmpexch (nullptr, scalars)))
+  {
+    free (scalars);
+    goto retry;
+  }
+  return scalars;
+}
+
 struct cff2_extents_param_t
 {
   void init ()
@@ -114,7 +142,8 @@ bool OT::cff2::accelerator_t::get_extents (hb_font_t *font,
   unsigned int fd = fdSelect->get_fd (glyph);
   cff2_cs_interpreter_t<cff2_cs_opset_extents_t, cff2_extents_param_t> interp;
   const byte_str_t str = (*charStrings)[glyph];
-  interp.env.init (str, *this, fd, font->coords, font->num_coords);
+  interp.env.init (str, *this, fd, font->coords, font->num_coords,
+		   get_region_scalars (font));
   cff2_extents_param_t  param;
   param.init ();
   if (unlikely (!interp.interpret (param))) return false;
@@ -205,7 +234,8 @@ bool OT::cff2::accelerator_t::get_path (hb_font_t *font, hb_codepoint_t glyph, d
   unsigned int fd = fdSelect->get_fd (glyph);
   cff2_cs_interpreter_t<cff2_cs_opset_path_t, cff2_path_param_t> interp;
   const byte_str_t str = (*charStrings)[glyph];
-  interp.env.init (str, *this, fd, font->coords, font->num_coords);
+  interp.env.init (str, *this, fd, font->coords, font->num_coords,
+		   get_region_scalars (font));
   cff2_path_param_t param (font, draw_helper);
   if (unlikely (!interp.interpret (param))) return false;
   return true;
@@ -911,7 +911,7 @@ struct NonDefaultUVS : SortedArrayOf<UVSMapping, HBUINT32>
   NonDefaultUVS* copy (hb_serialize_context_t *c,
 		       const hb_set_t *unicodes,
 		       const hb_set_t *glyphs_requested,
-		       const hb_map_t *glyph_map) const
+		       const hb_dense_map_t *glyph_map) const
   {
     NonDefaultUVS *out = c->start_embed<NonDefaultUVS> ();
     if (unlikely (!out)) return nullptr;
@@ -1005,7 +1005,7 @@ struct VariationSelectorRecord
   copy (hb_serialize_context_t *c,
 	const hb_set_t *unicodes,
 	const hb_set_t *glyphs_requested,
-	const hb_map_t *glyph_map,
+	const hb_dense_map_t *glyph_map,
 	const void *base) const
   {
     auto snap = c->snapshot ();
@@ -1069,7 +1069,7 @@ struct CmapSubtableFormat14
   void serialize (hb_serialize_context_t *c,
 		  const hb_set_t *unicodes,
 		  const hb_set_t *glyphs_requested,
-		  const hb_map_t *glyph_map,
+		  const hb_dense_map_t *glyph_map,
 		  const void *base)
   {
     auto snap = c->snapshot ();
@@ -1361,12 +1361,13 @@ struct cmap
     for (const EncodingRecord& _ : encodingrec_iter)
     {
       hb_set_t unicodes_set;
-      hb_map_t cp_glyphid_map;
-      (base+_.subtable).collect_mapping (&unicodes_set, &cp_glyphid_map);
 
       unsigned format = (base+_.subtable).u.format;
       if (!plan->glyphs_requested->is_empty ())
       {
+        hb_map_t cp_glyphid_map;
+        (base+_.subtable).collect_mapping (&unicodes_set, &cp_glyphid_map);
+
         auto table_iter =
         + hb_zip (unicodes_set.iter(), unicodes_set.iter() | hb_map(cp_glyphid_map))
         | hb_filter (plan->_glyphset, hb_second)
@@ -1389,6 +1390,9 @@ struct cmap
        * all codepoints in each subtable, which is more efficient */
       else
       {
+        /* Only the codepoints covered by the subtable are needed here;
+         * collecting them is much cheaper than the full mapping. */
+        (base+_.subtable).collect_unicodes (&unicodes_set);
         if (format == 4) c->copy (_, + it | hb_filter (unicodes_set, hb_first), 4u, base, plan, &format4objidx);
         else if (format == 12) c->copy (_, + it | hb_filter (unicodes_set, hb_first), 12u, base, plan, &format12objidx);
         else if (format == 14) c->copy (_, it, 14u, base, plan, &format14objidx);
@@ -125,7 +125,7 @@ struct COLR
 
     void fini () { this->colr.destroy (); }
 
-    bool is_valid () { return colr.get_blob ()->length; }
+    bool is_valid () const { return colr.get_blob ()->length; }
 
     void closure_glyphs (hb_codepoint_t glyph,
 			 hb_set_t *related_ids /* OUT */) const
@@ -202,7 +202,7 @@ struct COLR
   {
     TRACE_SUBSET (this);
 
-    const hb_map_t &reverse_glyph_map = *c->plan->reverse_glyph_map;
+    const hb_dense_map_t &reverse_glyph_map = *c->plan->reverse_glyph_map;
 
     auto base_it =
     + hb_range (c->plan->num_output_glyphs ())
@@ -26,6 +26,7 @@
 
 #include "hb-ot-face.hh"
 
+#include "hb-aat-layout-morx-table.hh"
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
 #include "hb-ot-cff1-table.hh"
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2020  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_OT_FONT_CACHE_HH
+#define HB_OT_FONT_CACHE_HH
+
+#include "hb.hh"
+
+#include "hb-cache.hh"
+#include "hb-font.hh"
+
+
+/*
+ * hb_ot_font_cache_t
+ *
+ * Values the OpenType tables derive from a font's scale and variation
+ * coordinates, kept so that they are computed once rather than per glyph.
+ * The font holds it opaquely, and drops it when its scale, coordinates or
+ * face change.  The cache and its members are created on first use.
+ */
+struct hb_ot_font_cache_t
+{
+  /* Returns the cache of @font, or nullptr on allocation failure. */
+  static hb_ot_font_cache_t *get (hb_font_t *font)
+  {
+  retry:
+    hb_ot_font_cache_t *cache = font->ot_cache.get ();
+    if (likely (cache)) return cache;
+
+    cache = (hb_ot_font_cache_t *) calloc (1, sizeof (hb_ot_font_cache_t));
+    if (unlikely (!cache)) return nullptr;
+    cache->init ();
+
+    if (unlikely (!font->ot_cache.cmpexch (nullptr, cache)))
+    {
+      cache->fini ();
+      free (cache);
+      goto retry;
+    }
+    return cache;
+  }
+
+  void init ()
+  {
+    cff2_region_scalars.init ();
+    gvar_shared_scalars.init ();
+    v_origins.init ();
+  }
+
+  void fini ()
+  {
+    free (cff2_region_scalars.get_relaxed ());
+    free (gvar_shared_scalars.get_relaxed ());
+  }
+
+  /* Scalars of all variation regions of the CFF2 table. */
+  hb_atomic_ptr_t<float> cff2_region_scalars;
+
+  /* Scalars of the gvar table's shared tuples. */
+  hb_atomic_ptr_t<float> gvar_shared_scalars;
+
+  /* Vertical origins the OpenType font functions derived from glyph
+   * extents. */
+  hb_v_origin_cache_t v_origins;
+};
+
+
+#endif /* HB_OT_FONT_CACHE_HH */
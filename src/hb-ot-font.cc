@@ -26,6 +26,20 @@
 
 #include "hb.hh"
 
+#include "hb-ot-font-cache.hh"
+
+
+/* Defined regardless of HB_NO_OT_FONT, since the tables also use the
+ * cache when drawing. */
+void
+hb_ot_font_cache_destroy (hb_ot_font_cache_t *cache)
+{
+  if (!cache) return;
+  cache->fini ();
+  free (cache);
+}
+
+
 #ifndef HB_NO_OT_FONT
 
 #include "hb-ot.h"
@@ -110,9 +124,14 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
   const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
   const OT::hmtx_accelerator_t &hmtx = *ot_face->hmtx;
 
+  /* Evaluate the HVAR regions once for the whole run. */
+  hb_vector_t<float> region_scalars;
+  if (count > 1)
+    hmtx.get_region_scalars (font, region_scalars);
+
   for (unsigned int i = 0; i < count; i++)
   {
-    *first_advance = font->em_scale_x (hmtx.get_advance (*first_glyph, font));
+    *first_advance = font->em_scale_x (hmtx.get_advance (*first_glyph, font, region_scalars));
     first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
     first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
   }
@@ -130,51 +149,107 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
   const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
   const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
 
+  /* Evaluate the VVAR regions once for the whole run. */
+  hb_vector_t<float> region_scalars;
+  if (count > 1)
+    vmtx.get_region_scalars (font, region_scalars);
+
   for (unsigned int i = 0; i < count; i++)
   {
-    *first_advance = font->em_scale_y (-(int) vmtx.get_advance (*first_glyph, font));
+    *first_advance = font->em_scale_y (-(int) vmtx.get_advance (*first_glyph, font, region_scalars));
     first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
     first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
   }
 }
 
-static hb_bool_t
-hb_ot_get_glyph_v_origin (hb_font_t *font,
-			  void *font_data,
-			  hb_codepoint_t glyph,
-			  hb_position_t *x,
-			  hb_position_t *y,
-			  void *user_data HB_UNUSED)
+/* The cache holds unsigned values; origins are stored biased by this. */
+#define HB_OT_V_ORIGIN_CACHE_BIAS (1 << 23)
+
+/* Vertical origin y of glyph: from VORG if present, or else from the glyph
+ * extents and top side bearing, or else the ascender.  Origins from
+ * extents need the glyph outline for variable fonts, so they are cached
+ * on the font. */
+static hb_position_t
+_hb_ot_get_glyph_v_origin_y (hb_font_t *font,
+			     const hb_ot_face_t *ot_face,
+			     hb_codepoint_t glyph,
+			     OT::glyf::points_scratch_t *scratch = nullptr)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-
-  *x = font->get_glyph_h_advance (glyph) / 2;
-
 #ifndef HB_NO_OT_FONT_CFF
   const OT::VORG &VORG = *ot_face->VORG;
   if (VORG.has_data ())
-  {
-    *y = font->em_scale_y (VORG.get_y_origin (glyph));
-    return true;
-  }
+    return font->em_scale_y (VORG.get_y_origin (glyph));
 #endif
 
+  hb_ot_font_cache_t *cache = hb_ot_font_cache_t::get (font);
+  unsigned int v;
+  if (cache && cache->v_origins.get (glyph, &v))
+    return (int) v - HB_OT_V_ORIGIN_CACHE_BIAS;
+
   hb_glyph_extents_t extents = {0};
-  if (ot_face->glyf->get_extents (font, glyph, &extents))
+  if (ot_face->glyf->get_extents (font, glyph, &extents, scratch))
   {
     const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
     hb_position_t tsb = vmtx.get_side_bearing (font, glyph);
-    *y = extents.y_bearing + font->em_scale_y (tsb);
-    return true;
+    hb_position_t y = extents.y_bearing + font->em_scale_y (tsb);
+    if (cache)
+      cache->v_origins.set (glyph, (unsigned int) (y + HB_OT_V_ORIGIN_CACHE_BIAS));
+    return y;
   }
 
   hb_font_extents_t font_extents;
   font->get_h_extents_with_fallback (&font_extents);
-  *y = font_extents.ascender;
+  return font_extents.ascender;
+}
+
+static hb_bool_t
+hb_ot_get_glyph_v_origin (hb_font_t *font,
+			  void *font_data,
+			  hb_codepoint_t glyph,
+			  hb_position_t *x,
+			  hb_position_t *y,
+			  void *user_data HB_UNUSED)
+{
+  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
+
+  *x = font->get_glyph_h_advance (glyph) / 2;
+  *y = _hb_ot_get_glyph_v_origin_y (font, ot_face, glyph);
 
   return true;
 }
 
+static unsigned int
+hb_ot_get_glyph_v_origins (hb_font_t *font,
+			   void *font_data,
+			   unsigned int count,
+			   const hb_codepoint_t *first_glyph,
+			   unsigned int glyph_stride,
+			   hb_position_t *first_x,
+			   unsigned int x_stride,
+			   hb_position_t *first_y,
+			   unsigned int y_stride,
+			   void *user_data HB_UNUSED)
+{
+  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
+
+  /* Same as hb_ot_get_glyph_v_origin(), with the advances fetched as a
+   * run, and the glyf point buffers reused across glyphs. */
+  font->get_glyph_h_advances (count, first_glyph, glyph_stride, first_x, x_stride);
+
+  OT::glyf::points_scratch_t glyf_scratch;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    *first_x /= 2;
+    *first_y = _hb_ot_get_glyph_v_origin_y (font, ot_face, *first_glyph, &glyf_scratch);
+
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+    first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+  }
+
+  return count;
+}
+
 static hb_bool_t
 hb_ot_get_glyph_extents (hb_font_t *font,
 			 void *font_data,
@@ -200,6 +275,57 @@ hb_ot_get_glyph_extents (hb_font_t *font,
   return false;
 }
 
+static void
+hb_ot_get_glyph_extents_batch (hb_font_t *font,
+			       void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       hb_glyph_extents_t *first_extents,
+			       unsigned int extents_stride,
+			       void *user_data HB_UNUSED)
+{
+  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
+
+  /* Same as hb_ot_get_glyph_extents(), with the tables looked up once,
+   * and the glyf point buffers reused across glyphs. */
+#if !defined(HB_NO_OT_FONT_BITMAP) && !defined(HB_NO_COLOR)
+  const OT::sbix_accelerator_t &sbix = *ot_face->sbix;
+  const OT::CBDT_accelerator_t &CBDT = *ot_face->CBDT;
+#endif
+  const OT::glyf_accelerator_t &glyf = *ot_face->glyf;
+  OT::glyf::points_scratch_t glyf_scratch;
+#ifndef HB_NO_OT_FONT_CFF
+  const OT::cff1_accelerator_t &cff1 = *ot_face->cff1;
+  const OT::cff2_accelerator_t &cff2 = *ot_face->cff2;
+#endif
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    hb_codepoint_t glyph = *first_glyph;
+    hb_glyph_extents_t *extents = first_extents;
+    memset (extents, 0, sizeof (*extents));
+
+    do
+    {
+#if !defined(HB_NO_OT_FONT_BITMAP) && !defined(HB_NO_COLOR)
+      if (sbix.get_extents (font, glyph, extents)) break;
+#endif
+      if (glyf.get_extents (font, glyph, extents, &glyf_scratch)) break;
+#ifndef HB_NO_OT_FONT_CFF
+      if (cff1.get_extents (font, glyph, extents)) break;
+      if (cff2.get_extents (font, glyph, extents)) break;
+#endif
+#if !defined(HB_NO_OT_FONT_BITMAP) && !defined(HB_NO_COLOR)
+      if (CBDT.get_extents (font, glyph, extents)) break;
+#endif
+    } while (0);
+
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+}
+
 #ifndef HB_NO_OT_FONT_GLYPH_NAMES
 static hb_bool_t
 hb_ot_get_glyph_name (hb_font_t *font HB_UNUSED,
@@ -272,7 +398,9 @@ static struct hb_ot_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ot
     hb_font_funcs_set_glyph_v_advances_func (funcs, hb_ot_get_glyph_v_advances, nullptr, nullptr);
     //hb_font_funcs_set_glyph_h_origin_func (funcs, hb_ot_get_glyph_h_origin, nullptr, nullptr);
     hb_font_funcs_set_glyph_v_origin_func (funcs, hb_ot_get_glyph_v_origin, nullptr, nullptr);
+    hb_font_funcs_set_glyph_v_origins_func (funcs, hb_ot_get_glyph_v_origins, nullptr, nullptr);
     hb_font_funcs_set_glyph_extents_func (funcs, hb_ot_get_glyph_extents, nullptr, nullptr);
+    hb_font_funcs_set_glyph_extents_batch_func (funcs, hb_ot_get_glyph_extents_batch, nullptr, nullptr);
     //hb_font_funcs_set_glyph_contour_point_func (funcs, hb_ot_get_glyph_contour_point, nullptr, nullptr);
 #ifndef HB_NO_OT_FONT_GLYPH_NAMES
     hb_font_funcs_set_glyph_name_func (funcs, hb_ot_get_glyph_name, nullptr, nullptr);
@@ -89,7 +89,8 @@ struct glyf
   template<typename Iterator,
 	   hb_requires (hb_is_source_of (Iterator, unsigned int))>
   static bool
-  _add_loca_and_head (hb_subset_plan_t * plan, Iterator padded_offsets)
+  _add_loca_and_head (hb_subset_plan_t * plan, Iterator padded_offsets,
+		      const int *bounds /* xMin, yMin, xMax, yMax; or nullptr to keep */)
   {
     unsigned max_offset = + padded_offsets | hb_reduce(hb_add, 0);
     unsigned num_offsets = padded_offsets.len () + 1;
@@ -115,7 +116,7 @@ struct glyf
 					    free);
 
     bool result = plan->add_table (HB_OT_TAG_loca, loca_blob)
-		  && _add_head_and_set_loca_version (plan, use_short_loca);
+		  && _add_head_and_set_loca_version (plan, use_short_loca, bounds);
 
     hb_blob_destroy (loca_blob);
     return result;
@@ -140,15 +141,53 @@ struct glyf
     ;
   }
 
-  /* requires source of SubsetGlyph complains the identifier isn't declared */
-  template <typename Iterator>
+  template <typename SubsetGlyph>
   bool serialize (hb_serialize_context_t *c,
-		  Iterator it,
+		  hb_array_t<SubsetGlyph> glyphs,
 		  const hb_subset_plan_t *plan)
   {
     TRACE_SERIALIZE (this);
     unsigned init_len = c->length ();
-    for (const auto &_ : it) _.serialize (c, plan);
+    for (unsigned i = 0; i < glyphs.length;)
+    {
+      if (!glyphs[i].verbatim)
+      {
+	glyphs[i++].serialize (c, plan);
+	continue;
+      }
+
+      /* Glyphs that are copied unchanged and sit back to back in the source
+       * glyf table (common with retain-gids or dense glyph ranges) are
+       * copied with a single memcpy. */
+      const char *run_start = nullptr;
+      const char *run_end = nullptr;
+      unsigned j = i;
+      for (; j < glyphs.length && glyphs[j].verbatim; j++)
+      {
+	hb_bytes_t bytes = glyphs[j].dest_start;
+	if (!bytes.length) continue;
+	if (!run_start) run_start = bytes.arrayZ;
+	else if (bytes.arrayZ != run_end) break;
+	run_end = bytes.arrayZ + bytes.length;
+      }
+
+      if (run_start)
+      {
+	char *dest = c->allocate_size<char> (run_end - run_start);
+	if (unlikely (!dest)) return_trace (false);
+	memcpy (dest, run_start, run_end - run_start);
+
+	if (!plan->retain_gids)
+	  for (; i < j; i++)
+	  {
+	    hb_bytes_t bytes = glyphs[i].dest_start;
+	    if (bytes.length)
+	      SubsetGlyph::remap_component_gids (plan, hb_bytes_t (dest + (bytes.arrayZ - run_start),
+								  bytes.length));
+	  }
+      }
+      i = j;
+    }
 
     /* As a special case when all glyph in the font are empty, add a zero byte
      * to the table, so that OTS doesn’t reject it, and to make the table work
@@ -175,8 +214,22 @@ struct glyf
 
     hb_vector_t<SubsetGlyph> glyphs;
     _populate_subset_glyphs (c->plan, &glyphs);
+    const int *bounds = nullptr;
+#ifndef HB_NO_VAR
+    hb_vector_t<char> instances;
+    int instance_bounds[4];
+    if (c->plan->is_instancing ())
+    {
+      if (unlikely (!_instance_subset_glyphs (c->plan, glyphs, &instances, instance_bounds)))
+      {
+	c->serializer->err_other_error ();
+	return_trace (false);
+      }
+      bounds = instance_bounds;
+    }
+#endif
 
-    glyf_prime->serialize (c->serializer, hb_iter (glyphs), c->plan);
+    glyf_prime->serialize (c->serializer, glyphs.as_array (), c->plan);
 
     auto padded_offsets =
     + hb_iter (glyphs)
@@ -185,7 +238,8 @@ struct glyf
 
     if (c->serializer->in_error ()) return_trace (false);
     return_trace (c->serializer->check_success (_add_loca_and_head (c->plan,
-								    padded_offsets)));
+								    padded_offsets,
+								    bounds)));
   }
 
   template <typename SubsetGlyph>
@@ -206,9 +260,15 @@ struct glyf
 		if (!plan->old_gid_for_new_gid (new_gid, &subset_glyph.old_gid))
 		  return subset_glyph;
 
-		subset_glyph.source_glyph = glyf.glyph_for_gid (subset_glyph.old_gid, true);
+		Glyph glyph = glyf.glyph_for_gid (subset_glyph.old_gid);
+		subset_glyph.source_glyph = glyph.trim_padding ();
 		if (plan->drop_hints) subset_glyph.drop_hints_bytes ();
-		else subset_glyph.dest_start = subset_glyph.source_glyph.get_bytes ();
+		else
+		{
+		  subset_glyph.dest_start = subset_glyph.source_glyph.get_bytes ();
+		  subset_glyph.verbatim = subset_glyph.dest_start.length == glyph.get_bytes ().length &&
+					  !subset_glyph.padding ();
+		}
 
 		return subset_glyph;
 	      })
@@ -218,8 +278,69 @@ struct glyf
     glyf.fini ();
   }
 
+#ifndef HB_NO_VAR
+  /* Replaces the source bytes of each glyph with the glyph compiled at
+   * the pinned location; compiled glyphs are stored in @instances and
+   * their overall bounding box in @bounds (xMin, yMin, xMax, yMax).
+   * Returns false if any glyph fails to compile. */
+  template <typename SubsetGlyph>
+  bool
+  _instance_subset_glyphs (const hb_subset_plan_t   *plan,
+			   hb_vector_t<SubsetGlyph> &glyphs,
+			   hb_vector_t<char>        *instances, /* OUT */
+			   int                       bounds[4] /* OUT */) const
+  {
+    OT::glyf::accelerator_t glyf;
+    glyf.init (plan->source);
+
+    bool ret = true;
+    hb_vector_t<unsigned> ends;
+    for (const SubsetGlyph &glyph : glyphs.as_array ())
+    {
+      if (glyph.length () &&
+	  unlikely (!glyf.compile_instance (plan->instance_font, glyph.old_gid,
+					    plan->drop_hints, *instances)))
+      {
+	ret = false;
+	break;
+      }
+      ends.push (instances->length);
+    }
+
+    glyf.fini ();
+    if (unlikely (!ret || instances->in_error () || ends.in_error ())) return false;
+
+    bool has_bounds = false;
+    bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+    unsigned start = 0;
+    for (unsigned i = 0; i < glyphs.length; i++)
+    {
+      glyphs[i].dest_start = hb_bytes_t (instances->arrayZ + start, ends[i] - start);
+      glyphs[i].dest_end = hb_bytes_t ();
+      glyphs[i].verbatim = false;
+
+      /* Compiled glyphs start with numberOfContours, xMin, yMin, xMax, yMax. */
+      if (ends[i] - start >= 10)
+      {
+	const HBINT16 *header = (const HBINT16 *) (instances->arrayZ + start);
+	for (unsigned j = 0; j < 4; j++)
+	{
+	  int v = header[1 + j];
+	  if (!has_bounds) bounds[j] = v;
+	  else bounds[j] = j < 2 ? hb_min (bounds[j], v) : hb_max (bounds[j], v);
+	}
+	has_bounds = true;
+      }
+
+      start = ends[i];
+    }
+    return true;
+  }
+#endif
+
   static bool
-  _add_head_and_set_loca_version (hb_subset_plan_t *plan, bool use_short_loca)
+  _add_head_and_set_loca_version (hb_subset_plan_t *plan, bool use_short_loca,
+				  const int *bounds)
   {
     hb_blob_t *head_blob = hb_sanitize_context_t ().reference_table<head> (plan->source);
     hb_blob_t *head_prime_blob = hb_blob_copy_writable_or_fail (head_blob);
@@ -230,6 +351,8 @@ struct glyf
 
     head *head_prime = (head *) hb_blob_get_data_writable (head_prime_blob, nullptr);
     head_prime->indexToLocFormat = use_short_loca ? 0 : 1;
+    if (bounds)
+      head_prime->set_bounds (bounds[0], bounds[1], bounds[2], bounds[3]);
     bool success = plan->add_table (HB_OT_TAG_head, head_prime_blob);
 
     hb_blob_destroy (head_prime_blob);
@@ -409,6 +532,15 @@ struct glyf
     PHANTOM_COUNT  = 4
   };
 
+  /* Point buffers for get_points (), one set per nesting level, such that
+   * getting the points of many glyphs in a row doesn't allocate each time. */
+  struct points_scratch_t
+  {
+    contour_point_vector_t all_points;
+    contour_point_vector_t points[HB_MAX_NESTING_LEVEL + 1];
+    contour_point_vector_t comp_points[HB_MAX_NESTING_LEVEL + 1];
+  };
+
   struct Glyph
   {
     enum simple_glyph_flag_t
@@ -697,10 +829,13 @@ struct glyf
     bool get_points (T glyph_for_gid, hb_font_t *font,
 		     contour_point_vector_t &all_points /* OUT */,
 		     bool phantom_only = false,
-		     unsigned int depth = 0) const
+		     unsigned int depth = 0,
+		     points_scratch_t *scratch = nullptr) const
     {
       if (unlikely (depth > HB_MAX_NESTING_LEVEL)) return false;
-      contour_point_vector_t points;
+      contour_point_vector_t local_points;
+      contour_point_vector_t &points = scratch ? scratch->points[depth] : local_points;
+      points.resize (0);
 
       switch (type) {
       case COMPOSITE:
@@ -716,7 +851,11 @@ struct glyf
 	if (unlikely (!SimpleGlyph (*header, bytes).get_contour_points (points, phantom_only)))
 	  return false;
 	break;
-      default: return false; /* empty glyph */
+      default: /* empty glyph */
+	/* As a component, as in a no-break space built from the space, it
+	 * has no outline but still has phantom points. */
+	if (!depth) return false;
+	break;
       }
 
       hb_face_t *face = font->face;
@@ -737,12 +876,13 @@ struct glyf
       }
 
 #ifndef HB_NO_VAR
-      if (unlikely (!face->table.gvar->apply_deltas_to_points (gid, font, points.as_array ())))
+      if (unlikely (!face->table.gvar->apply_deltas_to_points (gid, font, points.as_array (), phantom_only)))
 	return false;
 #endif
 
       switch (type) {
       case SIMPLE:
+      case EMPTY:
 	all_points.extend (points.as_array ());
 	break;
       case COMPOSITE:
@@ -750,8 +890,10 @@ struct glyf
 	unsigned int comp_index = 0;
 	for (auto &item : get_composite_iterator ())
 	{
-	  contour_point_vector_t comp_points;
-	  if (unlikely (!glyph_for_gid (item.glyphIndex).get_points (glyph_for_gid, font, comp_points, phantom_only, depth + 1))
+	  contour_point_vector_t local_comp_points;
+	  contour_point_vector_t &comp_points = scratch ? scratch->comp_points[depth] : local_comp_points;
+	  comp_points.resize (0);
+	  if (unlikely (!glyph_for_gid (item.glyphIndex).get_points (glyph_for_gid, font, comp_points, phantom_only, depth + 1, scratch))
 			|| comp_points.length < PHANTOM_COUNT)
 	    return false;
 
@@ -787,7 +929,6 @@ struct glyf
 
 	all_points.extend (phantoms);
       } break;
-      default: return false;
       }
 
       if (depth == 0) /* Apply at top level */
@@ -803,6 +944,185 @@ struct glyf
       return true;
     }
 
+#ifndef HB_NO_VAR
+    /* Compiles this glyph at the variation location of @font and appends
+     * it to @dest.  gvar deltas are folded into the outline of simple
+     * glyphs and into the offsets of composite ones, and the bounding box
+     * is recomputed.  Points are not shifted by the varied left side
+     * bearing; the instanced hmtx carries it instead. */
+    template<typename T>
+    bool compile_instance (T glyph_for_gid, hb_font_t *font, bool drop_hints,
+			   hb_vector_t<char> &dest /* IN/OUT */) const
+    {
+      if (type == EMPTY) return true;
+
+      contour_point_vector_t all_points;
+      if (unlikely (!get_points (glyph_for_gid, font, all_points, false, 1) ||
+		    all_points.length < PHANTOM_COUNT))
+	return false;
+      unsigned num_points = all_points.length - PHANTOM_COUNT;
+
+      auto round_coord = [] (float v) -> int
+      { return hb_clamp ((int) roundf (v), -32768, 32767); };
+      auto push16 = [&] (int v)
+      {
+	dest.push ((char) ((v >> 8) & 0xFF));
+	dest.push ((char) (v & 0xFF));
+      };
+      auto push_bytes = [&] (hb_bytes_t b)
+      {
+	unsigned l = dest.length;
+	if (likely (dest.resize (l + b.length)))
+	  memcpy (dest.arrayZ + l, b.arrayZ, b.length);
+      };
+
+      int x_min = 0, y_min = 0, x_max = 0, y_max = 0;
+      for (unsigned i = 0; i < num_points; i++)
+      {
+	int x = round_coord (all_points[i].x);
+	int y = round_coord (all_points[i].y);
+	x_min = i ? hb_min (x_min, x) : x;
+	y_min = i ? hb_min (y_min, y) : y;
+	x_max = i ? hb_max (x_max, x) : x;
+	y_max = i ? hb_max (y_max, y) : y;
+      }
+
+      push16 (header->numberOfContours);
+      push16 (x_min);
+      push16 (y_min);
+      push16 (x_max);
+      push16 (y_max);
+
+      switch (type) {
+      case SIMPLE:
+      {
+	const SimpleGlyph glyph (*header, bytes);
+	unsigned instructions_len = drop_hints ? 0 : glyph.instructions_length ();
+	push_bytes (bytes.sub_array (GlyphHeader::static_size, 2 * header->numberOfContours));
+	push16 (instructions_len);
+	push_bytes (bytes.sub_array (glyph.instruction_len_offset () + 2, instructions_len));
+
+	hb_vector_t<uint8_t> flags;
+	hb_vector_t<char> x_bytes, y_bytes;
+	int last_x = 0, last_y = 0;
+	for (unsigned i = 0; i < num_points; i++)
+	{
+	  int x = round_coord (all_points[i].x);
+	  int y = round_coord (all_points[i].y);
+	  int dx = x - last_x, dy = y - last_y;
+	  last_x = x;
+	  last_y = y;
+
+	  /* Overlap bit is only meaningful on the first flag. */
+	  uint8_t flag = all_points[i].flag & (i ? FLAG_ON_CURVE : FLAG_ON_CURVE | FLAG_RESERVED1);
+	  flag |= encode_delta (dx, FLAG_X_SHORT, FLAG_X_SAME, x_bytes);
+	  flag |= encode_delta (dy, FLAG_Y_SHORT, FLAG_Y_SAME, y_bytes);
+	  flags.push (flag);
+	}
+
+	for (unsigned i = 0; i < flags.length;)
+	{
+	  uint8_t flag = flags[i];
+	  unsigned repeat = 0;
+	  while (i + repeat + 1 < flags.length && flags[i + repeat + 1] == flag && repeat < 255)
+	    repeat++;
+	  if (repeat)
+	  {
+	    dest.push ((char) (flag | FLAG_REPEAT));
+	    dest.push ((char) repeat);
+	  }
+	  else
+	    dest.push ((char) flag);
+	  i += repeat + 1;
+	}
+	push_bytes (x_bytes.as_array ());
+	push_bytes (y_bytes.as_array ());
+	if (unlikely (flags.in_error () || x_bytes.in_error () || y_bytes.in_error ()))
+	  return false;
+	break;
+      }
+      case COMPOSITE:
+      {
+	/* Deltas of the component offsets, as in get_points (). */
+	contour_point_vector_t deltas;
+	if (unlikely (!deltas.resize (hb_len (get_composite_iterator ()) + PHANTOM_COUNT)))
+	  return false;
+	for (unsigned i = 0; i < deltas.length; i++)
+	  deltas[i].init ();
+	if (unlikely (!font->face->table.gvar->apply_deltas_to_points (gid, font, deltas.as_array ())))
+	  return false;
+
+	unsigned comp_index = 0;
+	const CompositeGlyphChain *last = nullptr;
+	for (auto &item : get_composite_iterator ())
+	{
+	  last = &item;
+	  hb_bytes_t item_bytes ((const char *) &item, item.get_size ());
+	  int dx = roundf (deltas[comp_index].x);
+	  int dy = roundf (deltas[comp_index].y);
+	  comp_index++;
+	  if (item.is_anchored () || (!dx && !dy))
+	  {
+	    push_bytes (item_bytes);
+	    continue;
+	  }
+
+	  unsigned flags = item.flags;
+	  bool words = flags & CompositeGlyphChain::ARG_1_AND_2_ARE_WORDS;
+	  const HBINT8 *p = &StructAfter<const HBINT8> (item.glyphIndex);
+	  unsigned args_size = words ? 4 : 2;
+	  int tx = words ? (int) ((const HBINT16 *) p)[0] : (int) p[0];
+	  int ty = words ? (int) ((const HBINT16 *) p)[1] : (int) p[1];
+	  tx = hb_clamp (tx + dx, -32768, 32767);
+	  ty = hb_clamp (ty + dy, -32768, 32767);
+	  words = words || tx < -128 || tx > 127 || ty < -128 || ty > 127;
+
+	  push16 (words ? flags | CompositeGlyphChain::ARG_1_AND_2_ARE_WORDS : flags);
+	  push16 (item.glyphIndex);
+	  if (words)
+	  {
+	    push16 (tx);
+	    push16 (ty);
+	  }
+	  else
+	  {
+	    dest.push ((char) tx);
+	    dest.push ((char) ty);
+	  }
+	  push_bytes (item_bytes.sub_array (CompositeGlyphChain::min_size + args_size));
+	}
+
+	if (!drop_hints && last &&
+	    ((uint16_t) last->flags & CompositeGlyphChain::WE_HAVE_INSTRUCTIONS))
+	  push_bytes (bytes.sub_array ((const char *) last - bytes.arrayZ + last->get_size ()));
+	break;
+      }
+      default: return false;
+      }
+
+      return !dest.in_error ();
+    }
+
+    private:
+    static uint8_t encode_delta (int delta,
+				 const simple_glyph_flag_t short_flag,
+				 const simple_glyph_flag_t same_flag,
+				 hb_vector_t<char> &coords /* IN/OUT */)
+    {
+      if (!delta) return same_flag;
+      if (-255 <= delta && delta <= 255)
+      {
+	coords.push ((char) (delta > 0 ? delta : -delta));
+	return delta > 0 ? short_flag | same_flag : short_flag;
+      }
+      coords.push ((char) ((delta >> 8) & 0xFF));
+      coords.push ((char) (delta & 0xFF));
+      return 0;
+    }
+
+    public:
+#endif
+
     bool get_extents (hb_font_t *font, hb_glyph_extents_t *extents) const
     {
       if (type == EMPTY) return true; /* Empty glyph; zero extents. */
@@ -858,17 +1178,20 @@ struct glyf
 
     protected:
     template<typename T>
-    bool get_points (hb_font_t *font, hb_codepoint_t gid, T consumer) const
+    bool get_points (hb_font_t *font, hb_codepoint_t gid, T consumer,
+		     points_scratch_t *scratch = nullptr) const
     {
       /* Making this alloc free is not that easy
 	 https://github.com/harfbuzz/harfbuzz/issues/2095
 	 mostly because of gvar handling in VF fonts,
 	 perhaps a separate path for non-VF fonts can be considered */
-      contour_point_vector_t all_points;
+      contour_point_vector_t local_points;
+      contour_point_vector_t &all_points = scratch ? scratch->all_points : local_points;
+      all_points.resize (0);
 
       bool phantom_only = !consumer.is_consuming_contour_points ();
       if (unlikely (!glyph_for_gid (gid).get_points ([this] (hb_codepoint_t gid) -> const Glyph { return this->glyph_for_gid (gid); },
-						     font, all_points, phantom_only)))
+						     font, all_points, phantom_only, 0, scratch)))
 	return false;
 
       if (consumer.is_consuming_contour_points ())
@@ -979,16 +1302,27 @@ struct glyf
     }
 #endif
 
-    bool get_extents (hb_font_t *font, hb_codepoint_t gid, hb_glyph_extents_t *extents) const
+    /* scratch, if given, is reused for the points of variable glyphs. */
+    bool get_extents (hb_font_t *font, hb_codepoint_t gid, hb_glyph_extents_t *extents,
+		      points_scratch_t *scratch = nullptr) const
     {
       if (unlikely (gid >= num_glyphs)) return false;
 #ifndef HB_NO_VAR
       if (font->num_coords && font->num_coords == face->table.gvar->get_axis_count ())
-	return get_points (font, gid, points_aggregator_t (font, extents, nullptr));
+	return get_points (font, gid, points_aggregator_t (font, extents, nullptr), scratch);
 #endif
       return glyph_for_gid (gid).get_extents (font, extents);
     }
 
+#ifndef HB_NO_VAR
+    bool compile_instance (hb_font_t *font, hb_codepoint_t gid, bool drop_hints,
+			   hb_vector_t<char> &dest /* IN/OUT */) const
+    {
+      return glyph_for_gid (gid).compile_instance ([this] (hb_codepoint_t gid) -> const Glyph { return this->glyph_for_gid (gid); },
+						   font, drop_hints, dest);
+    }
+#endif
+
     const Glyph
     glyph_for_gid (hb_codepoint_t gid, bool needs_padding_removal = false) const
     {
@@ -1166,6 +1500,7 @@ struct glyf
     Glyph source_glyph;
     hb_bytes_t dest_start;  /* region of source_glyph to copy first */
     hb_bytes_t dest_end;    /* region of source_glyph to copy second */
+    bool verbatim;          /* dest_start is the whole, even-sized source glyph */
 
     bool serialize (hb_serialize_context_t *c,
 		    const hb_subset_plan_t *plan) const
@@ -1187,17 +1522,22 @@ struct glyf
 
       if (unlikely (!dest_glyph.length)) return_trace (true);
 
-      /* update components gids */
+      remap_component_gids (plan, dest_glyph);
+
+      if (plan->drop_hints) Glyph (dest_glyph).drop_hints ();
+
+      return_trace (true);
+    }
+
+    /* update components gids */
+    static void remap_component_gids (const hb_subset_plan_t *plan, hb_bytes_t dest_glyph)
+    {
       for (auto &_ : Glyph (dest_glyph).get_composite_iterator ())
       {
 	hb_codepoint_t new_gid;
 	if (plan->new_gid_for_old_gid (_.glyphIndex, &new_gid))
 	  ((OT::glyf::CompositeGlyphChain *) &_)->glyphIndex = new_gid;
       }
-
-      if (plan->drop_hints) Glyph (dest_glyph).drop_hints ();
-
-      return_trace (true);
     }
 
     void drop_hints_bytes ()
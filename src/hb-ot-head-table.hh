@@ -54,6 +54,17 @@ struct head
     return 16 <= upem && upem <= 16384 ? upem : 1000;
   }
 
+  void set_checksum_adjustment (uint32_t adjustment)
+  { checkSumAdjustment = adjustment; }
+
+  void set_bounds (int x_min, int y_min, int x_max, int y_max)
+  {
+    xMin = x_min;
+    yMin = y_min;
+    xMax = x_max;
+    yMax = y_max;
+  }
+
   bool serialize (hb_serialize_context_t *c) const
   {
     TRACE_SERIALIZE (this);
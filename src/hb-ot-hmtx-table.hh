@@ -31,6 +31,7 @@
 #include "hb-ot-hhea-table.hh"
 #include "hb-ot-var-hvar-table.hh"
 #include "hb-ot-metrics.hh"
+#include "hb-ot-var-mvar-table.hh"
 
 /*
  * hmtx -- Horizontal Metrics
@@ -74,7 +75,8 @@ struct hmtxvmtx
 
 
   bool subset_update_header (hb_subset_plan_t *plan,
-			     unsigned int num_hmetrics) const
+			     unsigned int num_hmetrics,
+			     unsigned int max_advance) const
   {
     hb_blob_t *src_blob = hb_sanitize_context_t ().reference_table<H> (plan->source, H::tableTag);
     hb_blob_t *dest_blob = hb_blob_copy_writable_or_fail (src_blob);
@@ -88,6 +90,23 @@ struct hmtxvmtx
     H *table = (H *) hb_blob_get_data (dest_blob, &length);
     table->numberOfLongMetrics = num_hmetrics;
 
+#ifndef HB_NO_VAR
+    if (plan->is_instancing ())
+    {
+      hb_font_t *font = plan->instance_font;
+      const MVAR &mvar = *plan->source->table.MVAR;
+      const int *coords = font->coords;
+      unsigned int num_coords = font->num_coords;
+      mvar.apply_delta (table->ascender, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_ASCENDER : HB_OT_METRICS_TAG_VERTICAL_ASCENDER, coords, num_coords);
+      mvar.apply_delta (table->descender, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_DESCENDER : HB_OT_METRICS_TAG_VERTICAL_DESCENDER, coords, num_coords);
+      mvar.apply_delta (table->lineGap, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_LINE_GAP : HB_OT_METRICS_TAG_VERTICAL_LINE_GAP, coords, num_coords);
+      mvar.apply_delta (table->caretSlopeRise, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_CARET_RISE : HB_OT_METRICS_TAG_VERTICAL_CARET_RISE, coords, num_coords);
+      mvar.apply_delta (table->caretSlopeRun, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_CARET_RUN : HB_OT_METRICS_TAG_VERTICAL_CARET_RUN, coords, num_coords);
+      mvar.apply_delta (table->caretOffset, T::is_horizontal ? HB_OT_METRICS_TAG_HORIZONTAL_CARET_OFFSET : HB_OT_METRICS_TAG_VERTICAL_CARET_OFFSET, coords, num_coords);
+      table->advanceMax = max_advance;
+    }
+#endif
+
     bool result = plan->add_table (H::tableTag, dest_blob);
     hb_blob_destroy (dest_blob);
 
@@ -133,13 +152,22 @@ struct hmtxvmtx
     _mtx.init (c->plan->source);
     unsigned num_advances = _mtx.num_advances_for_subset (c->plan);
 
+    unsigned max_advance = 0;
     auto it =
     + hb_range (c->plan->num_output_glyphs ())
-    | hb_map ([c, &_mtx] (unsigned _)
+    | hb_map ([c, &_mtx, &max_advance] (unsigned _)
 	      {
 		hb_codepoint_t old_gid;
 		if (!c->plan->old_gid_for_new_gid (_, &old_gid))
 		  return hb_pair (0u, 0);
+#ifndef HB_NO_VAR
+		if (c->plan->is_instancing ())
+		{
+		  hb_pair_t<unsigned, int> metrics = _mtx.get_instance_metrics (c->plan->instance_font, old_gid);
+		  max_advance = hb_max (max_advance, metrics.first);
+		  return metrics;
+		}
+#endif
 		return hb_pair (_mtx.get_advance (old_gid), _mtx.get_side_bearing (old_gid));
 	      })
     ;
@@ -152,7 +180,7 @@ struct hmtxvmtx
       return_trace (false);
 
     // Amend header num hmetrics
-    if (unlikely (!subset_update_header (c->plan, num_advances)))
+    if (unlikely (!subset_update_header (c->plan, num_advances, max_advance)))
       return_trace (false);
 
     return_trace (true);
@@ -258,6 +286,49 @@ struct hmtxvmtx
 #endif
     }
 
+    /* Evaluates the variation regions of the metrics variation table at the
+     * location of @font, for get_advance () to reuse over a run of glyphs.
+     * Leaves @scalars empty if there are no such variations to apply. */
+    void get_region_scalars (hb_font_t *font, hb_vector_t<float> &scalars) const
+    {
+      scalars.resize (0);
+#ifndef HB_NO_VAR
+      if (!font->num_coords || !var_table.get_length ()) return;
+      if (unlikely (!scalars.resize (var_table->get_region_count ()))) return;
+      var_table->get_region_scalars (font, scalars.as_array ());
+#endif
+    }
+
+    unsigned int get_advance (hb_codepoint_t           glyph,
+			      hb_font_t               *font,
+			      hb_array_t<const float>  region_scalars) const
+    {
+#ifndef HB_NO_VAR
+      if (region_scalars.length && likely (glyph < num_metrics))
+	return get_advance (glyph) + roundf (var_table->get_advance_var (glyph, region_scalars));
+#endif
+      return get_advance (glyph, font);
+    }
+
+#ifndef HB_NO_VAR
+    /* Advance and side bearing of @glyph at the location of @font, as
+     * written out by the instancer.  The horizontal side bearing is
+     * taken from the varied extents, so it matches the instanced
+     * outline whether or not HVAR carries side bearing deltas. */
+    hb_pair_t<unsigned, int> get_instance_metrics (hb_font_t      *font,
+						   hb_codepoint_t  glyph) const
+    {
+      unsigned advance = get_advance (glyph, font);
+      if (!T::is_horizontal)
+	return hb_pair (advance, get_side_bearing (font, glyph));
+
+      hb_glyph_extents_t extents;
+      if (!hb_font_get_glyph_extents (font, glyph, &extents))
+	return hb_pair (advance, get_side_bearing (font, glyph));
+      return hb_pair (advance, (int) extents.x_bearing);
+    }
+#endif
+
     unsigned int num_advances_for_subset (const hb_subset_plan_t *plan) const
     {
       unsigned int num_advances = plan->num_output_glyphs ();
@@ -281,6 +352,10 @@ struct hmtxvmtx
       if (!plan->old_gid_for_new_gid (new_gid, &old_gid))
 	return 0;
 
+#ifndef HB_NO_VAR
+      if (plan->is_instancing ())
+	return get_advance (old_gid, plan->instance_font);
+#endif
       return get_advance (old_gid);
     }
 
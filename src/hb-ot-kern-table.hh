@@ -126,6 +126,15 @@ struct KernSubTable
     }
   }
 
+  void init_accelerator (AAT::hb_aat_subtable_accelerator_t *accel,
+			 unsigned int num_glyphs) const
+  {
+    switch (get_type ()) {
+    case 0: u.format0.init_accelerator (accel, num_glyphs); return;
+    default:return;
+    }
+  }
+
   template <typename context_t, typename ...Ts>
   typename context_t::return_t dispatch (context_t *c, Ts&&... ds) const
   {
@@ -316,9 +325,35 @@ struct kern
     }
   }
 
+  unsigned int get_subtable_count () const
+  {
+    switch (get_type ()) {
+    case 0: return u.ot.get_subtable_count ();
+#ifndef HB_NO_AAT_SHAPE
+    case 1: return u.aat.get_subtable_count ();
+#endif
+    default:return 0;
+    }
+  }
+
+  void init_accelerators (AAT::hb_aat_subtable_accelerator_t *accels,
+			  unsigned int count,
+			  unsigned int num_glyphs) const
+  {
+    switch (get_type ()) {
+    case 0: u.ot.init_accelerators (accels, count, num_glyphs); return;
+#ifndef HB_NO_AAT_SHAPE
+    case 1: u.aat.init_accelerators (accels, count, num_glyphs); return;
+#endif
+    default:return;
+    }
+  }
+
   bool apply (AAT::hb_aat_apply_context_t *c) const
   { return dispatch (c); }
 
+  typedef AAT::hb_aat_table_accelerator_t<kern> accelerator_t;
+
   template <typename context_t, typename ...Ts>
   typename context_t::return_t dispatch (context_t *c, Ts&&... ds) const
   {
@@ -353,6 +388,8 @@ struct kern
   DEFINE_SIZE_UNION (4, version32);
 };
 
+struct kern_accelerator_t : kern::accelerator_t {};
+
 } /* namespace OT */
 
 
@@ -1495,7 +1495,7 @@ struct Coverage
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto it =
     + iter ()
@@ -1722,7 +1722,7 @@ struct ClassDefFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->_glyphset_gsub;
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     hb_sorted_vector_t<HBGlyphID> glyphs;
     hb_set_t orig_klasses;
@@ -1832,6 +1832,19 @@ struct ClassDefFormat2
     return rangeRecord.bsearch (glyph_id).value;
   }
 
+  bool get_glyph_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  {
+    if (!rangeRecord.len) return false;
+    *first = (hb_codepoint_t) -1;
+    *last = 0;
+    for (const RangeRecord &range : rangeRecord)
+    {
+      *first = hb_min (*first, (hb_codepoint_t) range.first);
+      *last = hb_max (*last, (hb_codepoint_t) range.last);
+    }
+    return *first <= *last;
+  }
+
   template<typename Iterator,
 	   hb_requires (hb_is_iterator (Iterator))>
   bool serialize (hb_serialize_context_t *c,
@@ -1891,7 +1904,7 @@ struct ClassDefFormat2
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->_glyphset_gsub;
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     hb_sorted_vector_t<HBGlyphID> glyphs;
     hb_set_t orig_klasses;
@@ -2011,6 +2024,16 @@ struct ClassDef
     }
   }
 
+  /* For formats where get_class() is a binary search, returns the range of
+   * glyphs outside of which all glyphs are in class 0. */
+  bool get_bsearch_glyph_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  {
+    switch (u.format) {
+    case 2: return u.format2.get_glyph_range (first, last);
+    default:return false;
+    }
+  }
+
   template<typename Iterator,
 	   hb_requires (hb_is_iterator (Iterator))>
   bool serialize (hb_serialize_context_t *c, Iterator it)
@@ -2284,6 +2307,41 @@ struct VarData
    return delta;
   }
 
+  /* Same, picking the scalars from region_scalars, which holds the value
+   * of every region of the store, as from VariationStore::get_region_scalars (). */
+  float get_delta (unsigned int inner,
+		   const float *region_scalars, unsigned int region_count) const
+  {
+    if (unlikely (inner >= itemCount))
+      return 0.;
+
+   unsigned int count = regionIndices.len;
+   unsigned int scount = shortCount;
+
+   const HBUINT8 *bytes = get_delta_bytes ();
+   const HBUINT8 *row = bytes + inner * (scount + count);
+
+   float delta = 0.;
+   unsigned int i = 0;
+
+   const HBINT16 *scursor = reinterpret_cast<const HBINT16 *> (row);
+   for (; i < scount; i++)
+   {
+     unsigned int region_index = regionIndices.arrayZ[i];
+     float scalar = likely (region_index < region_count) ? region_scalars[region_index] : 0.f;
+     delta += scalar * *scursor++;
+   }
+   const HBINT8 *bcursor = reinterpret_cast<const HBINT8 *> (scursor);
+   for (; i < count; i++)
+   {
+     unsigned int region_index = regionIndices.arrayZ[i];
+     float scalar = likely (region_index < region_count) ? region_scalars[region_index] : 0.f;
+     delta += scalar * *bcursor++;
+   }
+
+   return delta;
+  }
+
   void get_scalars (const int *coords, unsigned int coord_count,
 		    const VarRegionList &regions,
 		    float *scalars /*OUT */,
@@ -2296,6 +2354,22 @@ struct VarData
       scalars[i] = 0.f;
   }
 
+  /* Same, picking the scalars from region_scalars, which holds the value
+   * of every region of the store, as from VariationStore::get_region_scalars (). */
+  void get_scalars (const float *region_scalars, unsigned int region_count,
+		    float *scalars /*OUT */,
+		    unsigned int num_scalars) const
+  {
+    unsigned count = hb_min (num_scalars, regionIndices.len);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int region_index = regionIndices.arrayZ[i];
+      scalars[i] = likely (region_index < region_count) ? region_scalars[region_index] : 0.f;
+    }
+    for (unsigned int i = count; i < num_scalars; i++)
+      scalars[i] = 0.f;
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -2447,6 +2521,21 @@ struct VariationStore
     return get_delta (outer, inner, coords, coord_count);
   }
 
+  float get_delta (unsigned int index,
+		   const float *region_scalars, unsigned int region_count) const
+  {
+#ifdef HB_NO_VAR
+    return 0.f;
+#endif
+
+    unsigned int outer = index >> 16;
+    unsigned int inner = index & 0xFFFF;
+    if (unlikely (outer >= dataSets.len))
+      return 0.f;
+
+    return (this+dataSets[outer]).get_delta (inner, region_scalars, region_count);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
 #ifdef HB_NO_VAR
@@ -2550,6 +2639,34 @@ struct VariationStore
 				      &scalars[0], num_scalars);
   }
 
+  void get_scalars (unsigned int ivs,
+		    const float *region_scalars, unsigned int region_count,
+		    float *scalars /*OUT*/,
+		    unsigned int num_scalars) const
+  {
+#ifdef HB_NO_VAR
+    for (unsigned i = 0; i < num_scalars; i++)
+      scalars[i] = 0.f;
+    return;
+#endif
+
+    (this+dataSets[ivs]).get_scalars (region_scalars, region_count,
+				      &scalars[0], num_scalars);
+  }
+
+  unsigned int get_region_count () const { return (this+regions).get_region_count (); }
+
+  /* Evaluates every region of the store at coords, such that the scalars
+   * of any of its subtables can be picked from them without re-evaluating. */
+  void get_region_scalars (const int *coords, unsigned int coord_count,
+			   float *scalars /*OUT*/,
+			   unsigned int num_scalars) const
+  {
+    const VarRegionList &region_list = this+regions;
+    for (unsigned int i = 0; i < num_scalars; i++)
+      scalars[i] = region_list.evaluate (i, coords, coord_count);
+  }
+
   unsigned int get_sub_table_count () const { return dataSets.len; }
 
   protected:
@@ -3028,6 +3145,12 @@ struct VariationDevice
     layout_variation_indices->add (var_idx);
   }
 
+  int get_instance_delta (const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
+  {
+    int delta = layout_variation_idx_delta_map->get ((outerIndex << 16) + innerIndex);
+    return delta == hb_int_min (int) ? 0 : delta;
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -3132,6 +3255,22 @@ struct Device
     }
   }
 
+  /* The delta, in design units, that a variation device table has at the
+   * instance of layout_variation_idx_delta_map.  Other device tables adjust
+   * for pixel sizes only, so have none. */
+  int get_instance_delta (const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
+  {
+    switch (u.b.format)
+    {
+#ifndef HB_NO_VAR
+    case 0x8000:
+      return u.variation.get_instance_delta (layout_variation_idx_delta_map);
+#endif
+    default:
+      return 0;
+    }
+  }
+
   void collect_variation_indices (hb_set_t *layout_variation_indices) const
   {
     switch (u.b.format) {
@@ -104,6 +104,14 @@ struct CaretValueFormat1
     return_trace (true);
   }
 
+  bool serialize (hb_serialize_context_t *c, int coord)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (*this))) return_trace (false);
+    caretValueFormat = 1;
+    return_trace (c->check_assign (coordinate, coord));
+  }
+
   private:
   hb_position_t get_caret_value (hb_font_t *font, hb_direction_t direction) const
   {
@@ -170,6 +178,12 @@ struct CaretValueFormat3
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
+    /* When instancing, the device table folds into the coordinate. */
+    const hb_hashmap_t<unsigned, int> *delta_map = c->plan->layout_variation_idx_delta_map ();
+    if (delta_map)
+      return_trace (c->serializer->start_embed<CaretValueFormat1> ()
+		    ->serialize (c->serializer, coordinate + (this+deviceTable).get_instance_delta (delta_map)));
+
     auto *out = c->serializer->embed (this);
     if (unlikely (!out)) return_trace (false);
 
@@ -341,7 +355,7 @@ struct LigCaretList
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -392,6 +406,10 @@ struct MarkGlyphSetsFormat1
   bool covers (unsigned int set_index, hb_codepoint_t glyph_id) const
   { return (this+coverage[set_index]).get_coverage (glyph_id) != NOT_COVERED; }
 
+  unsigned int get_set_count () const { return coverage.len; }
+  const Coverage &get_coverage (unsigned int set_index) const
+  { return this+coverage[set_index]; }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -445,6 +463,22 @@ struct MarkGlyphSets
     }
   }
 
+  unsigned int get_set_count () const
+  {
+    switch (u.format) {
+    case 1: return u.format1.get_set_count ();
+    default:return 0;
+    }
+  }
+
+  const Coverage &get_coverage (unsigned int set_index) const
+  {
+    switch (u.format) {
+    case 1: return u.format1.get_coverage (set_index);
+    default:return Null (Coverage);
+    }
+  }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -524,6 +558,8 @@ struct GDEF
   bool has_mark_sets () const { return version.to_int () >= 0x00010002u && markGlyphSetsDef != 0; }
   bool mark_set_covers (unsigned int set_index, hb_codepoint_t glyph_id) const
   { return version.to_int () >= 0x00010002u && (this+markGlyphSetsDef).covers (set_index, glyph_id); }
+  const MarkGlyphSets &get_mark_glyph_sets () const
+  { return version.to_int () >= 0x00010002u ? this+markGlyphSetsDef : Null (MarkGlyphSets); }
 
   bool has_var_store () const { return version.to_int () >= 0x00010003u && varStore != 0; }
   const VariationStore &get_var_store () const
@@ -563,11 +599,93 @@ struct GDEF
 	hb_blob_destroy (this->table.get_blob ());
 	this->table = hb_blob_get_empty ();
       }
+
+      /* The dense glyph data is only worth building if there's something
+       * to look up; otherwise the table lookups are trivial already. */
+      this->num_glyphs = this->table->has_glyph_classes () || this->table->has_mark_sets ()
+		       ? face->get_num_glyphs () : 0;
+      this->glyph_data.init ();
     }
 
-    void fini () { this->table.destroy (); }
+    void fini ()
+    {
+      free (this->glyph_data.get ());
+      this->table.destroy ();
+    }
+
+    unsigned int get_glyph_props (hb_codepoint_t glyph) const
+    {
+      const uint32_t *data = glyph < num_glyphs ? get_glyph_data () : nullptr;
+      if (likely (data)) return data[glyph] & 0xFFFFu;
+      return table->get_glyph_props (glyph);
+    }
+
+    bool mark_set_covers (unsigned int set_index, hb_codepoint_t glyph) const
+    {
+      const uint32_t *data = glyph < num_glyphs && set_index < 16 ? get_glyph_data () : nullptr;
+      if (likely (data)) return (data[glyph] >> (16 + set_index)) & 1;
+      return table->mark_set_covers (set_index, glyph);
+    }
 
     hb_blob_ptr_t<GDEF> table;
+
+    private:
+
+    /* For each glyph, the low 16 bits hold its glyph_props (as returned by
+     * GDEF::get_glyph_props ()) and bit 16 + i is set if the glyph is covered
+     * by mark glyph set i, for the first 16 sets. */
+    const uint32_t *get_glyph_data () const
+    {
+      const uint32_t *data = glyph_data.get ();
+      if (likely (data)) return data;
+      return create_glyph_data ();
+    }
+
+    const uint32_t *create_glyph_data () const
+    {
+    retry:
+      uint32_t *data = glyph_data.get ();
+
+      if (unlikely (!data))
+      {
+	data = (uint32_t *) calloc (num_glyphs, sizeof (data[0]));
+	if (unlikely (!data))
+	  return nullptr;
+
+	hb_set_t glyphs;
+	static const unsigned int klasses[] = {BaseGlyph, LigatureGlyph, MarkGlyph};
+	for (unsigned int klass : klasses)
+	{
+	  glyphs.clear ();
+	  table->get_glyphs_in_class (klass, &glyphs);
+	  for (hb_codepoint_t g : glyphs)
+	  {
+	    if (g >= num_glyphs) break;
+	    data[g] = table->get_glyph_props (g);
+	  }
+	}
+
+	const MarkGlyphSets &sets = table->get_mark_glyph_sets ();
+	unsigned int set_count = hb_min (sets.get_set_count (), 16u);
+	for (unsigned int i = 0; i < set_count; i++)
+	  for (hb_codepoint_t g : sets.get_coverage (i).iter ())
+	  {
+	    if (g >= num_glyphs) break;
+	    data[g] |= 1u << (16 + i);
+	  }
+
+	if (unlikely (!glyph_data.cmpexch (nullptr, data)))
+	{
+	  free (data);
+	  goto retry;
+	}
+      }
+
+      return data;
+    }
+
+    unsigned int num_glyphs;
+    mutable hb_atomic_ptr_t<uint32_t *> glyph_data;
   };
 
   unsigned int get_size () const
@@ -628,7 +746,14 @@ struct GDEF
     bool subset_varstore = true;
     if (version.to_int () >= 0x00010003u)
     {
-      subset_varstore = out->varStore.serialize_subset (c, varStore, this);
+      /* An instance has its deltas folded into the values already. */
+      if (c->plan->is_instancing ())
+      {
+        out->varStore = 0;
+        subset_varstore = false;
+      }
+      else
+        subset_varstore = out->varStore.serialize_subset (c, varStore, this);
       if (!subset_varstore && version.to_int () == 0x00010003u)
         out->version.minor = 2;
     }
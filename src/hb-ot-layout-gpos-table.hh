@@ -54,6 +54,28 @@ enum attach_type_t {
 };
 
 
+/* Whether all subtables of a lookup only ever add to glyph positions, or
+ * assign to the position of the glyph they matched on.  Such lookups with
+ * disjoint coverage can be applied in the same pass over the buffer. */
+struct hb_fusable_context_t :
+       hb_dispatch_context_t<hb_fusable_context_t, bool, 0>
+{
+  const char *get_name () { return "FUSABLE"; }
+  template <typename T>
+  auto _dispatch (const T &obj, hb_priority<1>) HB_AUTO_RETURN (obj.is_fusable ())
+  template <typename T>
+  bool _dispatch (const T &obj HB_UNUSED, hb_priority<0>) { return false; }
+  template <typename T>
+  return_t dispatch (const T &obj) { return _dispatch (obj, hb_prioritize); }
+  static return_t default_return_value () { return true; }
+  bool stop_sublookup_iteration (return_t r) const { return !r; }
+
+  unsigned int debug_depth;
+
+  hb_fusable_context_t () : debug_depth (0) {}
+};
+
+
 /* Shared Tables: ValueRecord, Anchor Table, and MarkArray */
 
 typedef HBUINT16 Value;
@@ -77,6 +99,8 @@ struct ValueFormat : HBUINT16
     devices	= 0x00F0u	/* Mask for having any Device table */
   };
 
+  ValueFormat& operator = (uint16_t i) { HBUINT16::operator= (i); return *this; }
+
 /* All fields are options.  Only those available advance the value pointer. */
 #if 0
   HBINT16		xPlacement;		/* Horizontal adjustment for
@@ -160,12 +184,28 @@ struct ValueFormat : HBUINT16
     return ret;
   }
 
+  /* When instancing, each device table folds into the value it adjusts. */
+  unsigned get_output_format (const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
+  {
+    unsigned int format = *this;
+    if (!layout_variation_idx_delta_map) return format;
+    return (format & ~devices) | ((format & devices) >> 4);
+  }
+
+  /* Writes values in get_output_format (). */
   void serialize_copy (hb_serialize_context_t *c, const void *base,
-                       const Value *values, const hb_map_t *layout_variation_idx_map) const
+                       const Value *values, const hb_map_t *layout_variation_idx_map,
+                       const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
   {
     unsigned int format = *this;
     if (!format) return;
 
+    if (layout_variation_idx_delta_map)
+    {
+      serialize_instance (c, base, values, layout_variation_idx_delta_map);
+      return;
+    }
+
     if (format & xPlacement) c->copy (*values++);
     if (format & yPlacement) c->copy (*values++);
     if (format & xAdvance)   c->copy (*values++);
@@ -215,6 +255,26 @@ struct ValueFormat : HBUINT16
   }
 
   private:
+  void serialize_instance (hb_serialize_context_t *c, const void *base,
+                           const Value *values,
+                           const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
+  {
+    unsigned int format = *this;
+    const Value *device = values + hb_popcount (format & (xPlacement | yPlacement | xAdvance | yAdvance));
+    for (unsigned flag = xPlacement; flag <= yAdvance; flag <<= 1)
+    {
+      unsigned device_flag = flag << 4;
+      if (!(format & (flag | device_flag))) continue;
+
+      int value = format & flag ? (int) get_short (values++) : 0;
+      if (format & device_flag)
+        value += (base + get_device (device++)).get_instance_delta (layout_variation_idx_delta_map);
+
+      HBINT16 *out = c->allocate_size<HBINT16> (HBINT16::static_size);
+      if (unlikely (!out || !c->check_assign (*out, value))) return;
+    }
+  }
+
   bool sanitize_value_devices (hb_sanitize_context_t *c, const void *base, const Value *values) const
   {
     unsigned int format = *this;
@@ -278,6 +338,12 @@ struct ValueFormat : HBUINT16
     return (format & devices) != 0;
   }
 
+  bool has_placement () const
+  {
+    unsigned int format = *this;
+    return (format & (xPlacement | yPlacement | xPlaDevice | yPlaDevice)) != 0;
+  }
+
   bool sanitize_value (hb_sanitize_context_t *c, const void *base, const Value *values) const
   {
     TRACE_SANITIZE (this);
@@ -324,7 +390,8 @@ static void SinglePos_serialize (hb_serialize_context_t *c,
 				 const void *src,
 				 Iterator it,
 				 ValueFormat valFormat,
-                                 const hb_map_t *layout_variation_idx_map);
+                                 const hb_map_t *layout_variation_idx_map,
+                                 const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map);
 
 
 struct AnchorFormat1
@@ -343,6 +410,16 @@ struct AnchorFormat1
     return_trace (c->check_struct (this));
   }
 
+  AnchorFormat1* serialize (hb_serialize_context_t *c, int x, int y)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (*this))) return_trace (nullptr);
+    format = 1;
+    if (unlikely (!c->check_assign (xCoordinate, x) ||
+		  !c->check_assign (yCoordinate, y))) return_trace (nullptr);
+    return_trace (this);
+  }
+
   AnchorFormat1* copy (hb_serialize_context_t *c) const
   {
     TRACE_SERIALIZE (this);
@@ -437,6 +514,16 @@ struct AnchorFormat3
     return_trace (out);
   }
 
+  /* When instancing, the device tables fold into the coordinates. */
+  AnchorFormat1* copy_instance (hb_serialize_context_t *c,
+				const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
+  {
+    TRACE_SERIALIZE (this);
+    int x = xCoordinate + (this+xDeviceTable).get_instance_delta (layout_variation_idx_delta_map);
+    int y = yCoordinate + (this+yDeviceTable).get_instance_delta (layout_variation_idx_delta_map);
+    return_trace (c->start_embed<AnchorFormat1> ()->serialize (c, x, y));
+  }
+
   void collect_variation_indices (hb_collect_variation_indices_context_t *c) const
   {
     (this+xDeviceTable).collect_variation_indices (c->layout_variation_indices);
@@ -485,13 +572,16 @@ struct Anchor
     }
   }
 
-  Anchor* copy (hb_serialize_context_t *c, const hb_map_t *layout_variation_idx_map) const
+  Anchor* copy (hb_serialize_context_t *c, const hb_map_t *layout_variation_idx_map,
+		const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
   {
     TRACE_SERIALIZE (this);
     switch (u.format) {
     case 1: return_trace (reinterpret_cast<Anchor *> (u.format1.copy (c)));
     case 2: return_trace (reinterpret_cast<Anchor *> (u.format2.copy (c)));
-    case 3: return_trace (reinterpret_cast<Anchor *> (u.format3.copy (c, layout_variation_idx_map)));
+    case 3: return_trace (layout_variation_idx_delta_map
+			  ? reinterpret_cast<Anchor *> (u.format3.copy_instance (c, layout_variation_idx_delta_map))
+			  : reinterpret_cast<Anchor *> (u.format3.copy (c, layout_variation_idx_map)));
     default:return_trace (nullptr);
     }
   }
@@ -546,6 +636,7 @@ struct AnchorMatrix
 		  unsigned                num_rows,
 		  AnchorMatrix const     *offset_matrix,
                   const hb_map_t         *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map,
 		  Iterator                index_iter)
   {
     TRACE_SERIALIZE (this);
@@ -560,7 +651,8 @@ struct AnchorMatrix
       offset->serialize_copy (c, offset_matrix->matrixZ[i],
                               offset_matrix, c->to_bias (this),
                               hb_serialize_context_t::Head,
-                              layout_variation_idx_map);
+                              layout_variation_idx_map,
+                              layout_variation_idx_delta_map);
     }
 
     return_trace (true);
@@ -602,14 +694,16 @@ struct MarkRecord
 		    const void             *src_base,
 		    unsigned                dst_bias,
 		    const hb_map_t         *klass_mapping,
-		    const hb_map_t         *layout_variation_idx_map) const
+		    const hb_map_t         *layout_variation_idx_map,
+		    const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
   {
     TRACE_SERIALIZE (this);
     auto *out = c->embed (this);
     if (unlikely (!out)) return_trace (nullptr);
 
     out->klass = klass_mapping->get (klass);
-    out->markAnchor.serialize_copy (c, markAnchor, src_base, dst_bias, hb_serialize_context_t::Head, layout_variation_idx_map);
+    out->markAnchor.serialize_copy (c, markAnchor, src_base, dst_bias, hb_serialize_context_t::Head,
+				    layout_variation_idx_map, layout_variation_idx_delta_map);
     return_trace (out);
   }
 
@@ -669,13 +763,14 @@ struct MarkArray : ArrayOf<MarkRecord>	/* Array of MarkRecords--in Coverage orde
   bool serialize (hb_serialize_context_t *c,
 		  const hb_map_t         *klass_mapping,
                   const hb_map_t         *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map,
 		  const void             *base,
 		  Iterator                it)
   {
     TRACE_SERIALIZE (this);
     if (unlikely (!c->extend_min (*this))) return_trace (false);
     if (unlikely (!c->check_assign (len, it.len ()))) return_trace (false);
-    c->copy_all (it, base, c->to_bias (this), klass_mapping, layout_variation_idx_map);
+    c->copy_all (it, base, c->to_bias (this), klass_mapping, layout_variation_idx_map, layout_variation_idx_delta_map);
     return_trace (true);
   }
 
@@ -713,6 +808,8 @@ struct SinglePosFormat1
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  bool is_fusable () const { return true; }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -732,16 +829,17 @@ struct SinglePosFormat1
 		  const void *src,
 		  Iterator it,
 		  ValueFormat valFormat,
-                  const hb_map_t *layout_variation_idx_map)
+                  const hb_map_t *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
   {
     auto out = c->extend_min (*this);
     if (unlikely (!out)) return;
-    if (unlikely (!c->check_assign (valueFormat, valFormat))) return;
+    if (unlikely (!c->check_assign (valueFormat, valFormat.get_output_format (layout_variation_idx_delta_map)))) return;
 
     + it
     | hb_map (hb_second)
     | hb_apply ([&] (hb_array_t<const Value> _)
-		{ valFormat.serialize_copy (c, src, &_, layout_variation_idx_map); })
+		{ valFormat.serialize_copy (c, src, &_, layout_variation_idx_map, layout_variation_idx_delta_map); })
     ;
 
     auto glyphs =
@@ -756,7 +854,7 @@ struct SinglePosFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto it =
     + hb_iter (this+coverage)
@@ -766,7 +864,8 @@ struct SinglePosFormat1
     ;
 
     bool ret = bool (it);
-    SinglePos_serialize (c->serializer, this, it, valueFormat, c->plan->layout_variation_idx_map);
+    SinglePos_serialize (c->serializer, this, it, valueFormat,
+			 c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map ());
     return_trace (ret);
   }
 
@@ -823,6 +922,8 @@ struct SinglePosFormat2
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  bool is_fusable () const { return true; }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -846,17 +947,18 @@ struct SinglePosFormat2
 		  const void *src,
 		  Iterator it,
 		  ValueFormat valFormat,
-                  const hb_map_t *layout_variation_idx_map)
+                  const hb_map_t *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
   {
     auto out = c->extend_min (*this);
     if (unlikely (!out)) return;
-    if (unlikely (!c->check_assign (valueFormat, valFormat))) return;
+    if (unlikely (!c->check_assign (valueFormat, valFormat.get_output_format (layout_variation_idx_delta_map)))) return;
     if (unlikely (!c->check_assign (valueCount, it.len ()))) return;
 
     + it
     | hb_map (hb_second)
     | hb_apply ([&] (hb_array_t<const Value> _)
-		{ valFormat.serialize_copy (c, src, &_, layout_variation_idx_map); })
+		{ valFormat.serialize_copy (c, src, &_, layout_variation_idx_map, layout_variation_idx_delta_map); })
     ;
 
     auto glyphs =
@@ -871,7 +973,7 @@ struct SinglePosFormat2
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     unsigned sub_length = valueFormat.get_len ();
     auto values_array = values.as_array (valueCount * sub_length);
@@ -888,7 +990,8 @@ struct SinglePosFormat2
     ;
 
     bool ret = bool (it);
-    SinglePos_serialize (c->serializer, this, it, valueFormat, c->plan->layout_variation_idx_map);
+    SinglePos_serialize (c->serializer, this, it, valueFormat,
+			 c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map ());
     return_trace (ret);
   }
 
@@ -937,7 +1040,8 @@ struct SinglePos
 		  const void *src,
 		  Iterator glyph_val_iter_pairs,
 		  ValueFormat valFormat,
-                  const hb_map_t *layout_variation_idx_map)
+                  const hb_map_t *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
   {
     if (unlikely (!c->extend_min (u.format))) return;
     unsigned format = 2;
@@ -946,9 +1050,9 @@ struct SinglePos
 
     u.format = format;
     switch (u.format) {
-    case 1: u.format1.serialize (c, src, glyph_val_iter_pairs, valFormat, layout_variation_idx_map);
+    case 1: u.format1.serialize (c, src, glyph_val_iter_pairs, valFormat, layout_variation_idx_map, layout_variation_idx_delta_map);
 	    return;
-    case 2: u.format2.serialize (c, src, glyph_val_iter_pairs, valFormat, layout_variation_idx_map);
+    case 2: u.format2.serialize (c, src, glyph_val_iter_pairs, valFormat, layout_variation_idx_map, layout_variation_idx_delta_map);
 	    return;
     default:return;
     }
@@ -980,8 +1084,9 @@ SinglePos_serialize (hb_serialize_context_t *c,
 		     const void *src,
 		     Iterator it,
 		     ValueFormat valFormat,
-                     const hb_map_t *layout_variation_idx_map)
-{ c->start_embed<SinglePos> ()->serialize (c, src, it, valFormat, layout_variation_idx_map); }
+                     const hb_map_t *layout_variation_idx_map,
+                     const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
+{ c->start_embed<SinglePos> ()->serialize (c, src, it, valFormat, layout_variation_idx_map, layout_variation_idx_delta_map); }
 
 
 struct PairValueRecord
@@ -996,8 +1101,9 @@ struct PairValueRecord
     const void 		*base;
     const ValueFormat	*valueFormats;
     unsigned		len1; /* valueFormats[0].get_len() */
-    const hb_map_t 	*glyph_map;
+    const hb_dense_map_t *glyph_map;
     const hb_map_t      *layout_variation_idx_map;
+    const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map;
   };
 
   bool serialize (hb_serialize_context_t *c,
@@ -1009,8 +1115,10 @@ struct PairValueRecord
 
     out->secondGlyph = (*closure->glyph_map)[secondGlyph];
 
-    closure->valueFormats[0].serialize_copy (c, closure->base, &values[0], closure->layout_variation_idx_map);
-    closure->valueFormats[1].serialize_copy (c, closure->base, &values[closure->len1], closure->layout_variation_idx_map);
+    closure->valueFormats[0].serialize_copy (c, closure->base, &values[0],
+					     closure->layout_variation_idx_map, closure->layout_variation_idx_delta_map);
+    closure->valueFormats[1].serialize_copy (c, closure->base, &values[closure->len1],
+					     closure->layout_variation_idx_map, closure->layout_variation_idx_delta_map);
 
     return_trace (true);
   }
@@ -1130,7 +1238,7 @@ struct PairSet
     out->len = 0;
 
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     unsigned len1 = valueFormats[0].get_len ();
     unsigned len2 = valueFormats[1].get_len ();
@@ -1142,7 +1250,8 @@ struct PairSet
       valueFormats,
       len1,
       &glyph_map,
-      c->plan->layout_variation_idx_map
+      c->plan->layout_variation_idx_map,
+      c->plan->layout_variation_idx_delta_map ()
     };
 
     const PairValueRecord *record = &firstPairValueRecord;
@@ -1232,6 +1341,10 @@ struct PairPosFormat1
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  /* Placement adjustments to the second glyph would not commute with mark
+   * attachment to it. */
+  bool is_fusable () const { return !valueFormat[1].has_placement (); }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -1251,13 +1364,13 @@ struct PairPosFormat1
     TRACE_SUBSET (this);
 
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
     out->format = format;
-    out->valueFormat[0] = valueFormat[0];
-    out->valueFormat[1] = valueFormat[1];
+    out->valueFormat[0] = valueFormat[0].get_output_format (c->plan->layout_variation_idx_delta_map ());
+    out->valueFormat[1] = valueFormat[1].get_output_format (c->plan->layout_variation_idx_delta_map ());
 
     hb_sorted_vector_t<hb_codepoint_t> new_coverage;
 
@@ -1373,7 +1486,16 @@ struct PairPosFormat2
 
   const Coverage &get_coverage () const { return this+coverage; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  bool is_fusable () const { return !valueFormat2.has_placement (); }
+
+  void init_class_caches (hb_class_cache_t *class_caches) const
+  {
+    class_caches[0].init (this+classDef1);
+    class_caches[1].init (this+classDef2);
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      const hb_class_cache_t *class_caches = nullptr) const
   {
     TRACE_APPLY (this);
     hb_buffer_t *buffer = c->buffer;
@@ -1388,8 +1510,17 @@ struct PairPosFormat2
     unsigned int len2 = valueFormat2.get_len ();
     unsigned int record_len = len1 + len2;
 
-    unsigned int klass1 = (this+classDef1).get_class (buffer->cur().codepoint);
-    unsigned int klass2 = (this+classDef2).get_class (buffer->info[skippy_iter.idx].codepoint);
+    unsigned int klass1, klass2;
+    if (class_caches)
+    {
+      klass1 = class_caches[0].get_class (buffer->cur().codepoint);
+      klass2 = class_caches[1].get_class (buffer->info[skippy_iter.idx].codepoint);
+    }
+    else
+    {
+      klass1 = (this+classDef1).get_class (buffer->cur().codepoint);
+      klass2 = (this+classDef2).get_class (buffer->info[skippy_iter.idx].codepoint);
+    }
     if (unlikely (klass1 >= class1Count || klass2 >= class2Count)) return_trace (false);
 
     const Value *v = &values[record_len * (klass1 * class2Count + klass2)];
@@ -1411,8 +1542,8 @@ struct PairPosFormat2
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
     out->format = format;
-    out->valueFormat1 = valueFormat1;
-    out->valueFormat2 = valueFormat2;
+    out->valueFormat1 = valueFormat1.get_output_format (c->plan->layout_variation_idx_delta_map ());
+    out->valueFormat2 = valueFormat2.get_output_format (c->plan->layout_variation_idx_delta_map ());
 
     hb_map_t klass1_map;
     out->classDef1.serialize_subset (c, classDef1, this, &klass1_map);
@@ -1434,15 +1565,19 @@ struct PairPosFormat2
                   | hb_apply ([&] (const unsigned class2_idx)
                               {
                                 unsigned idx = (class1_idx * (unsigned) class2Count + class2_idx) * (len1 + len2);
-                                valueFormat1.serialize_copy (c->serializer, this, &values[idx], c->plan->layout_variation_idx_map);
-                                valueFormat2.serialize_copy (c->serializer, this, &values[idx + len1], c->plan->layout_variation_idx_map);
+                                valueFormat1.serialize_copy (c->serializer, this, &values[idx],
+                                                             c->plan->layout_variation_idx_map,
+                                                             c->plan->layout_variation_idx_delta_map ());
+                                valueFormat2.serialize_copy (c->serializer, this, &values[idx + len1],
+                                                             c->plan->layout_variation_idx_map,
+                                                             c->plan->layout_variation_idx_delta_map ());
                               })
                   ;
                 })
     ;
 
     const hb_set_t &glyphset = *c->plan->_glyphset_gsub;
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto it =
     + hb_iter (this+coverage)
@@ -1547,14 +1682,17 @@ struct EntryExitRecord
   EntryExitRecord* copy (hb_serialize_context_t *c,
 			 const void *src_base,
 			 const void *dst_base,
-                         const hb_map_t *layout_variation_idx_map) const
+                         const hb_map_t *layout_variation_idx_map,
+                         const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map) const
   {
     TRACE_SERIALIZE (this);
     auto *out = c->embed (this);
     if (unlikely (!out)) return_trace (nullptr);
 
-    out->entryAnchor.serialize_copy (c, entryAnchor, src_base, c->to_bias (dst_base), hb_serialize_context_t::Head, layout_variation_idx_map);
-    out->exitAnchor.serialize_copy (c, exitAnchor, src_base, c->to_bias (dst_base), hb_serialize_context_t::Head, layout_variation_idx_map);
+    out->entryAnchor.serialize_copy (c, entryAnchor, src_base, c->to_bias (dst_base), hb_serialize_context_t::Head,
+				     layout_variation_idx_map, layout_variation_idx_delta_map);
+    out->exitAnchor.serialize_copy (c, exitAnchor, src_base, c->to_bias (dst_base), hb_serialize_context_t::Head,
+				    layout_variation_idx_map, layout_variation_idx_delta_map);
     return_trace (out);
   }
 
@@ -1701,7 +1839,8 @@ struct CursivePosFormat1
   void serialize (hb_serialize_context_t *c,
 		  Iterator it,
 		  const void *src_base,
-                  const hb_map_t *layout_variation_idx_map)
+                  const hb_map_t *layout_variation_idx_map,
+                  const hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
   {
     if (unlikely (!c->extend_min ((*this)))) return;
     this->format = 1;
@@ -1709,7 +1848,7 @@ struct CursivePosFormat1
 
     for (const EntryExitRecord& entry_record : + it
 					       | hb_map (hb_second))
-      c->copy (entry_record, src_base, this, layout_variation_idx_map);
+      c->copy (entry_record, src_base, this, layout_variation_idx_map, layout_variation_idx_delta_map);
 
     auto glyphs =
     + it
@@ -1723,7 +1862,7 @@ struct CursivePosFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!out)) return_trace (false);
@@ -1736,7 +1875,8 @@ struct CursivePosFormat1
     ;
 
     bool ret = bool (it);
-    out->serialize (c->serializer, it, this, c->plan->layout_variation_idx_map);
+    out->serialize (c->serializer, it, this,
+		    c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map ());
     return_trace (ret);
   }
 
@@ -1853,6 +1993,8 @@ struct MarkBasePosFormat1
 
   const Coverage &get_coverage () const { return this+markCoverage; }
 
+  bool is_fusable () const { return true; }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -1897,7 +2039,7 @@ struct MarkBasePosFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -1926,7 +2068,7 @@ struct MarkBasePosFormat1
       return_trace (false);
 
     out->markArray.serialize (c->serializer, out)
-		  .serialize (c->serializer, &klass_mapping, c->plan->layout_variation_idx_map, &(this+markArray), + mark_iter
+		  .serialize (c->serializer, &klass_mapping, c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map (), &(this+markArray), + mark_iter
 										                                   | hb_map (hb_second));
 
     unsigned basecount = (this+baseArray).rows;
@@ -1957,7 +2099,9 @@ struct MarkBasePosFormat1
       ;
     }
     out->baseArray.serialize (c->serializer, out)
-		  .serialize (c->serializer, base_iter.len (), &(this+baseArray), c->plan->layout_variation_idx_map, base_indexes.iter ());
+		  .serialize (c->serializer, base_iter.len (), &(this+baseArray),
+			      c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map (),
+			      base_indexes.iter ());
 
     return_trace (true);
   }
@@ -2074,6 +2218,8 @@ struct MarkLigPosFormat1
 
   const Coverage &get_coverage () const { return this+markCoverage; }
 
+  bool is_fusable () const { return true; }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -2226,6 +2372,8 @@ struct MarkMarkPosFormat1
 
   const Coverage &get_coverage () const { return this+mark1Coverage; }
 
+  bool is_fusable () const { return true; }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -2274,7 +2422,7 @@ struct MarkMarkPosFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -2303,7 +2451,7 @@ struct MarkMarkPosFormat1
       return_trace (false);
 
     out->mark1Array.serialize (c->serializer, out)
-		   .serialize (c->serializer, &klass_mapping, c->plan->layout_variation_idx_map, &(this+mark1Array), + mark1_iter
+		   .serialize (c->serializer, &klass_mapping, c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map (), &(this+mark1Array), + mark1_iter
 										                                     | hb_map (hb_second));
     
     unsigned mark2count = (this+mark2Array).rows;
@@ -2334,7 +2482,9 @@ struct MarkMarkPosFormat1
       ;
     }
     out->mark2Array.serialize (c->serializer, out)
-		   .serialize (c->serializer, mark2_iter.len (), &(this+mark2Array), c->plan->layout_variation_idx_map, mark2_indexes.iter ());
+		   .serialize (c->serializer, mark2_iter.len (), &(this+mark2Array),
+			       c->plan->layout_variation_idx_map, c->plan->layout_variation_idx_delta_map (),
+			       mark2_indexes.iter ());
 
     return_trace (true);
   }
@@ -2483,6 +2633,12 @@ struct PosLookup : Lookup
     return_trace (dispatch (c));
   }
 
+  bool is_fusable () const
+  {
+    hb_fusable_context_t c;
+    return dispatch (&c);
+  }
+
   bool intersects (const hb_set_t *glyphs) const
   {
     hb_intersects_context_t c (glyphs);
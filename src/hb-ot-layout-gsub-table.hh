@@ -41,6 +41,140 @@ static void SingleSubst_serialize (hb_serialize_context_t *c,
 				   Iterator it);
 
 
+/* Gathers the substitutions of a lookup's subtables, and flattens them
+ * into an hb_compiled_lookup_t if they are all of a compilable type. */
+struct hb_compile_subst_context_t :
+       hb_dispatch_context_t<hb_compile_subst_context_t, hb_empty_t, HB_DEBUG_APPLY>
+{
+  enum type_t {
+    NONE,
+    SINGLE,
+    LIGATURE
+  };
+
+  const char *get_name () { return "COMPILE"; }
+  template <typename T>
+  auto _dispatch (const T &obj, hb_priority<1>) HB_AUTO_RETURN (obj.compile (this))
+  template <typename T>
+  void _dispatch (const T &obj HB_UNUSED, hb_priority<0>) { compilable = false; }
+  template <typename T>
+  return_t dispatch (const T &obj) { _dispatch (obj, hb_prioritize); return hb_empty_t (); }
+  static return_t default_return_value () { return hb_empty_t (); }
+
+  void add_single (hb_codepoint_t glyph, hb_codepoint_t substitute)
+  { add (SINGLE, glyph, substitute, nullptr); }
+  void add_ligature (hb_codepoint_t first, hb_codepoint_t second, const void *ligature)
+  { add (LIGATURE, first, second, ligature); }
+
+  /* Returns the type of lookup compiled into out, or NONE. */
+  type_t compile (hb_compiled_lookup_t *out)
+  {
+    if (!compilable || !entries.length) return NONE;
+
+    /* Earlier subtables take precedence; keep their entries first. */
+    entries.qsort (cmp_entry);
+
+    unsigned int glyph_count = 0;
+    for (unsigned int i = 0; i < entries.length; i++)
+      if (!i || entries[i].glyph != entries[i - 1].glyph)
+	glyph_count++;
+
+    /* Only worth it, memory-wise, if the covered glyphs are dense enough. */
+    hb_codepoint_t first = entries[0].glyph;
+    unsigned int span = entries[entries.length - 1].glyph - first + 1;
+    if (span > 64 + 16 * glyph_count) return NONE;
+
+    out->first_glyph = first;
+    if (type == SINGLE)
+    {
+      if (unlikely (!out->map.resize (span))) return fail (out);
+      for (unsigned int i = 0; i < span; i++)
+	out->map[i] = hb_compiled_lookup_t::NOT_MAPPED;
+      for (unsigned int i = 0; i < entries.length; i++)
+      {
+	const entry_t &entry = entries[i];
+	if (i && entry.glyph == entries[i - 1].glyph) continue;
+	if (unlikely (entry.value == hb_compiled_lookup_t::NOT_MAPPED)) return fail (out);
+	out->map[entry.glyph - first] = entry.value;
+      }
+    }
+    else
+    {
+      if (unlikely (entries.length > 0xFFFFu)) return fail (out);
+      if (unlikely (!out->map.resize (span + 1) ||
+		    !out->ligatures.resize (entries.length))) return fail (out);
+      unsigned int j = 0;
+      for (unsigned int i = 0; i <= span; i++)
+      {
+	while (j < entries.length && entries[j].glyph - first < i)
+	  j++;
+	out->map[i] = j;
+      }
+      for (unsigned int i = 0; i < entries.length; i++)
+      {
+	out->ligatures[i].ligature = entries[i].ligature;
+	out->ligatures[i].second = entries[i].value;
+      }
+    }
+
+    return type;
+  }
+
+  hb_compile_subst_context_t () :
+			      type (NONE),
+			      compilable (true),
+			      debug_depth (0) {}
+
+  private:
+  struct entry_t
+  {
+    hb_codepoint_t glyph;
+    unsigned int seq;
+    hb_codepoint_t value;
+    const void *ligature;
+  };
+
+  static int cmp_entry (const void *pa, const void *pb)
+  {
+    const entry_t *a = (const entry_t *) pa;
+    const entry_t *b = (const entry_t *) pb;
+    if (a->glyph != b->glyph) return a->glyph < b->glyph ? -1 : 1;
+    return a->seq < b->seq ? -1 : a->seq > b->seq ? 1 : 0;
+  }
+
+  void add (type_t type_, hb_codepoint_t glyph, hb_codepoint_t value, const void *ligature)
+  {
+    if (unlikely (type != type_ && type != NONE)) compilable = false;
+    type = type_;
+    if (!compilable) return;
+
+    entry_t *entry = entries.push ();
+    if (unlikely (entries.in_error ()))
+    {
+      compilable = false;
+      return;
+    }
+    entry->glyph = glyph;
+    entry->seq = entries.length - 1;
+    entry->value = value;
+    entry->ligature = ligature;
+  }
+
+  type_t fail (hb_compiled_lookup_t *out)
+  {
+    out->fini ();
+    out->init ();
+    return NONE;
+  }
+
+  type_t type;
+  bool compilable;
+  hb_vector_t<entry_t> entries;
+  public:
+  unsigned int debug_depth;
+};
+
+
 struct SingleSubstFormat1
 {
   bool intersects (const hb_set_t *glyphs) const
@@ -70,6 +204,13 @@ struct SingleSubstFormat1
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  void compile (hb_compile_subst_context_t *c) const
+  {
+    unsigned d = deltaGlyphID;
+    for (hb_codepoint_t g : (this+coverage).iter ())
+      c->add_single (g, (g + d) & 0xFFFFu);
+  }
+
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
@@ -105,7 +246,7 @@ struct SingleSubstFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset_gsub ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     hb_codepoint_t delta = deltaGlyphID;
 
@@ -169,6 +310,12 @@ struct SingleSubstFormat2
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  void compile (hb_compile_subst_context_t *c) const
+  {
+    for (const hb_pair_t<hb_codepoint_t, const HBGlyphID &> _ : + hb_zip (this+coverage, substitute))
+      c->add_single (_.first, _.second);
+  }
+
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
@@ -210,7 +357,7 @@ struct SingleSubstFormat2
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset_gsub ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto it =
     + hb_zip (this+coverage, substitute)
@@ -287,6 +434,18 @@ struct SingleSubst
     }
   }
 
+  static bool apply_compiled (const hb_compiled_lookup_t *l, hb_ot_apply_context_t *c)
+  {
+    unsigned int i = c->buffer->cur().codepoint - l->first_glyph;
+    if (i >= l->map.length) return false;
+
+    hb_codepoint_t glyph_id = l->map.arrayZ[i];
+    if (glyph_id == hb_compiled_lookup_t::NOT_MAPPED) return false;
+
+    c->replace_glyph (glyph_id);
+    return true;
+  }
+
   protected:
   union {
   HBUINT16		format;		/* Format identifier */
@@ -357,7 +516,7 @@ struct Sequence
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     if (!intersects (&glyphset)) return_trace (false);
 
@@ -448,7 +607,7 @@ struct MultipleSubstFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -569,7 +728,7 @@ struct AlternateSet
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto it =
       + hb_iter (alternates)
@@ -661,7 +820,7 @@ struct AlternateSubstFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -751,6 +910,13 @@ struct Ligature
     c->output->add (ligGlyph);
   }
 
+  void compile (hb_compile_subst_context_t *c, hb_codepoint_t first) const
+  {
+    c->add_ligature (first,
+		     component.lenP1 > 1 ? (unsigned) component[1] : (unsigned) hb_compiled_lookup_t::NO_SECOND,
+		     this);
+  }
+
   bool would_apply (hb_would_apply_context_t *c) const
   {
     if (c->len != component.lenP1)
@@ -819,7 +985,7 @@ struct Ligature
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     if (!intersects (&glyphset) || !glyphset.has (ligGlyph)) return_trace (false);
 
@@ -879,6 +1045,14 @@ struct LigatureSet
     ;
   }
 
+  void compile (hb_compile_subst_context_t *c, hb_codepoint_t first) const
+  {
+    + hb_iter (ligature)
+    | hb_map (hb_add (this))
+    | hb_apply ([c, first] (const Ligature &_) { _.compile (c, first); })
+    ;
+  }
+
   bool would_apply (hb_would_apply_context_t *c) const
   {
     return
@@ -989,6 +1163,12 @@ struct LigatureSubstFormat1
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  void compile (hb_compile_subst_context_t *c) const
+  {
+    for (const auto _ : + hb_zip (this+coverage, ligatureSet))
+      (this+_.second).compile (c, _.first);
+  }
+
   bool would_apply (hb_would_apply_context_t *c) const
   {
     unsigned int index = (this+coverage).get_coverage (c->glyphs[0]);
@@ -1037,7 +1217,7 @@ struct LigatureSubstFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -1109,7 +1289,62 @@ struct LigatureSubst
     }
   }
 
+  static bool apply_compiled (const hb_compiled_lookup_t *l, hb_ot_apply_context_t *c)
+  {
+    unsigned int i = c->buffer->cur().codepoint - l->first_glyph;
+    if (i >= l->map.length - 1) return false;
+
+    hb_codepoint_t candidates[4];
+    unsigned int candidate_count = 0;
+    bool have_candidates = false, use_candidates = false;
+
+    unsigned int end = l->map.arrayZ[i + 1];
+    for (unsigned int j = l->map.arrayZ[i]; j < end; j++)
+    {
+      const hb_compiled_lookup_t::ligature_t &lig = l->ligatures.arrayZ[j];
+      if (lig.second != hb_compiled_lookup_t::NO_SECOND)
+      {
+	if (!have_candidates)
+	{
+	  candidate_count = ARRAY_LENGTH (candidates);
+	  use_candidates = collect_second_candidates (c, candidates, &candidate_count);
+	  have_candidates = true;
+	}
+	if (use_candidates && !hb_any (hb_array (candidates, candidate_count), lig.second))
+	  continue;
+      }
+      if (reinterpret_cast<const Ligature *> (lig.ligature)->apply (c))
+	return true;
+    }
+    return false;
+  }
+
   protected:
+  /* The second component of a ligature can only ever match the glyphs
+   * up to and including the next one that can't be skipped.  Collects
+   * those; returns false if there are too many to be worth it. */
+  static bool collect_second_candidates (hb_ot_apply_context_t *c,
+					 hb_codepoint_t *glyphs,
+					 unsigned int *count /* IN/OUT */)
+  {
+    hb_buffer_t *buffer = c->buffer;
+    const hb_ot_apply_context_t::skipping_iterator_t &skippy_iter = c->iter_input;
+    unsigned int max_count = *count;
+    *count = 0;
+    for (unsigned int i = buffer->idx + 1; i < buffer->len; i++)
+    {
+      hb_ot_apply_context_t::matcher_t::may_skip_t skip = skippy_iter.may_skip (buffer->info[i]);
+      if (skip == hb_ot_apply_context_t::matcher_t::SKIP_YES)
+	continue;
+      if (*count == max_count)
+	return false;
+      glyphs[(*count)++] = buffer->info[i].codepoint;
+      if (skip == hb_ot_apply_context_t::matcher_t::SKIP_NO)
+	break;
+    }
+    return true;
+  }
+
   union {
   HBUINT16		format;		/* Format identifier */
   LigatureSubstFormat1	format1;
@@ -1431,6 +1666,18 @@ struct SubstLookup : Lookup
 
   static inline bool apply_recurse_func (hb_ot_apply_context_t *c, unsigned int lookup_index);
 
+  void compile (hb_compiled_lookup_t *out) const
+  {
+    hb_compile_subst_context_t c;
+    dispatch (&c);
+    switch (c.compile (out))
+    {
+    case hb_compile_subst_context_t::SINGLE:	out->apply_func = SingleSubst::apply_compiled; break;
+    case hb_compile_subst_context_t::LIGATURE:	out->apply_func = LigatureSubst::apply_compiled; break;
+    case hb_compile_subst_context_t::NONE:	break;
+    }
+  }
+
   SubTable& serialize_subtable (hb_serialize_context_t *c,
 				unsigned int i)
   { return get_subtables<SubTable> ()[i].serialize (c, this); }
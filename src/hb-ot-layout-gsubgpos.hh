@@ -396,6 +396,8 @@ struct hb_ot_apply_context_t :
       return SKIP_NO;
     }
 
+    unsigned int get_lookup_props () const { return lookup_props; }
+
     protected:
     unsigned int lookup_props;
     bool ignore_zwnj;
@@ -419,10 +421,14 @@ struct hb_ot_apply_context_t :
       /* Ignore ZWJ if we are matching context, or asked to. */
       matcher.set_ignore_zwj  (context_match || c->auto_zwj);
       matcher.set_mask (context_match ? -1 : c->lookup_mask);
+      skip_bits = nullptr;
+      skip_bits_resolved = false;
     }
     void set_lookup_props (unsigned int lookup_props)
     {
       matcher.set_lookup_props (lookup_props);
+      skip_bits = nullptr;
+      skip_bits_resolved = false;
     }
     void set_match_func (matcher_t::match_func_t match_func_,
 			 const void *match_data_,
@@ -461,7 +467,13 @@ struct hb_ot_apply_context_t :
 
 	matcher_t::may_skip_t skip = matcher.may_skip (c, info);
 	if (unlikely (skip == matcher_t::SKIP_YES))
+	{
+	  /* Jump over the rest of the run of skipped glyphs. */
+	  const uint64_t *bits = get_skip_bits ();
+	  if (bits)
+	    idx = next_unskipped (bits, idx, end - num_items + 1) - 1;
 	  continue;
+	}
 
 	matcher_t::may_match_t match = matcher.may_match (info, match_glyph_data);
 	if (match == matcher_t::MATCH_YES ||
@@ -488,7 +500,16 @@ struct hb_ot_apply_context_t :
 
 	matcher_t::may_skip_t skip = matcher.may_skip (c, info);
 	if (unlikely (skip == matcher_t::SKIP_YES))
+	{
+	  /* Jump over the rest of the run of skipped glyphs. */
+	  const uint64_t *bits = get_skip_bits ();
+	  if (bits)
+	  {
+	    int i = prev_unskipped (bits, idx, num_items - 1);
+	    idx = i < 0 ? num_items - 1 : i + 1;
+	  }
 	  continue;
+	}
 
 	matcher_t::may_match_t match = matcher.may_match (info, match_glyph_data);
 	if (match == matcher_t::MATCH_YES ||
@@ -508,9 +529,54 @@ struct hb_ot_apply_context_t :
 
     unsigned int idx;
     protected:
+
+    const uint64_t *get_skip_bits ()
+    {
+      if (unlikely (!skip_bits_resolved))
+      {
+	skip_bits = c->get_skip_bits (matcher.get_lookup_props ());
+	skip_bits_resolved = true;
+      }
+      return skip_bits;
+    }
+
+    /* Returns the first index in [i, limit) whose bit is clear, or limit. */
+    static unsigned int next_unskipped (const uint64_t *bits,
+					unsigned int i, unsigned int limit)
+    {
+      while (i < limit)
+      {
+	uint64_t w = ~bits[i / 64] >> (i % 64);
+	if (w)
+	  return hb_min (i + hb_ctz (w), limit);
+	i = (i / 64 + 1) * 64;
+      }
+      return limit;
+    }
+
+    /* Returns the last index in [lower, i] whose bit is clear, or -1. */
+    static int prev_unskipped (const uint64_t *bits,
+			       unsigned int i, unsigned int lower)
+    {
+      for (;;)
+      {
+	uint64_t w = ~bits[i / 64] & (((uint64_t) 2 << (i % 64)) - 1);
+	if (w)
+	{
+	  unsigned int j = (i & ~63u) + hb_bit_storage (w) - 1;
+	  return j >= lower ? (int) j : -1;
+	}
+	if (i < 64 || (i & ~63u) <= lower)
+	  return -1;
+	i = (i & ~63u) - 1;
+      }
+    }
+
     hb_ot_apply_context_t *c;
     matcher_t matcher;
     const HBUINT16 *match_glyph_data;
+    const uint64_t *skip_bits;
+    bool skip_bits_resolved;
 
     unsigned int num_items;
     unsigned int end;
@@ -540,6 +606,7 @@ struct hb_ot_apply_context_t :
   hb_face_t *face;
   hb_buffer_t *buffer;
   recurse_func_t recurse_func;
+  const GDEF::accelerator_t &gdef_accel;
   const GDEF &gdef;
   const VariationStore &var_store;
 
@@ -558,6 +625,17 @@ struct hb_ot_apply_context_t :
 
   uint32_t random_state;
 
+  /* GPOS doesn't modify the glyph infos, so which glyphs are skipped for
+   * a given lookup_props only needs computing once per buffer. */
+  enum { MAX_SKIP_BITS = 8 };
+  struct skip_bits_t
+  {
+    unsigned int lookup_props;
+    hb_vector_t<uint64_t> bits;
+  };
+  skip_bits_t skip_bits[MAX_SKIP_BITS];
+  unsigned int skip_bits_count;
+
 
   hb_ot_apply_context_t (unsigned int table_index_,
 		      hb_font_t *font_,
@@ -565,13 +643,14 @@ struct hb_ot_apply_context_t :
 			iter_input (), iter_context (),
 			font (font_), face (font->face), buffer (buffer_),
 			recurse_func (nullptr),
-			gdef (
+			gdef_accel (
 #ifndef HB_NO_OT_LAYOUT
-			      *face->table.GDEF->table
+				    *face->table.GDEF
 #else
-			      Null (GDEF)
+				    Null (GDEF::accelerator_t)
 #endif
-			     ),
+				   ),
+			gdef (*gdef_accel.table),
 			var_store (gdef.get_var_store ()),
 			direction (buffer_->props.direction),
 			lookup_mask (1),
@@ -584,7 +663,8 @@ struct hb_ot_apply_context_t :
 			auto_zwnj (true),
 			auto_zwj (true),
 			random (false),
-			random_state (1) { init_iters (); }
+			random_state (1),
+			skip_bits_count (0) { init_iters (); }
 
   void init_iters ()
   {
@@ -600,6 +680,51 @@ struct hb_ot_apply_context_t :
   void set_lookup_index (unsigned int lookup_index_) { lookup_index = lookup_index_; }
   void set_lookup_props (unsigned int lookup_props_) { lookup_props = lookup_props_; init_iters (); }
 
+  /* Must be called whenever the buffer contents change between lookups. */
+  void reset_skip_bits () { skip_bits_count = 0; }
+
+  /* Returns a bitmap with a bit set for each glyph in the buffer that
+   * fails check_glyph_property() for lookup_props, or nullptr if not
+   * available. */
+  const uint64_t *get_skip_bits (unsigned int lookup_props_)
+  {
+    /* GSUB changes the buffer as it goes. */
+    if (table_index != 1) return nullptr;
+
+    for (unsigned int i = 0; i < skip_bits_count; i++)
+      if (skip_bits[i].lookup_props == lookup_props_)
+	return skip_bits[i].bits.arrayZ;
+
+    /* Entries are never evicted; iterators may hold on to them. */
+    if (unlikely (skip_bits_count == MAX_SKIP_BITS)) return nullptr;
+
+    skip_bits_t &entry = skip_bits[skip_bits_count];
+    unsigned int count = buffer->len;
+    if (unlikely (!entry.bits.resize ((count + 63) / 64))) return nullptr;
+    entry.lookup_props = lookup_props_;
+
+    /* The common case, without mark filtering, only looks at glyph_props
+     * bits and is a straight loop the compiler can vectorize. */
+    const hb_glyph_info_t *info = buffer->info;
+    unsigned int ignore = lookup_props_ & LookupFlag::IgnoreFlags;
+    bool check_marks = lookup_props_ & (LookupFlag::UseMarkFilteringSet | LookupFlag::MarkAttachmentType);
+    for (unsigned int i = 0; i < count; i += 64)
+    {
+      unsigned int n = hb_min (64u, count - i);
+      uint64_t w = 0;
+      for (unsigned int j = 0; j < n; j++)
+	w |= (uint64_t) !!(_hb_glyph_info_get_glyph_props (&info[i + j]) & ignore) << j;
+      if (check_marks)
+	for (unsigned int j = 0; j < n; j++)
+	  if (!(w & ((uint64_t) 1 << j)) && !check_glyph_property (&info[i + j], lookup_props_))
+	    w |= (uint64_t) 1 << j;
+      entry.bits[i / 64] = w;
+    }
+
+    skip_bits_count++;
+    return entry.bits.arrayZ;
+  }
+
   uint32_t random_number ()
   {
     /* http://www.cplusplus.com/reference/random/minstd_rand/ */
@@ -615,7 +740,7 @@ struct hb_ot_apply_context_t :
      * match_props has the set index.
      */
     if (match_props & LookupFlag::UseMarkFilteringSet)
-      return gdef.mark_set_covers (match_props >> 16, glyph);
+      return gdef_accel.mark_set_covers (match_props >> 16, glyph);
 
     /* The second byte of match_props has the meaning
      * "ignore marks of attachment type different than
@@ -668,7 +793,7 @@ struct hb_ot_apply_context_t :
       props |= HB_OT_LAYOUT_GLYPH_PROPS_MULTIPLIED;
 
     if (likely (has_glyph_classes))
-      props = (props & ~HB_OT_LAYOUT_GLYPH_PROPS_CLASS_MASK) | gdef.get_glyph_props (glyph_index);
+      props = (props & ~HB_OT_LAYOUT_GLYPH_PROPS_CLASS_MASK) | gdef_accel.get_glyph_props (glyph_index);
     else if (class_guess)
       props = (props & ~HB_OT_LAYOUT_GLYPH_PROPS_CLASS_MASK) | class_guess;
 
@@ -700,17 +825,79 @@ struct hb_ot_apply_context_t :
 };
 
 
+/* Dense glyph to class map for a ClassDef whose get_class() is a binary
+ * search, built along with the subtable accelerators.  Falls back to the
+ * ClassDef itself if it covers too wide a glyph range. */
+struct hb_class_cache_t
+{
+  enum { MAX_GLYPH_RANGE = 4096 };
+
+  void init (const ClassDef &class_def_)
+  {
+    class_def = &class_def_;
+    first_glyph = 0;
+    classes.init ();
+
+    hb_codepoint_t first, last;
+    if (!class_def->get_bsearch_glyph_range (&first, &last) ||
+	last - first >= MAX_GLYPH_RANGE)
+      return;
+
+    if (unlikely (!classes.resize (last - first + 1)))
+    {
+      classes.fini ();
+      return;
+    }
+    for (hb_codepoint_t g = first; g <= last; g++)
+    {
+      unsigned int klass = class_def->get_class (g);
+      if (unlikely (klass > 0xFFu))
+      {
+	classes.fini ();
+	return;
+      }
+      classes[g - first] = klass;
+    }
+    first_glyph = first;
+  }
+  void fini () { classes.fini (); }
+
+  unsigned int get_class (hb_codepoint_t glyph) const
+  {
+    if (!classes.length) return class_def->get_class (glyph);
+    unsigned int i = glyph - first_glyph;
+    return i < classes.length ? classes.arrayZ[i] : 0;
+  }
+
+  const ClassDef *class_def;
+  hb_codepoint_t first_glyph;
+  hb_vector_t<uint8_t> classes;
+};
+
 struct hb_get_subtables_context_t :
        hb_dispatch_context_t<hb_get_subtables_context_t, hb_empty_t, HB_DEBUG_APPLY>
 {
+  /* Subtables with a init_class_caches() method get this many caches. */
+  enum { MAX_CLASS_CACHES = 3 };
+
   template <typename Type>
-  static inline bool apply_to (const void *obj, OT::hb_ot_apply_context_t *c)
+  static inline bool apply_to (const void *obj, OT::hb_ot_apply_context_t *c,
+			       const hb_class_cache_t *class_caches HB_UNUSED)
   {
     const Type *typed_obj = (const Type *) obj;
     return typed_obj->apply (c);
   }
 
-  typedef bool (*hb_apply_func_t) (const void *obj, OT::hb_ot_apply_context_t *c);
+  template <typename Type>
+  static inline bool apply_cached_to (const void *obj, OT::hb_ot_apply_context_t *c,
+				      const hb_class_cache_t *class_caches)
+  {
+    const Type *typed_obj = (const Type *) obj;
+    return typed_obj->apply (c, class_caches);
+  }
+
+  typedef bool (*hb_apply_func_t) (const void *obj, OT::hb_ot_apply_context_t *c,
+				   const hb_class_cache_t *class_caches);
 
   struct hb_applicable_t
   {
@@ -721,17 +908,39 @@ struct hb_get_subtables_context_t :
       apply_func = apply_func_;
       digest.init ();
       obj_.get_coverage ().collect_coverage (&digest);
+      class_caches = nullptr;
+      init_class_caches (obj_, hb_prioritize);
+    }
+
+    void fini ()
+    {
+      if (!class_caches) return;
+      for (unsigned int i = 0; i < MAX_CLASS_CACHES; i++)
+	class_caches[i].fini ();
+      free (class_caches);
     }
 
     bool apply (OT::hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) && apply_func (obj, c);
+      return digest.may_have (c->buffer->cur().codepoint) && apply_func (obj, c, class_caches);
     }
 
     private:
+    template <typename T>
+    auto init_class_caches (const T &obj_, hb_priority<1>) -> decltype (obj_.init_class_caches (nullptr), void ())
+    {
+      class_caches = (hb_class_cache_t *) calloc (MAX_CLASS_CACHES, sizeof (hb_class_cache_t));
+      if (unlikely (!class_caches)) return;
+      obj_.init_class_caches (class_caches);
+      apply_func = apply_cached_to<T>;
+    }
+    template <typename T>
+    void init_class_caches (const T &obj_ HB_UNUSED, hb_priority<0>) {}
+
     const void *obj;
     hb_apply_func_t apply_func;
     hb_set_digest_t digest;
+    hb_class_cache_t *class_caches;
   };
 
   typedef hb_vector_t<hb_applicable_t> array_t;
@@ -840,6 +1049,11 @@ static inline bool match_class (hb_codepoint_t glyph_id, const HBUINT16 &value,
   const ClassDef &class_def = *reinterpret_cast<const ClassDef *>(data);
   return class_def.get_class (glyph_id) == value;
 }
+static inline bool match_class_cached (hb_codepoint_t glyph_id, const HBUINT16 &value, const void *data)
+{
+  const hb_class_cache_t &cache = *reinterpret_cast<const hb_class_cache_t *>(data);
+  return cache.get_class (glyph_id) == value;
+}
 static inline bool match_coverage (hb_codepoint_t glyph_id, const HBUINT16 &value, const void *data)
 {
   const OffsetTo<Coverage> &coverage = (const OffsetTo<Coverage>&)value;
@@ -1450,8 +1664,9 @@ struct Rule
     return_trace (context_apply_lookup (c, inputCount, inputZ.arrayZ, lookupCount, lookupRecord.arrayZ, lookup_context));
   }
 
+  template <typename map_t>
   bool serialize (hb_serialize_context_t *c,
-		  const hb_map_t *input_mapping, /* old->new glyphid or class mapping */
+		  const map_t *input_mapping, /* old->new glyphid or class mapping */
 		  const hb_map_t *lookup_map) const
   {
     TRACE_SERIALIZE (this);
@@ -1486,9 +1701,14 @@ struct Rule
     const hb_array_t<const HBUINT16> input = inputZ.as_array ((inputCount ? inputCount - 1 : 0));
     if (!input.length) return_trace (false);
 
-    const hb_map_t *mapping = klass_map == nullptr ? c->plan->glyph_map : klass_map;
-    if (!hb_all (input, mapping)) return_trace (false);
-    return_trace (serialize (c->serializer, mapping, lookup_map));
+    if (klass_map == nullptr)
+    {
+      const hb_dense_map_t *mapping = c->plan->glyph_map;
+      if (!hb_all (input, mapping)) return_trace (false);
+      return_trace (serialize (c->serializer, mapping, lookup_map));
+    }
+    if (!hb_all (input, klass_map)) return_trace (false);
+    return_trace (serialize (c->serializer, klass_map, lookup_map));
   }
 
   public:
@@ -1722,7 +1942,7 @@ struct ContextFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -1848,18 +2068,25 @@ struct ContextFormat2
 
   const Coverage &get_coverage () const { return this+coverage; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  void init_class_caches (hb_class_cache_t *class_caches) const
+  { class_caches[0].init (this+classDef); }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      const hb_class_cache_t *class_caches = nullptr) const
   {
     TRACE_APPLY (this);
     unsigned int index = (this+coverage).get_coverage (c->buffer->cur().codepoint);
     if (likely (index == NOT_COVERED)) return_trace (false);
 
     const ClassDef &class_def = this+classDef;
-    index = class_def.get_class (c->buffer->cur().codepoint);
+    if (class_caches)
+      index = class_caches[0].get_class (c->buffer->cur().codepoint);
+    else
+      index = class_def.get_class (c->buffer->cur().codepoint);
     const RuleSet &rule_set = this+ruleSet[index];
     struct ContextApplyLookupContext lookup_context = {
-      {match_class},
-      &class_def
+      {class_caches ? match_class_cached : match_class},
+      class_caches ? (const void *) &class_caches[0] : &class_def
     };
     return_trace (rule_set.apply (c, lookup_context));
   }
@@ -2322,16 +2549,17 @@ struct ChainRule
     }
   }
 
+  template <typename map_t>
   ChainRule* copy (hb_serialize_context_t *c,
-		   const hb_map_t *backtrack_map,
-		   const hb_map_t *input_map = nullptr,
-		   const hb_map_t *lookahead_map = nullptr) const
+		   const map_t *backtrack_map,
+		   const map_t *input_map = nullptr,
+		   const map_t *lookahead_map = nullptr) const
   {
     TRACE_SERIALIZE (this);
     auto *out = c->start_embed (this);
     if (unlikely (!out)) return_trace (nullptr);
 
-    const hb_map_t *mapping = backtrack_map;
+    const map_t *mapping = backtrack_map;
     serialize_array (c, backtrack.len, + backtrack.iter ()
 				       | hb_map (mapping));
 
@@ -2615,7 +2843,7 @@ struct ChainContextFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_dense_map_t &glyph_map = *c->plan->glyph_map;
 
     auto *out = c->serializer->start_embed (*this);
     if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
@@ -2756,12 +2984,33 @@ struct ChainContextFormat2
 
   const Coverage &get_coverage () const { return this+coverage; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  void init_class_caches (hb_class_cache_t *class_caches) const
+  {
+    class_caches[0].init (this+backtrackClassDef);
+    class_caches[1].init (this+inputClassDef);
+    class_caches[2].init (this+lookaheadClassDef);
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      const hb_class_cache_t *class_caches = nullptr) const
   {
     TRACE_APPLY (this);
     unsigned int index = (this+coverage).get_coverage (c->buffer->cur().codepoint);
     if (likely (index == NOT_COVERED)) return_trace (false);
 
+    if (class_caches)
+    {
+      index = class_caches[1].get_class (c->buffer->cur().codepoint);
+      const ChainRuleSet &rule_set = this+ruleSet[index];
+      struct ChainContextApplyLookupContext lookup_context = {
+	{match_class_cached},
+	{&class_caches[0],
+	 &class_caches[1],
+	 &class_caches[2]}
+      };
+      return_trace (rule_set.apply (c, lookup_context));
+    }
+
     const ClassDef &backtrack_class_def = this+backtrackClassDef;
     const ClassDef &input_class_def = this+inputClassDef;
     const ClassDef &lookahead_class_def = this+lookaheadClassDef;
@@ -3158,25 +3407,100 @@ struct Extension
  * GSUB/GPOS Common
  */
 
+/* A native-endian, flattened form of a lookup, built by the lookup's
+ * compile() method, if it has one, when its accelerator is created.
+ * Lookups that can't be compiled are interpreted from the font data. */
+struct hb_compiled_lookup_t
+{
+  typedef bool (*apply_func_t) (const hb_compiled_lookup_t *l, hb_ot_apply_context_t *c);
+
+  enum {
+    NOT_MAPPED = 0xFFFFu,
+    NO_SECOND = 0x10000u
+  };
+
+  struct ligature_t
+  {
+    const void *ligature;
+    hb_codepoint_t second;	/* NO_SECOND if there's none. */
+  };
+
+  void init ()
+  {
+    apply_func = nullptr;
+    first_glyph = 0;
+    map.init ();
+    ligatures.init ();
+  }
+  void fini ()
+  {
+    map.fini ();
+    ligatures.fini ();
+  }
+
+  bool is_compiled () const { return apply_func; }
+  bool apply (hb_ot_apply_context_t *c) const { return apply_func (this, c); }
+
+  apply_func_t apply_func;
+  hb_codepoint_t first_glyph;
+  /* Indexed by glyph - first_glyph.  Holds the substitute glyph for single
+   * substitutions; for ligatures, the start of the glyph's ligatures, with
+   * one extra entry at the end. */
+  hb_vector_t<uint16_t> map;
+  hb_vector_t<ligature_t> ligatures;
+};
+
 struct hb_ot_layout_lookup_accelerator_t
 {
   template <typename TLookup>
   void init (const TLookup &lookup)
   {
-    digest.init ();
-    lookup.collect_coverage (&digest);
+    hb_set_t coverage;
+    lookup.collect_coverage (&coverage);
+    digest.init (coverage);
+    DEBUG_MSG (DIGEST, &lookup, "%s digest, %u of %u sampled uncovered glyphs pass",
+	       digest.get_kind () == hb_set_digest_adaptive_t::LOWEST_BITS ? "lowest-bits" :
+	       digest.get_kind () == hb_set_digest_adaptive_t::BITMAP ? "bitmap" : "bloom",
+	       digest.get_false_positives (), digest.get_samples ());
 
     subtables.init ();
     OT::hb_get_subtables_context_t c_get_subtables (subtables);
     lookup.dispatch (&c_get_subtables);
+
+    compiled = (hb_compiled_lookup_t *) calloc (1, sizeof (hb_compiled_lookup_t));
+    if (likely (compiled))
+    {
+      compiled->init ();
+      _compile (lookup, compiled, hb_prioritize);
+      if (!compiled->is_compiled ())
+      {
+	compiled->fini ();
+	free (compiled);
+	compiled = nullptr;
+      }
+    }
+  }
+  void fini ()
+  {
+    digest.fini ();
+    for (unsigned int i = 0; i < subtables.length; i++)
+      subtables[i].fini ();
+    subtables.fini ();
+    if (compiled)
+    {
+      compiled->fini ();
+      free (compiled);
+    }
   }
-  void fini () { subtables.fini (); }
 
   bool may_have (hb_codepoint_t g) const
   { return digest.may_have (g); }
 
   bool apply (hb_ot_apply_context_t *c) const
   {
+    if (compiled)
+      return compiled->apply (c);
+
     for (unsigned int i = 0; i < subtables.length; i++)
       if (subtables[i].apply (c))
 	return true;
@@ -3184,8 +3508,15 @@ struct hb_ot_layout_lookup_accelerator_t
   }
 
   private:
-  hb_set_digest_t digest;
+  template <typename TLookup>
+  static auto _compile (const TLookup &lookup, hb_compiled_lookup_t *out, hb_priority<1>)
+  HB_AUTO_RETURN (lookup.compile (out))
+  template <typename TLookup>
+  static void _compile (const TLookup &lookup HB_UNUSED, hb_compiled_lookup_t *out HB_UNUSED, hb_priority<0>) {}
+
+  hb_set_digest_adaptive_t digest;
   hb_get_subtables_context_t::array_t subtables;
+  hb_compiled_lookup_t *compiled;
 };
 
 struct GSUBGPOS
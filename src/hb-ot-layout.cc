@@ -84,7 +84,7 @@
 bool
 hb_ot_layout_has_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_data ();
+  return face->table.kern->table->has_data ();
 }
 
 /**
@@ -100,7 +100,7 @@ hb_ot_layout_has_kerning (hb_face_t *face)
 bool
 hb_ot_layout_has_machine_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_state_machine ();
+  return face->table.kern->table->has_state_machine ();
 }
 
 /**
@@ -120,7 +120,7 @@ hb_ot_layout_has_machine_kerning (hb_face_t *face)
 bool
 hb_ot_layout_has_cross_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_cross_stream ();
+  return face->table.kern->table->has_cross_stream ();
 }
 
 void
@@ -128,12 +128,12 @@ hb_ot_layout_kern (const hb_ot_shape_plan_t *plan,
 		   hb_font_t *font,
 		   hb_buffer_t  *buffer)
 {
-  hb_blob_t *blob = font->face->table.kern.get_blob ();
-  const AAT::kern& kern = *blob->as<AAT::kern> ();
+  const OT::kern_accelerator_t &kern = *font->face->table.kern;
 
-  AAT::hb_aat_apply_context_t c (plan, font, buffer, blob);
+  AAT::hb_aat_apply_context_t c (plan, font, buffer, kern.table.get_blob ());
+  c.subtable_accels = kern.get_subtable_accels ();
 
-  kern.apply (&c);
+  kern.table->apply (&c);
 }
 #endif
 
@@ -252,7 +252,7 @@ _hb_ot_layout_set_glyph_props (hb_font_t *font,
 {
   _hb_buffer_assert_gsubgpos_vars (buffer);
 
-  const OT::GDEF &gdef = *font->face->table.GDEF->table;
+  const OT::GDEF_accelerator_t &gdef = *font->face->table.GDEF;
   unsigned int count = buffer->len;
   for (unsigned int i = 0; i < count; i++)
   {
@@ -1939,6 +1939,48 @@ apply_string (OT::hb_ot_apply_context_t *c,
   }
 }
 
+/* Applies a run of fused lookups in one forward pass.  Since their coverages
+ * are disjoint, at most one of them applies at each glyph; each lookup
+ * still only gets to see the glyphs it would have in its own pass. */
+template <typename Proxy>
+static inline void
+apply_fused_forward (OT::hb_ot_apply_context_t *c,
+		     const Proxy &proxy,
+		     const hb_ot_map_t::lookup_map_t *lookups,
+		     const hb_ot_map_t::fused_lookups_t &fused)
+{
+  hb_buffer_t *buffer = c->buffer;
+  unsigned int next_idx[hb_ot_map_t::MAX_FUSED_LOOKUPS] = {0};
+  unsigned int current = (unsigned int) -1;
+
+  unsigned int count = buffer->len;
+  for (unsigned int i = 0; i < count && buffer->successful; i++)
+  {
+    const hb_glyph_info_t &info = buffer->info[i];
+    if (!fused.digest.may_have (info.codepoint)) continue;
+    unsigned int k = fused.owners.get (info.codepoint);
+    if (k == HB_MAP_VALUE_INVALID || i < next_idx[k]) continue;
+
+    const hb_ot_map_t::lookup_map_t &lookup = lookups[k];
+    if (!(info.mask & lookup.mask)) continue;
+    if (k != current)
+    {
+      current = k;
+      c->set_lookup_index (lookup.index);
+      c->set_lookup_mask (lookup.mask);
+      c->set_auto_zwj (lookup.auto_zwj);
+      c->set_auto_zwnj (lookup.auto_zwnj);
+      c->set_lookup_props (proxy.table.get_lookup (lookup.index).get_props ());
+    }
+    if (!c->check_glyph_property (&info, c->lookup_props)) continue;
+
+    buffer->idx = i;
+    if (proxy.accels[lookup.index].apply (c))
+      next_idx[k] = buffer->idx;
+  }
+  buffer->idx = count;
+}
+
 template <typename Proxy>
 inline void hb_ot_map_t::apply (const Proxy &proxy,
 				const hb_ot_shape_plan_t *plan,
@@ -1947,6 +1989,7 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
 {
   const unsigned int table_index = proxy.table_index;
   unsigned int i = 0;
+  unsigned int fused_index = 0;
   OT::hb_ot_apply_context_t c (table_index, font, buffer);
   c.set_recurse_func (Proxy::Lookup::apply_recurse_func);
 
@@ -1954,6 +1997,20 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
     const stage_map_t *stage = &stages[table_index][stage_index];
     for (; i < stage->last_lookup; i++)
     {
+      if (table_index == 1u &&
+	  fused_index < fused_lookups.length &&
+	  fused_lookups[fused_index].start == i)
+      {
+	const fused_lookups_t &fused = fused_lookups[fused_index++];
+	/* Lookup messages need the lookups applied one by one. */
+	if (!buffer->messaging ())
+	{
+	  apply_fused_forward<Proxy> (&c, proxy, &lookups[table_index][i], fused);
+	  i += fused.count - 1;
+	  continue;
+	}
+      }
+
       unsigned int lookup_index = lookups[table_index][i].index;
       if (!buffer->message (font, "start lookup %d", lookup_index)) continue;
       c.set_lookup_index (lookup_index);
@@ -1975,10 +2032,87 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
     {
       buffer->clear_output ();
       stage->pause_func (plan, font, buffer);
+      c.reset_skip_bits ();
     }
   }
 }
 
+/* Finds runs of consecutive GPOS lookups within each stage that only add to
+ * glyph positions or assign to the glyph they matched on, and whose
+ * coverages are disjoint.  Applying such a run glyph by glyph gives the same
+ * result as applying its lookups one after the other, with a single pass
+ * over the buffer. */
+void hb_ot_map_t::fuse_position_lookups (hb_face_t *face)
+{
+  const OT::GPOS &gpos = *face->table.GPOS->table;
+  hb_set_t coverage;
+  fused_lookups_t *fused = nullptr;
+  unsigned int i = 0;
+  for (unsigned int stage_index = 0; stage_index < stages[1].length; stage_index++)
+  {
+    for (; i < stages[1][stage_index].last_lookup; i++)
+    {
+      const lookup_map_t &lookup = lookups[1][i];
+      const OT::PosLookup &l = gpos.get_lookup (lookup.index);
+      bool fusable = !lookup.random && l.is_fusable ();
+      coverage.clear ();
+      if (fusable)
+      {
+	l.collect_coverage (&coverage);
+	fusable = !coverage.in_error ();
+      }
+
+      if (fused)
+      {
+	bool disjoint = fusable && fused->count < MAX_FUSED_LOOKUPS;
+	for (hb_codepoint_t g = HB_SET_VALUE_INVALID; disjoint && coverage.next (&g);)
+	  disjoint = !fused->owners.has (g);
+	if (!disjoint)
+	{
+	  end_fused_lookups ();
+	  fused = nullptr;
+	}
+      }
+      if (!fusable)
+	continue;
+
+      if (!fused)
+      {
+	fused = fused_lookups.push ();
+	if (unlikely (fused_lookups.in_error ()))
+	  return;
+	fused->start = i;
+	fused->count = 0;
+	fused->digest.init ();
+	fused->owners.init ();
+      }
+      for (hb_codepoint_t g = HB_SET_VALUE_INVALID; coverage.next (&g);)
+      {
+	fused->owners.set (g, fused->count);
+	fused->digest.add (g);
+      }
+      fused->count++;
+    }
+    /* Runs don't cross stages. */
+    if (fused)
+    {
+      end_fused_lookups ();
+      fused = nullptr;
+    }
+  }
+}
+
+/* Drops the last run of fused lookups if fusing it isn't worth it. */
+void hb_ot_map_t::end_fused_lookups ()
+{
+  fused_lookups_t &fused = fused_lookups[fused_lookups.length - 1];
+  if (fused.count < 2 || unlikely (fused.owners.in_error ()))
+  {
+    fused.owners.fini ();
+    fused_lookups.shrink (fused_lookups.length - 1);
+  }
+}
+
 void hb_ot_map_t::substitute (const hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer) const
 {
   GSUBProxy proxy (font->face);
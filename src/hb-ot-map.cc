@@ -336,6 +336,8 @@ hb_ot_map_builder_t::compile (hb_ot_map_t                  &m,
       }
     }
   }
+
+  m.fuse_position_lookups (face);
 }
 
 
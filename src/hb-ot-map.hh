@@ -30,6 +30,8 @@
 #define HB_OT_MAP_HH
 
 #include "hb-buffer.hh"
+#include "hb-map.hh"
+#include "hb-set-digest.hh"
 
 
 #define HB_OT_MAP_MAX_BITS 8u
@@ -83,6 +85,16 @@ struct hb_ot_map_t
     pause_func_t pause_func;
   };
 
+  /* A run of consecutive GPOS lookups within a stage that can be applied
+   * in a single pass over the buffer.  See fuse_position_lookups(). */
+  enum { MAX_FUSED_LOOKUPS = 64 };
+  struct fused_lookups_t {
+    unsigned int start; /* Index of the first lookup in lookups[1] */
+    unsigned int count;
+    hb_set_digest_t digest;
+    hb_map_t owners; /* Covered glyph to lookup, relative to start */
+  };
+
   void init ()
   {
     memset (this, 0, sizeof (*this));
@@ -93,6 +105,7 @@ struct hb_ot_map_t
       lookups[table_index].init ();
       stages[table_index].init ();
     }
+    fused_lookups.init ();
   }
   void fini ()
   {
@@ -102,6 +115,9 @@ struct hb_ot_map_t
       lookups[table_index].fini ();
       stages[table_index].fini ();
     }
+    for (unsigned int i = 0; i < fused_lookups.length; i++)
+      fused_lookups[i].owners.fini ();
+    fused_lookups.fini ();
   }
 
   hb_mask_t get_global_mask () const { return global_mask; }
@@ -164,12 +180,15 @@ struct hb_ot_map_t
   bool found_script[2];
 
   private:
+  HB_INTERNAL void fuse_position_lookups (hb_face_t *face);
+  HB_INTERNAL void end_fused_lookups ();
 
   hb_mask_t global_mask;
 
   hb_sorted_vector_t<feature_map_t> features;
   hb_vector_t<lookup_map_t> lookups[2]; /* GSUB/GPOS */
   hb_vector_t<stage_map_t> stages[2]; /* GSUB/GPOS */
+  hb_vector_t<fused_lookups_t> fused_lookups; /* GPOS only */
 };
 
 enum hb_ot_map_feature_flags_t
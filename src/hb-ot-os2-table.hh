@@ -31,6 +31,7 @@
 #include "hb-open-type.hh"
 #include "hb-ot-os2-unicode-ranges.hh"
 #include "hb-ot-cmap-table.hh"
+#include "hb-ot-var-mvar-table.hh"
 
 #include "hb-set.hh"
 
@@ -196,9 +197,44 @@ struct OS2
 
     _update_unicode_ranges (&unicodes, os2_prime->ulUnicodeRange);
 
+#ifndef HB_NO_VAR
+    if (c->plan->is_instancing ())
+      os2_prime->instance_metrics (c->plan->instance_font);
+#endif
+
     return_trace (true);
   }
 
+#ifndef HB_NO_VAR
+  void instance_metrics (hb_font_t *font)
+  {
+    const MVAR &mvar = *font->face->table.MVAR;
+    const int *coords = font->coords;
+    unsigned int num_coords = font->num_coords;
+
+    mvar.apply_delta (sTypoAscender, HB_OT_METRICS_TAG_HORIZONTAL_ASCENDER, coords, num_coords);
+    mvar.apply_delta (sTypoDescender, HB_OT_METRICS_TAG_HORIZONTAL_DESCENDER, coords, num_coords);
+    mvar.apply_delta (sTypoLineGap, HB_OT_METRICS_TAG_HORIZONTAL_LINE_GAP, coords, num_coords);
+    mvar.apply_delta (usWinAscent, HB_OT_METRICS_TAG_HORIZONTAL_CLIPPING_ASCENT, coords, num_coords);
+    mvar.apply_delta (usWinDescent, HB_OT_METRICS_TAG_HORIZONTAL_CLIPPING_DESCENT, coords, num_coords);
+    mvar.apply_delta (ySubscriptXSize, HB_OT_METRICS_TAG_SUBSCRIPT_EM_X_SIZE, coords, num_coords);
+    mvar.apply_delta (ySubscriptYSize, HB_OT_METRICS_TAG_SUBSCRIPT_EM_Y_SIZE, coords, num_coords);
+    mvar.apply_delta (ySubscriptXOffset, HB_OT_METRICS_TAG_SUBSCRIPT_EM_X_OFFSET, coords, num_coords);
+    mvar.apply_delta (ySubscriptYOffset, HB_OT_METRICS_TAG_SUBSCRIPT_EM_Y_OFFSET, coords, num_coords);
+    mvar.apply_delta (ySuperscriptXSize, HB_OT_METRICS_TAG_SUPERSCRIPT_EM_X_SIZE, coords, num_coords);
+    mvar.apply_delta (ySuperscriptYSize, HB_OT_METRICS_TAG_SUPERSCRIPT_EM_Y_SIZE, coords, num_coords);
+    mvar.apply_delta (ySuperscriptXOffset, HB_OT_METRICS_TAG_SUPERSCRIPT_EM_X_OFFSET, coords, num_coords);
+    mvar.apply_delta (ySuperscriptYOffset, HB_OT_METRICS_TAG_SUPERSCRIPT_EM_Y_OFFSET, coords, num_coords);
+    mvar.apply_delta (yStrikeoutSize, HB_OT_METRICS_TAG_STRIKEOUT_SIZE, coords, num_coords);
+    mvar.apply_delta (yStrikeoutPosition, HB_OT_METRICS_TAG_STRIKEOUT_OFFSET, coords, num_coords);
+    if (version >= 2)
+    {
+      mvar.apply_delta (v2X.sxHeight, HB_OT_METRICS_TAG_X_HEIGHT, coords, num_coords);
+      mvar.apply_delta (v2X.sCapHeight, HB_OT_METRICS_TAG_CAP_HEIGHT, coords, num_coords);
+    }
+  }
+#endif
+
   void _update_unicode_ranges (const hb_set_t *codepoints,
 			       HBUINT32 ulUnicodeRange[4]) const
   {
@@ -28,6 +28,7 @@
 #define HB_OT_POST_TABLE_HH
 
 #include "hb-open-type.hh"
+#include "hb-ot-var-mvar-table.hh"
 
 #define HB_STRING_ARRAY_NAME format1_names
 #define HB_STRING_ARRAY_LIST "hb-ot-post-macroman.hh"
@@ -89,6 +90,18 @@ struct post
     serialize (c->serializer);
     if (c->serializer->in_error () || c->serializer->ran_out_of_room) return_trace (false);
 
+#ifndef HB_NO_VAR
+    if (c->plan->is_instancing ())
+    {
+      hb_font_t *font = c->plan->instance_font;
+      const MVAR &mvar = *font->face->table.MVAR;
+      mvar.apply_delta (post_prime->underlinePosition, HB_OT_METRICS_TAG_UNDERLINE_OFFSET,
+			font->coords, font->num_coords);
+      mvar.apply_delta (post_prime->underlineThickness, HB_OT_METRICS_TAG_UNDERLINE_SIZE,
+			font->coords, font->num_coords);
+    }
+#endif
+
     return_trace (true);
   }
 
@@ -950,8 +950,23 @@ hb_ot_position_default (const hb_ot_shape_context_t *c)
   {
     c->font->get_glyph_v_advances (count, &info[0].codepoint, sizeof(info[0]),
 				   &pos[0].y_advance, sizeof(pos[0]));
-    for (unsigned int i = 0; i < count; i++)
+    unsigned int i = 0;
+    if (c->font->has_glyph_v_origins_func ())
+    {
+      /* Offsets are all zero still, so fetch the origins right into them. */
+      i = c->font->get_glyph_v_origins (count, &info[0].codepoint, sizeof(info[0]),
+					&pos[0].x_offset, sizeof(pos[0]),
+					&pos[0].y_offset, sizeof(pos[0]));
+      for (unsigned int j = 0; j < i; j++)
+      {
+	pos[j].x_offset = -pos[j].x_offset;
+	pos[j].y_offset = -pos[j].y_offset;
+      }
+    }
+    /* Glyphs from the first one without an origin on need the fallback. */
+    for (; i < count; i++)
     {
+      pos[i].x_offset = pos[i].y_offset = 0;
       c->font->subtract_glyph_v_origin (info[i].codepoint,
 					&pos[i].x_offset,
 					&pos[i].y_offset);
@@ -29,6 +29,7 @@
 #define HB_OT_VAR_GVAR_TABLE_HH
 
 #include "hb-open-type.hh"
+#include "hb-ot-font-cache.hh"
 
 /*
  * gvar -- Glyph Variation Table
@@ -36,6 +37,11 @@
  */
 #define HB_OT_TAG_gvar HB_TAG('g','v','a','r')
 
+/* Bytes of decoded glyph variation data cached per face; 0 disables the cache. */
+#ifndef HB_GVAR_DELTAS_CACHE_SIZE
+#define HB_GVAR_DELTAS_CACHE_SIZE (1u << 20)
+#endif
+
 namespace OT {
 
 struct contour_point_t
@@ -112,6 +118,44 @@ struct TupleVariationHeader
       end_tuple = get_end_tuple (coord_count);
     }
 
+    return calculate_scalar (coords, coord_count, peak_tuple, start_tuple, end_tuple);
+  }
+
+  /* As above, taking the scalars of tuples that only refer to a shared peak
+   * from shared_scalars, as computed by calculate_shared_scalars (). */
+  float calculate_scalar (const int *coords, unsigned int coord_count,
+			  const hb_array_t<const F2DOT14> shared_tuples,
+			  const float *shared_scalars) const
+  {
+    if (shared_scalars && !has_peak () && !has_intermediate ())
+    {
+      unsigned int index = get_index ();
+      if (unlikely (index * coord_count >= shared_tuples.length))
+	return 0.f;
+      return shared_scalars[index];
+    }
+    return calculate_scalar (coords, coord_count, shared_tuples);
+  }
+
+  static void calculate_shared_scalars (const int *coords, unsigned int coord_count,
+					const hb_array_t<const F2DOT14> shared_tuples,
+					float *shared_scalars /* OUT */)
+  {
+    unsigned int count = coord_count ? shared_tuples.length / coord_count : 0;
+    for (unsigned int i = 0; i < count; i++)
+      shared_scalars[i] = calculate_scalar (coords, coord_count,
+					    shared_tuples.sub_array (coord_count * i, coord_count),
+					    hb_array_t<const F2DOT14> (),
+					    hb_array_t<const F2DOT14> ());
+  }
+
+  /* An empty start_tuple means the region is not intermediate. */
+  static float calculate_scalar (const int *coords, unsigned int coord_count,
+				 const hb_array_t<const F2DOT14> peak_tuple,
+				 const hb_array_t<const F2DOT14> start_tuple,
+				 const hb_array_t<const F2DOT14> end_tuple)
+  {
+    bool intermediate = start_tuple.length;
     float scalar = 1.f;
     for (unsigned int i = 0; i < coord_count; i++)
     {
@@ -119,7 +163,7 @@ struct TupleVariationHeader
       int peak = peak_tuple[i];
       if (!peak || v == peak) continue;
 
-      if (has_intermediate ())
+      if (intermediate)
       {
 	int start = start_tuple[i];
 	int end = end_tuple[i];
@@ -500,8 +544,27 @@ struct gvar
   struct accelerator_t
   {
     void init (hb_face_t *face)
-    { table = hb_sanitize_context_t ().reference_table<gvar> (face); }
-    void fini () { table.destroy (); }
+    {
+      table = hb_sanitize_context_t ().reference_table<gvar> (face);
+      glyph_deltas.init ();
+      glyph_deltas_size.set_relaxed (0);
+    }
+    void fini ()
+    {
+      hb_atomic_ptr_t<const glyph_deltas_t> *slots = glyph_deltas.get ();
+      if (slots)
+      {
+	for (unsigned int i = 0; i < table->glyphCount; i++)
+	{
+	  const glyph_deltas_t *deltas = slots[i].get ();
+	  if (deltas != get_uncached ())
+	    free ((void *) deltas);
+	}
+	free (slots);
+      }
+      glyph_deltas.init ();
+      table.destroy ();
+    }
 
     private:
     struct x_getter { static float get (const contour_point_t &p) { return p.x; } };
@@ -533,13 +596,412 @@ struct gvar
     static unsigned int next_index (unsigned int i, unsigned int start, unsigned int end)
     { return (i >= end) ? start : (i + 1); }
 
+    /* An unreferenced point whose delta is inferred from those of the
+     * referenced points prev and next, as infer_delta () does.  As that only
+     * depends on the original point positions, it comes down to weighing the
+     * two deltas, unless prev and next are tied on that axis. */
+    struct inferred_point_t
+    {
+      template <typename T>
+      static void set_weights (const hb_array_t<contour_point_t> points,
+			       unsigned int target, unsigned int prev, unsigned int next,
+			       float (&weights)[2], bool &tied)
+      {
+	float target_val = T::get (points[target]);
+	float prev_val = T::get (points[prev]);
+	float next_val = T::get (points[next]);
+
+	tied = false;
+	weights[0] = weights[1] = 0.f;
+	if (prev_val == next_val)
+	  tied = true;
+	else if (target_val <= hb_min (prev_val, next_val))
+	  weights[prev_val < next_val ? 0 : 1] = 1.f;
+	else if (target_val >= hb_max (prev_val, next_val))
+	  weights[prev_val > next_val ? 0 : 1] = 1.f;
+	else
+	{
+	  float r = (target_val - prev_val) / (next_val - prev_val);
+	  weights[0] = 1.f - r;
+	  weights[1] = r;
+	}
+      }
+
+      void init (const hb_array_t<contour_point_t> points,
+		 unsigned int point_, unsigned int prev_, unsigned int next_)
+      {
+	point = point_;
+	prev = prev_;
+	next = next_;
+	set_weights<x_getter> (points, point, prev, next, x_weights, x_tied);
+	set_weights<y_getter> (points, point, prev, next, y_weights, y_tied);
+      }
+
+      static float infer (float prev_delta, float next_delta,
+			  const float (&weights)[2], bool tied)
+      {
+	if (unlikely (tied))
+	  return (prev_delta == next_delta) ? prev_delta : 0.f;
+	return weights[0] * prev_delta + weights[1] * next_delta;
+      }
+
+      unsigned int point, prev, next;
+      float x_weights[2], y_weights[2];
+      bool x_tied, y_tied;
+    };
+
+    /* The decoded deltas of one tuple, unscaled, for all points of the glyph,
+     * zero for unreferenced ones; and how to infer those of the latter. */
+    struct tuple_deltas_t
+    {
+      const TupleVariationHeader *header;
+      const int16_t *x;
+      const int16_t *y;
+      const inferred_point_t *inferred;
+      unsigned int inferred_count;
+    };
+
+    /* The variation data of a glyph, decoded for its points. */
+    struct glyph_deltas_t
+    {
+      const tuple_deltas_t *tuples;
+      unsigned int tuple_count;
+      unsigned int num_points;
+      unsigned int size;
+    };
+
+    /* Marks glyphs whose variation data is applied without caching. */
+    static const glyph_deltas_t *get_uncached ()
+    {
+      static const glyph_deltas_t uncached = {};
+      return &uncached;
+    }
+
+    /* Infers deltas for unreferenced points between referenced ones, as in
+     * the uncached path of apply_deltas_to_points (). */
+    static bool infer_points (const hb_array_t<contour_point_t> points,
+			      const hb_vector_t<bool> &referenced,
+			      hb_vector_t<inferred_point_t> &inferred /* OUT */)
+    {
+      unsigned start_point = 0;
+      for (unsigned end_point = 0; end_point < points.length; end_point++)
+      {
+	if (!points[end_point].is_end_point) continue;
+
+	unsigned unref_count = 0;
+	for (unsigned i = start_point; i <= end_point; i++)
+	  if (!referenced[i]) unref_count++;
+
+	unsigned j = start_point;
+	if (unref_count == 0 || unref_count > end_point - start_point)
+	  goto no_more_gaps;
+
+	for (;;)
+	{
+	  unsigned int prev, next, i;
+	  for (;;)
+	  {
+	    i = j;
+	    j = next_index (i, start_point, end_point);
+	    if (referenced[i] && !referenced[j]) break;
+	  }
+	  prev = j = i;
+	  for (;;)
+	  {
+	    i = j;
+	    j = next_index (i, start_point, end_point);
+	    if (!referenced[i] && referenced[j]) break;
+	  }
+	  next = j;
+	  i = prev;
+	  for (;;)
+	  {
+	    i = next_index (i, start_point, end_point);
+	    if (i == next) break;
+	    inferred_point_t *p = inferred.push ();
+	    if (unlikely (inferred.in_error ())) return false;
+	    p->init (points, i, prev, next);
+	    if (--unref_count == 0) goto no_more_gaps;
+	  }
+	}
+no_more_gaps:
+	start_point = end_point + 1;
+      }
+      return true;
+    }
+
+    /* Decodes all tuples of glyph for points, or returns nullptr if there
+     * is nothing to cache, or it could not be decoded as a whole. */
+    glyph_deltas_t *create_glyph_deltas (hb_codepoint_t glyph,
+					 const hb_array_t<contour_point_t> points) const
+    {
+      hb_bytes_t var_data_bytes = table->get_glyph_var_data_bytes (table.get_blob (), glyph);
+      if (!var_data_bytes.as<GlyphVariationData> ()->has_data ()) return nullptr;
+      hb_vector_t<unsigned int> shared_indices;
+      GlyphVariationData::tuple_iterator_t iterator;
+      if (!GlyphVariationData::get_tuple_iterator (var_data_bytes, table->axisCount,
+						   shared_indices, &iterator))
+	return nullptr;
+
+      struct tuple_info_t
+      {
+	const TupleVariationHeader *header;
+	unsigned int inferred_start, inferred_count;
+      };
+      hb_vector_t<tuple_info_t> tuples;
+      hb_vector_t<int16_t> deltas; /* x then y deltas of each tuple */
+      hb_vector_t<inferred_point_t> inferred;
+      hb_vector_t<bool> referenced;
+      hb_vector_t<int> x_deltas, y_deltas;
+      hb_vector_t<unsigned int> private_indices;
+      unsigned int shared_inferred_start = 0, shared_inferred_count = 0;
+      bool shared_inferred = false;
+      unsigned int num_points = points.length;
+      do
+      {
+	const HBUINT8 *p = iterator.get_serialized_data ();
+	unsigned int length = iterator.current_tuple->get_data_size ();
+	if (unlikely (!iterator.var_data_bytes.check_range (p, length)))
+	  return nullptr;
+
+	hb_bytes_t bytes ((const char *) p, length);
+	private_indices.resize (0);
+	if (iterator.current_tuple->has_private_points () &&
+	    !GlyphVariationData::unpack_points (p, private_indices, bytes))
+	  return nullptr;
+	bool is_private = private_indices.length;
+	const hb_array_t<unsigned int> &indices = is_private ? private_indices : shared_indices;
+
+	bool apply_to_all = (indices.length == 0);
+	unsigned int num_deltas = apply_to_all ? num_points : indices.length;
+	if (unlikely (!x_deltas.resize (num_deltas) ||
+		      !y_deltas.resize (num_deltas)))
+	  return nullptr;
+	if (!GlyphVariationData::unpack_deltas (p, x_deltas, bytes) ||
+	    !GlyphVariationData::unpack_deltas (p, y_deltas, bytes))
+	  return nullptr;
+
+	unsigned int start = deltas.length;
+	if (unlikely (!deltas.resize (start + 2 * num_points))) return nullptr;
+	int16_t *x = &deltas[start];
+	int16_t *y = x + num_points;
+	tuple_info_t *info = tuples.push ();
+	if (unlikely (tuples.in_error ())) return nullptr;
+	info->header = iterator.current_tuple;
+	info->inferred_start = info->inferred_count = 0;
+
+	if (apply_to_all)
+	{
+	  for (unsigned int i = 0; i < num_points; i++)
+	  {
+	    x[i] = x_deltas[i];
+	    y[i] = y_deltas[i];
+	  }
+	  continue;
+	}
+
+	if (unlikely (!referenced.resize (num_points))) return nullptr;
+	for (unsigned int i = 0; i < num_points; i++)
+	{
+	  x[i] = y[i] = 0;
+	  referenced[i] = false;
+	}
+	for (unsigned int i = 0; i < num_deltas; i++)
+	{
+	  unsigned int pt_index = indices[i];
+	  if (unlikely (pt_index >= num_points)) continue;
+	  /* Deltas of a point referenced twice are scaled before adding up;
+	   * leave those to the uncached path. */
+	  if (unlikely (referenced[pt_index])) return nullptr;
+	  referenced[pt_index] = true;
+	  x[pt_index] = x_deltas[i];
+	  y[pt_index] = y_deltas[i];
+	}
+
+	if (!is_private && shared_inferred)
+	{
+	  info->inferred_start = shared_inferred_start;
+	  info->inferred_count = shared_inferred_count;
+	  continue;
+	}
+	info->inferred_start = inferred.length;
+	if (unlikely (!infer_points (points, referenced, inferred))) return nullptr;
+	info->inferred_count = inferred.length - info->inferred_start;
+	if (!is_private)
+	{
+	  shared_inferred = true;
+	  shared_inferred_start = info->inferred_start;
+	  shared_inferred_count = info->inferred_count;
+	}
+      } while (iterator.move_to_next ());
+
+      unsigned int size = sizeof (glyph_deltas_t) +
+			  tuples.length * sizeof (tuple_deltas_t) +
+			  inferred.length * sizeof (inferred_point_t) +
+			  deltas.length * sizeof (int16_t);
+      char *block = (char *) malloc (size);
+      if (unlikely (!block)) return nullptr;
+      glyph_deltas_t *glyph_deltas = (glyph_deltas_t *) block;
+      tuple_deltas_t *tuple_deltas = (tuple_deltas_t *) (glyph_deltas + 1);
+      inferred_point_t *inferred_points = (inferred_point_t *) (tuple_deltas + tuples.length);
+      int16_t *all_deltas = (int16_t *) (inferred_points + inferred.length);
+      if (inferred.length)
+	memcpy (inferred_points, inferred.arrayZ, inferred.length * sizeof (inferred_point_t));
+      if (deltas.length)
+	memcpy (all_deltas, deltas.arrayZ, deltas.length * sizeof (int16_t));
+      for (unsigned int i = 0; i < tuples.length; i++)
+      {
+	tuple_deltas[i].header = tuples[i].header;
+	tuple_deltas[i].x = all_deltas + 2 * num_points * i;
+	tuple_deltas[i].y = tuple_deltas[i].x + num_points;
+	tuple_deltas[i].inferred = inferred_points + tuples[i].inferred_start;
+	tuple_deltas[i].inferred_count = tuples[i].inferred_count;
+      }
+      glyph_deltas->tuples = tuple_deltas;
+      glyph_deltas->tuple_count = tuples.length;
+      glyph_deltas->num_points = num_points;
+      glyph_deltas->size = size;
+      return glyph_deltas;
+    }
+
+    /* Returns the decoded variation data of glyph for points, decoding and
+     * caching it on first use, or nullptr if it is to be applied uncached.
+     * Points are always the same for a glyph, except that with phantom_only
+     * their positions and contours are missing; those are not decoded. */
+    const glyph_deltas_t *get_glyph_deltas (hb_codepoint_t glyph,
+					    const hb_array_t<contour_point_t> points,
+					    bool phantom_only) const
+    {
+      if (!HB_GVAR_DELTAS_CACHE_SIZE) return nullptr;
+      unsigned int num_glyphs = table->glyphCount;
+      if (unlikely (glyph >= num_glyphs)) return nullptr;
+
+      hb_atomic_ptr_t<const glyph_deltas_t> *slots = glyph_deltas.get ();
+      if (likely (slots))
+      {
+	const glyph_deltas_t *deltas = slots[glyph].get ();
+	if (deltas)
+	  return deltas != get_uncached () && deltas->num_points == points.length ? deltas : nullptr;
+      }
+
+      /* Once full, glyphs are decoded every time; nothing is evicted,
+       * as other threads may be applying cached deltas. */
+      if (phantom_only || (unsigned) glyph_deltas_size.get () >= HB_GVAR_DELTAS_CACHE_SIZE) return nullptr;
+
+      if (unlikely (!slots))
+      {
+	unsigned int slots_size = num_glyphs * sizeof (slots[0]);
+	if (slots_size >= HB_GVAR_DELTAS_CACHE_SIZE ||
+	    unlikely (!(slots = (hb_atomic_ptr_t<const glyph_deltas_t> *) calloc (num_glyphs, sizeof (slots[0])))))
+	{
+	  glyph_deltas_size.set (HB_GVAR_DELTAS_CACHE_SIZE);
+	  return nullptr;
+	}
+	if (unlikely (!glyph_deltas.cmpexch (nullptr, slots)))
+	  free (slots);
+	else
+	  (void) hb_atomic_int_impl_add (&glyph_deltas_size.v, slots_size);
+	slots = glyph_deltas.get ();
+      }
+
+      glyph_deltas_t *deltas = create_glyph_deltas (glyph, points);
+      if (!deltas)
+      {
+	slots[glyph].cmpexch (nullptr, get_uncached ());
+	return nullptr;
+      }
+
+      unsigned int size = deltas->size;
+      if ((unsigned) hb_atomic_int_impl_add (&glyph_deltas_size.v, size) + size > HB_GVAR_DELTAS_CACHE_SIZE)
+      {
+	glyph_deltas_size.set (HB_GVAR_DELTAS_CACHE_SIZE);
+	free (deltas);
+	return nullptr;
+      }
+      if (unlikely (!slots[glyph].cmpexch (nullptr, deltas)))
+      {
+	(void) hb_atomic_int_impl_add (&glyph_deltas_size.v, -(int) size);
+	free (deltas);
+	return get_glyph_deltas (glyph, points, phantom_only);
+      }
+      return deltas;
+    }
+
+    /* Returns the scalars of all shared tuples at the font's coordinates,
+     * evaluating them on first use, or nullptr if there are none. */
+    const float *get_shared_scalars (hb_font_t *font,
+				     const hb_array_t<const F2DOT14> shared_tuples) const
+    {
+      unsigned int count = table->sharedTupleCount;
+      if (!count || shared_tuples.length != count * font->num_coords) return nullptr;
+
+      hb_ot_font_cache_t *cache = hb_ot_font_cache_t::get (font);
+      if (unlikely (!cache)) return nullptr;
+
+    retry:
+      float *scalars = cache->gvar_shared_scalars.get ();
+      if (likely (scalars)) return scalars;
+
+      scalars = (float *) calloc (count, sizeof (float));
+      if (unlikely (!scalars)) return nullptr;
+      TupleVariationHeader::calculate_shared_scalars (font->coords, font->num_coords,
+						      shared_tuples, scalars);
+
+      if (unlikely (!cache->gvar_shared_scalars.cmpexch (nullptr, scalars)))
+      {
+	free (scalars);
+	goto retry;
+      }
+      return scalars;
+    }
+
     public:
+    /* With phantom_only, points only have their phantom points set, and
+     * inferring deltas for the others is skipped. */
     bool apply_deltas_to_points (hb_codepoint_t glyph, hb_font_t *font,
-				 const hb_array_t<contour_point_t> points) const
+				 const hb_array_t<contour_point_t> points,
+				 bool phantom_only = false) const
     {
       /* num_coords should exactly match gvar's axisCount due to how GlyphVariationData tuples are aligned */
       if (!font->num_coords || font->num_coords != table->axisCount) return true;
 
+      int *coords = font->coords;
+      unsigned num_coords = font->num_coords;
+      hb_array_t<const F2DOT14> shared_tuples = (table+table->sharedTuples).as_array (table->sharedTupleCount * table->axisCount);
+      const float *shared_scalars = get_shared_scalars (font, shared_tuples);
+
+      const glyph_deltas_t *cached = get_glyph_deltas (glyph, points, phantom_only);
+      if (cached)
+      {
+	for (unsigned int t = 0; t < cached->tuple_count; t++)
+	{
+	  const tuple_deltas_t &tuple = cached->tuples[t];
+	  float scalar = tuple.header->calculate_scalar (coords, num_coords, shared_tuples, shared_scalars);
+	  if (scalar == 0.f) continue;
+
+	  /* Unreferenced points have zero deltas here; those inferred are
+	   * added right after. */
+	  for (unsigned int i = 0; i < points.length; i++)
+	  {
+	    points[i].x += (float) roundf (tuple.x[i] * scalar);
+	    points[i].y += (float) roundf (tuple.y[i] * scalar);
+	  }
+
+	  if (phantom_only) continue;
+	  for (unsigned int i = 0; i < tuple.inferred_count; i++)
+	  {
+	    const inferred_point_t &p = tuple.inferred[i];
+	    float x = inferred_point_t::infer (tuple.x[p.prev] * scalar, tuple.x[p.next] * scalar,
+					       p.x_weights, p.x_tied);
+	    float y = inferred_point_t::infer (tuple.y[p.prev] * scalar, tuple.y[p.next] * scalar,
+					       p.y_weights, p.y_tied);
+	    points[p.point].x += (float) roundf (x);
+	    points[p.point].y += (float) roundf (y);
+	  }
+	}
+	return true;
+      }
+
       hb_bytes_t var_data_bytes = table->get_glyph_var_data_bytes (table.get_blob (), glyph);
       if (!var_data_bytes.as<GlyphVariationData> ()->has_data ()) return true;
       hb_vector_t<unsigned int> shared_indices;
@@ -562,12 +1024,9 @@ struct gvar
 	if (points[i].is_end_point)
 	  end_points.push (i);
 
-      int *coords = font->coords;
-      unsigned num_coords = font->num_coords;
-      hb_array_t<const F2DOT14> shared_tuples = (table+table->sharedTuples).as_array (table->sharedTupleCount * table->axisCount);
       do
       {
-	float scalar = iterator.current_tuple->calculate_scalar (coords, num_coords, shared_tuples);
+	float scalar = iterator.current_tuple->calculate_scalar (coords, num_coords, shared_tuples, shared_scalars);
 	if (scalar == 0.f) continue;
 	const HBUINT8 *p = iterator.get_serialized_data ();
 	unsigned int length = iterator.current_tuple->get_data_size ();
@@ -667,6 +1126,10 @@ no_more_gaps:
 
     private:
     hb_blob_ptr_t<gvar> table;
+
+    /* Decoded variation data by glyph, allocated on first use. */
+    hb_atomic_ptr_t<hb_atomic_ptr_t<const glyph_deltas_t>>	glyph_deltas;
+    mutable hb_atomic_int_t					glyph_deltas_size;
   };
 
   protected:
@@ -412,6 +412,19 @@ struct HVARVVAR
     return (this+varStore).get_delta (varidx, font->coords, font->num_coords);
   }
 
+  /* Same, with the regions evaluated up front, as by get_region_scalars (). */
+  float get_advance_var (hb_codepoint_t glyph,
+			 hb_array_t<const float> region_scalars) const
+  {
+    unsigned int varidx = (this+advMap).map (glyph);
+    return (this+varStore).get_delta (varidx, region_scalars.arrayZ, region_scalars.length);
+  }
+
+  unsigned int get_region_count () const { return (this+varStore).get_region_count (); }
+
+  void get_region_scalars (hb_font_t *font, hb_array_t<float> scalars) const
+  { (this+varStore).get_region_scalars (font->coords, font->num_coords, scalars.arrayZ, scalars.length); }
+
   float get_side_bearing_var (hb_codepoint_t glyph,
 			      const int *coords, unsigned int coord_count) const
   {
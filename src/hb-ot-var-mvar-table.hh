@@ -88,6 +88,13 @@ struct MVAR
     return (this+varStore).get_delta (record->varIdx, coords, coord_count);
   }
 
+  /* Folds the delta for @tag at @coords into @value; used when
+   * instancing. */
+  template <typename Type>
+  void apply_delta (Type &value, hb_tag_t tag,
+		    const int *coords, unsigned int coord_count) const
+  { value = (int) value + (int) roundf (get_var (tag, coords, coord_count)); }
+
 protected:
   static int tag_compare (const void *pa, const void *pb)
   {
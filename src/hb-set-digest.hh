@@ -28,6 +28,7 @@
 #define HB_SET_DIGEST_HH
 
 #include "hb.hh"
+#include "hb-set.hh"
 
 /*
  * The set digests here implement various "filters" that support
@@ -42,7 +43,8 @@
  *
  * The frozen-set can be used instead of a digest, to trade more
  * memory for 100% accuracy, but in practice, that doesn't look like
- * an attractive trade-off.
+ * an attractive trade-off.  hb_set_digest_adaptive_t below makes that
+ * trade only for the coverages that need it.
  */
 
 template <typename mask_t, unsigned int shift>
@@ -171,4 +173,170 @@ typedef hb_set_digest_combiner_t
 > hb_set_digest_t;
 
 
+/*
+ * hb_set_digest_adaptive_t
+ *
+ * Built from a known coverage set, this picks the representation that
+ * fits the set's shape: hb_set_digest_t if it filters well enough, an
+ * exact bitmap if the coverage spans few glyphs, or else a blocked Bloom
+ * filter sized to the population.  The false-positive rate of each
+ * candidate is measured on a sample of the glyphs below the largest
+ * covered one, and the rate of the winner is kept for inspection.
+ */
+struct hb_set_digest_adaptive_t
+{
+  enum kind_t { LOWEST_BITS, BITMAP, BLOOM };
+
+  static constexpr unsigned int NUM_SAMPLES = 1024;
+  static constexpr unsigned int MAX_BITMAP_BITS = 8192;
+  /* Not static constexpr members: hb_clamp() takes its arguments by
+   * reference, which would need out-of-class definitions in C++11. */
+  enum { MIN_BLOOM_WORDS = 8, MAX_BLOOM_WORDS = 2048 };
+
+  void init ()
+  {
+    kind = LOWEST_BITS;
+    samples = false_positives = 0;
+    u.lowest.init ();
+  }
+
+  void init (const hb_set_t &set)
+  {
+    init ();
+    init_lowest_bits (set);
+    if (set.is_empty ()) return;
+
+    hb_codepoint_t min = set.get_min ();
+    hb_codepoint_t max = set.get_max ();
+    if (unlikely (max == HB_SET_VALUE_INVALID - 1)) return;
+    measure (set, max + 1);
+    /* Lowest bits are the cheapest; keep them unless more than one in
+     * eight sampled glyphs outside the coverage gets through. */
+    if (false_positives * 8 <= samples) return;
+
+    unsigned int lowest_false_positives = false_positives;
+    bool ok = max - min < MAX_BITMAP_BITS ? init_bitmap (set, min, max) : init_bloom (set);
+    if (likely (ok))
+    {
+      measure (set, max + 1);
+      if (false_positives < lowest_false_positives) return;
+    }
+    fini ();
+    init_lowest_bits (set);
+    false_positives = lowest_false_positives;
+  }
+
+  void fini ()
+  {
+    if (kind != LOWEST_BITS)
+      free (u.array.words);
+    kind = LOWEST_BITS;
+    u.lowest.init ();
+  }
+
+  bool may_have (hb_codepoint_t g) const
+  {
+    if (likely (kind == LOWEST_BITS))
+      return u.lowest.may_have (g);
+    const uint64_t *words = u.array.words;
+    if (kind == BITMAP)
+    {
+      unsigned int i = g - u.array.first;
+      return i < u.array.length && ((words[i / 64] >> (i % 64)) & 1);
+    }
+    uint32_t h = g * 2654435761u;
+    uint64_t m = bloom_mask (h);
+    return (words[h >> (32 - u.array.bloom_bits)] & m) == m;
+  }
+
+  kind_t get_kind () const { return (kind_t) kind; }
+  /* Number of sampled glyphs outside the coverage, and how many of those
+   * the digest let through. */
+  unsigned int get_samples () const { return samples; }
+  unsigned int get_false_positives () const { return false_positives; }
+
+  private:
+
+  void init_lowest_bits (const hb_set_t &set)
+  {
+    hb_codepoint_t a = HB_SET_VALUE_INVALID, b = HB_SET_VALUE_INVALID;
+    while (set.next_range (&a, &b))
+      u.lowest.add_range (a, b);
+  }
+
+  bool init_bitmap (const hb_set_t &set, hb_codepoint_t min, hb_codepoint_t max)
+  {
+    unsigned int length = max - min + 1;
+    uint64_t *words = (uint64_t *) calloc ((length + 63) / 64, sizeof (uint64_t));
+    if (unlikely (!words)) return false;
+    hb_codepoint_t a = HB_SET_VALUE_INVALID, b = HB_SET_VALUE_INVALID;
+    while (set.next_range (&a, &b))
+      for (unsigned int i = a - min; i <= b - min; i++)
+	words[i / 64] |= (uint64_t) 1 << (i % 64);
+
+    kind = BITMAP;
+    u.array.first = min;
+    u.array.length = length;
+    u.array.words = words;
+    return true;
+  }
+
+  bool init_bloom (const hb_set_t &set)
+  {
+    /* About sixteen bits per glyph; three of them are set per glyph. */
+    unsigned int num_words = hb_clamp (set.get_population () / 4,
+				       (unsigned int) MIN_BLOOM_WORDS,
+				       (unsigned int) MAX_BLOOM_WORDS);
+    unsigned int bloom_bits = hb_bit_storage (num_words - 1);
+    uint64_t *words = (uint64_t *) calloc (1u << bloom_bits, sizeof (uint64_t));
+    if (unlikely (!words)) return false;
+    for (hb_codepoint_t g = HB_SET_VALUE_INVALID; set.next (&g);)
+    {
+      uint32_t h = g * 2654435761u;
+      words[h >> (32 - bloom_bits)] |= bloom_mask (h);
+    }
+
+    kind = BLOOM;
+    u.array.bloom_bits = bloom_bits;
+    u.array.words = words;
+    return true;
+  }
+
+  static uint64_t bloom_mask (uint32_t h)
+  {
+    h = (h ^ (h >> 13)) * 0x85EBCA6Bu;
+    return ((uint64_t) 1 << (h >> 26)) |
+	   ((uint64_t) 1 << ((h >> 20) & 63)) |
+	   ((uint64_t) 1 << ((h >> 14) & 63));
+  }
+
+  void measure (const hb_set_t &set, unsigned int domain)
+  {
+    samples = false_positives = 0;
+    bool exhaustive = domain <= NUM_SAMPLES;
+    unsigned int count = exhaustive ? domain : NUM_SAMPLES;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      hb_codepoint_t g = exhaustive ? i : (i * 2654435761u) % domain;
+      if (set.has (g)) continue;
+      samples++;
+      false_positives += may_have (g);
+    }
+  }
+
+  uint8_t kind; /* kind_t */
+  uint16_t samples;
+  uint16_t false_positives;
+  union {
+    hb_set_digest_t lowest;
+    struct {
+      hb_codepoint_t first; /* Bitmap only. */
+      unsigned int length; /* Bitmap only, in bits. */
+      unsigned int bloom_bits; /* Bloom only; the filter has 1 << bloom_bits words. */
+      uint64_t *words;
+    } array;
+  } u;
+};
+
+
 #endif /* HB_SET_DIGEST_HH */
@@ -154,7 +154,7 @@ hb_set_get_user_data (hb_set_t           *set,
 hb_bool_t
 hb_set_allocation_successful (const hb_set_t  *set)
 {
-  return set->successful;
+  return !set->in_error ();
 }
 
 /**
@@ -389,22 +389,21 @@ hb_set_symmetric_difference (hb_set_t       *set,
   set->symmetric_difference (other);
 }
 
-#ifndef HB_DISABLE_DEPRECATED
 /**
  * hb_set_invert:
  * @set: a set.
  *
- *
+ * Inverts the contents of @set: every codepoint that was in the set is
+ * removed, and every codepoint that was not is added.  This does not
+ * allocate, regardless of the size of the resulting set.
  *
  * Since: 0.9.10
- *
- * Deprecated: 1.6.1
  **/
 void
-hb_set_invert (hb_set_t *set HB_UNUSED)
+hb_set_invert (hb_set_t *set)
 {
+  set->invert ();
 }
-#endif
 
 /**
  * hb_set_get_population:
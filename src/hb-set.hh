@@ -28,15 +28,22 @@
 #define HB_SET_HH
 
 #include "hb.hh"
-#include "hb-machinery.hh"
+#include "hb-bit-set.hh"
 
 
 /*
  * hb_set_t
  */
 
-/* TODO Keep a free-list so we can free pages that are completely zeroed.  At that
- * point maybe also use a sentinel value for "all-1" pages? */
+/* A set of codepoints, stored as one of:
+ *
+ * - a bitmap of its members;
+ * - when inverted, a bitmap of its non-members, so that inverting is O(1);
+ * - while it is made of a few large ranges, the sorted list of those
+ *   ranges, so that, say, all of Unicode takes no pages.
+ *
+ * A range list moves into the bitmap when it grows past MAX_RANGES, or
+ * before an operation that works on the bitmap only. */
 
 struct hb_set_t
 {
@@ -44,184 +51,19 @@ struct hb_set_t
   hb_set_t ()  { init (); }
   ~hb_set_t () { fini (); }
 
-  struct page_map_t
-  {
-    int cmp (const page_map_t &o) const { return (int) o.major - (int) major; }
-
-    uint32_t major;
-    uint32_t index;
-  };
-
-  struct page_t
-  {
-    void init0 () { v.clear (); }
-    void init1 () { v.clear (0xFF); }
-
-    unsigned int len () const
-    { return ARRAY_LENGTH_CONST (v); }
-
-    bool is_empty () const
-    {
-      for (unsigned int i = 0; i < len (); i++)
-	if (v[i])
-	  return false;
-      return true;
-    }
-
-    void add (hb_codepoint_t g) { elt (g) |= mask (g); }
-    void del (hb_codepoint_t g) { elt (g) &= ~mask (g); }
-    bool get (hb_codepoint_t g) const { return elt (g) & mask (g); }
-
-    void add_range (hb_codepoint_t a, hb_codepoint_t b)
-    {
-      elt_t *la = &elt (a);
-      elt_t *lb = &elt (b);
-      if (la == lb)
-	*la |= (mask (b) << 1) - mask(a);
-      else
-      {
-	*la |= ~(mask (a) - 1);
-	la++;
-
-	memset (la, 0xff, (char *) lb - (char *) la);
-
-	*lb |= ((mask (b) << 1) - 1);
-      }
-    }
-
-    void del_range (hb_codepoint_t a, hb_codepoint_t b)
-    {
-      elt_t *la = &elt (a);
-      elt_t *lb = &elt (b);
-      if (la == lb)
-	*la &= ~((mask (b) << 1) - mask(a));
-      else
-      {
-	*la &= mask (a) - 1;
-	la++;
-
-	memset (la, 0, (char *) lb - (char *) la);
-
-	*lb &= ~((mask (b) << 1) - 1);
-      }
-    }
-
-    bool is_equal (const page_t *other) const
-    {
-      return 0 == hb_memcmp (&v, &other->v, sizeof (v));
-    }
-
-    unsigned int get_population () const
-    {
-      unsigned int pop = 0;
-      for (unsigned int i = 0; i < len (); i++)
-	pop += hb_popcount (v[i]);
-      return pop;
-    }
-
-    bool next (hb_codepoint_t *codepoint) const
-    {
-      unsigned int m = (*codepoint + 1) & MASK;
-      if (!m)
-      {
-	*codepoint = INVALID;
-	return false;
-      }
-      unsigned int i = m / ELT_BITS;
-      unsigned int j = m & ELT_MASK;
-
-      const elt_t vv = v[i] & ~((elt_t (1) << j) - 1);
-      for (const elt_t *p = &vv; i < len (); p = &v[++i])
-	if (*p)
-	{
-	  *codepoint = i * ELT_BITS + elt_get_min (*p);
-	  return true;
-	}
-
-      *codepoint = INVALID;
-      return false;
-    }
-    bool previous (hb_codepoint_t *codepoint) const
-    {
-      unsigned int m = (*codepoint - 1) & MASK;
-      if (m == MASK)
-      {
-	*codepoint = INVALID;
-	return false;
-      }
-      unsigned int i = m / ELT_BITS;
-      unsigned int j = m & ELT_MASK;
-
-      /* Fancy mask to avoid shifting by elt_t bitsize, which is undefined. */
-      const elt_t mask = j < 8 * sizeof (elt_t) - 1 ?
-			 ((elt_t (1) << (j + 1)) - 1) :
-			 (elt_t) -1;
-      const elt_t vv = v[i] & mask;
-      const elt_t *p = &vv;
-      while (true)
-      {
-	if (*p)
-	{
-	  *codepoint = i * ELT_BITS + elt_get_max (*p);
-	  return true;
-	}
-	if ((int) i <= 0) break;
-	p = &v[--i];
-      }
-
-      *codepoint = INVALID;
-      return false;
-    }
-    hb_codepoint_t get_min () const
-    {
-      for (unsigned int i = 0; i < len (); i++)
-	if (v[i])
-	  return i * ELT_BITS + elt_get_min (v[i]);
-      return INVALID;
-    }
-    hb_codepoint_t get_max () const
-    {
-      for (int i = len () - 1; i >= 0; i--)
-	if (v[i])
-	  return i * ELT_BITS + elt_get_max (v[i]);
-      return 0;
-    }
-
-    typedef unsigned long long elt_t;
-    static constexpr unsigned PAGE_BITS = 512;
-    static_assert ((PAGE_BITS & ((PAGE_BITS) - 1)) == 0, "");
-
-    static unsigned int elt_get_min (const elt_t &elt) { return hb_ctz (elt); }
-    static unsigned int elt_get_max (const elt_t &elt) { return hb_bit_storage (elt) - 1; }
-
-    typedef hb_vector_size_t<elt_t, PAGE_BITS / 8> vector_t;
-
-    static constexpr unsigned ELT_BITS = sizeof (elt_t) * 8;
-    static constexpr unsigned ELT_MASK = ELT_BITS - 1;
-    static constexpr unsigned BITS = sizeof (vector_t) * 8;
-    static constexpr unsigned MASK = BITS - 1;
-    static_assert ((unsigned) PAGE_BITS == (unsigned) BITS, "");
-
-    elt_t &elt (hb_codepoint_t g) { return v[(g & MASK) / ELT_BITS]; }
-    elt_t const &elt (hb_codepoint_t g) const { return v[(g & MASK) / ELT_BITS]; }
-    elt_t mask (hb_codepoint_t g) const { return elt_t (1) << (g & ELT_MASK); }
-
-    vector_t v;
-  };
-  static_assert (page_t::PAGE_BITS == sizeof (page_t) * 8, "");
-
   hb_object_header_t header;
-  bool successful; /* Allocations successful */
-  mutable unsigned int population;
-  hb_sorted_vector_t<page_map_t> page_map;
-  hb_vector_t<page_t> pages;
+  hb_bit_set_t s;
+  bool inverted;
+  /* Sorted, and neither overlapping nor adjacent.  While not empty, the
+   * set is not inverted and s is empty. */
+  struct range_t { hb_codepoint_t first, last; };
+  hb_vector_t<range_t> ranges;
 
   void init_shallow ()
   {
-    successful = true;
-    population = 0;
-    page_map.init ();
-    pages.init ();
+    s.init_shallow ();
+    inverted = false;
+    ranges.init ();
   }
   void init ()
   {
@@ -230,9 +72,8 @@ struct hb_set_t
   }
   void fini_shallow ()
   {
-    population = 0;
-    page_map.fini ();
-    pages.fini ();
+    s.fini_shallow ();
+    ranges.fini ();
   }
   void fini ()
   {
@@ -240,106 +81,68 @@ struct hb_set_t
     fini_shallow ();
   }
 
-  bool in_error () const { return !successful; }
-
-  bool resize (unsigned int count)
-  {
-    if (unlikely (!successful)) return false;
-    if (!pages.resize (count) || !page_map.resize (count))
-    {
-      pages.resize (page_map.length);
-      successful = false;
-      return false;
-    }
-    return true;
-  }
+  bool in_error () const { return s.in_error (); }
 
   void reset ()
   {
     if (unlikely (hb_object_is_immutable (this)))
       return;
-    clear ();
-    successful = true;
+    s.reset ();
+    inverted = false;
+    ranges.fini ();
   }
-
   void clear ()
   {
     if (unlikely (hb_object_is_immutable (this)))
       return;
-    population = 0;
-    page_map.resize (0);
-    pages.resize (0);
+    s.clear ();
+    inverted = false;
+    ranges.shrink (0);
   }
-  bool is_empty () const
+  void invert ()
   {
-    unsigned int count = pages.length;
-    for (unsigned int i = 0; i < count; i++)
-      if (!pages[i].is_empty ())
-	return false;
-    return true;
+    if (unlikely (hb_object_is_immutable (this)))
+      return;
+    if (unlikely (ranges.length))
+      _invert_ranges ();
+    else if (likely (s.successful))
+      inverted = !inverted;
   }
 
-  void dirty () { population = UINT_MAX; }
+  bool is_empty () const
+  {
+    if (unlikely (ranges.length)) return false;
+    if (likely (!inverted)) return s.is_empty ();
+    hb_codepoint_t v = INVALID;
+    return !next (&v);
+  }
 
   void add (hb_codepoint_t g)
   {
-    if (unlikely (!successful)) return;
-    if (unlikely (g == INVALID)) return;
-    dirty ();
-    page_t *page = page_for_insert (g); if (unlikely (!page)) return;
-    page->add (g);
+    if (unlikely (ranges.length)) _add_to_ranges (g, g);
+    else unlikely (inverted) ? s.del (g) : s.add (g);
   }
   bool add_range (hb_codepoint_t a, hb_codepoint_t b)
   {
-    if (unlikely (!successful)) return true; /* https://github.com/harfbuzz/harfbuzz/issues/657 */
-    if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
-    dirty ();
-    unsigned int ma = get_major (a);
-    unsigned int mb = get_major (b);
-    if (ma == mb)
-    {
-      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
-      page->add_range (a, b);
-    }
-    else
+    if (unlikely (inverted))
     {
-      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
-      page->add_range (a, major_start (ma + 1) - 1);
-
-      for (unsigned int m = ma + 1; m < mb; m++)
-      {
-	page = page_for_insert (major_start (m)); if (unlikely (!page)) return false;
-	page->init1 ();
-      }
-
-      page = page_for_insert (b); if (unlikely (!page)) return false;
-      page->add_range (major_start (mb), b);
+      if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
+      s.del_range (a, b);
+      return true;
     }
-    return true;
+    /* A large range on an empty set starts a range list. */
+    if (unlikely (ranges.length) ||
+	(unlikely (a <= b && b != INVALID && _range_pages (a, b) > MIN_RANGE_PAGES) &&
+	 s.successful && s.is_empty ()))
+      return _add_to_ranges (a, b);
+    return s.add_range (a, b);
   }
 
   template <typename T>
   void add_array (const T *array, unsigned int count, unsigned int stride=sizeof(T))
   {
-    if (unlikely (!successful)) return;
-    if (!count) return;
-    dirty ();
-    hb_codepoint_t g = *array;
-    while (count)
-    {
-      unsigned int m = get_major (g);
-      page_t *page = page_for_insert (g); if (unlikely (!page)) return;
-      unsigned int start = major_start (m);
-      unsigned int end = major_start (m + 1);
-      do
-      {
-	page->add (g);
-
-	array = &StructAtOffsetUnaligned<T> (array, stride);
-	count--;
-      }
-      while (count && (g = *array, start <= g && g < end));
-    }
+    _materialize ();
+    unlikely (inverted) ? s.del_array (array, count, stride) : s.add_array (array, count, stride);
   }
 
   /* Might return false if array looks unsorted.
@@ -347,98 +150,36 @@ struct hb_set_t
   template <typename T>
   bool add_sorted_array (const T *array, unsigned int count, unsigned int stride=sizeof(T))
   {
-    if (unlikely (!successful)) return true; /* https://github.com/harfbuzz/harfbuzz/issues/657 */
-    if (!count) return true;
-    dirty ();
-    hb_codepoint_t g = *array;
-    hb_codepoint_t last_g = g;
-    while (count)
-    {
-      unsigned int m = get_major (g);
-      page_t *page = page_for_insert (g); if (unlikely (!page)) return false;
-      unsigned int end = major_start (m + 1);
-      do
-      {
-	/* If we try harder we can change the following comparison to <=;
-	 * Not sure if it's worth it. */
-	if (g < last_g) return false;
-	last_g = g;
-	page->add (g);
-
-	array = (const T *) ((const char *) array + stride);
-	count--;
-      }
-      while (count && (g = *array, g < end));
-    }
-    return true;
+    _materialize ();
+    return unlikely (inverted) ? s.del_sorted_array (array, count, stride) : s.add_sorted_array (array, count, stride);
   }
 
   void del (hb_codepoint_t g)
   {
-    /* TODO perform op even if !successful. */
-    if (unlikely (!successful)) return;
-    page_t *page = page_for (g);
-    if (!page)
-      return;
-    dirty ();
-    page->del (g);
-  }
-
-  private:
-  void del_pages (int ds, int de)
-  {
-    if (ds <= de)
-    {
-      unsigned int write_index = 0;
-      for (unsigned int i = 0; i < page_map.length; i++)
-      {
-	int m = (int) page_map[i].major;
-	if (m < ds || de < m)
-	  page_map[write_index++] = page_map[i];
-      }
-      compact (write_index);
-      resize (write_index);
-    }
+    if (unlikely (ranges.length)) _del_from_ranges (g, g);
+    else unlikely (inverted) ? s.add (g) : s.del (g);
   }
-
-  public:
   void del_range (hb_codepoint_t a, hb_codepoint_t b)
   {
-    /* TODO perform op even if !successful. */
-    if (unlikely (!successful)) return;
-    if (unlikely (a > b || a == INVALID || b == INVALID)) return;
-    dirty ();
-    unsigned int ma = get_major (a);
-    unsigned int mb = get_major (b);
-    /* Delete pages from ds through de if ds <= de. */
-    int ds = (a == major_start (ma))? (int) ma: (int) (ma + 1);
-    int de = (b + 1 == major_start (mb + 1))? (int) mb: ((int) mb - 1);
-    if (ds > de || (int) ma < ds)
-    {
-      page_t *page = page_for (a);
-      if (page)
-      {
-	if (ma == mb)
-	  page->del_range (a, b);
-	else
-	  page->del_range (a, major_start (ma + 1) - 1);
-      }
-    }
-    if (de < (int) mb && ma != mb)
+    if (unlikely (ranges.length))
+      _del_from_ranges (a, b);
+    else if (unlikely (inverted))
     {
-      page_t *page = page_for (b);
-      if (page)
-	page->del_range (major_start (mb), b);
+      if (unlikely (a > b || a == INVALID)) return;
+      s.add_range (a, hb_min (b, INVALID - 1));
     }
-    del_pages (ds, de);
+    else
+      s.del_range (a, b);
   }
 
   bool get (hb_codepoint_t g) const
   {
-    const page_t *page = page_for (g);
-    if (!page)
-      return false;
-    return page->get (g);
+    if (unlikely (ranges.length))
+    {
+      unsigned i = _range_ending_at_or_after (g);
+      return i < ranges.length && ranges[i].first <= g;
+    }
+    return s.get (g) ^ (inverted && g != INVALID);
   }
 
   /* Has interface. */
@@ -462,349 +203,484 @@ struct hb_set_t
   }
   void set (const hb_set_t *other)
   {
-    if (unlikely (!successful)) return;
-    unsigned int count = other->pages.length;
-    if (!resize (count))
+    if (unlikely (other->ranges.length))
+    {
+      if (unlikely (!s.successful)) return;
+      ranges = other->ranges;
+      if (unlikely (ranges.in_error ()))
+      {
+	_ranges_failed ();
+	return;
+      }
+      s.clear ();
+      inverted = false;
       return;
-    population = other->population;
-    memcpy ((void *) pages, (const void *) other->pages, count * pages.item_size);
-    memcpy ((void *) page_map, (const void *) other->page_map, count * page_map.item_size);
+    }
+    s.set (&other->s);
+    if (likely (s.successful))
+    {
+      inverted = other->inverted;
+      ranges.shrink (0);
+    }
   }
 
   bool is_equal (const hb_set_t *other) const
   {
-    if (get_population () != other->get_population ())
-      return false;
+    if (likely (inverted == other->inverted &&
+		!ranges.length && !other->ranges.length))
+      return s.is_equal (&other->s);
 
-    unsigned int na = pages.length;
-    unsigned int nb = other->pages.length;
-
-    unsigned int a = 0, b = 0;
-    for (; a < na && b < nb; )
+    /* Ranges are maximal, so equal sets have identical ranges. */
+    hb_codepoint_t a1 = INVALID, a2 = INVALID;
+    hb_codepoint_t b1 = INVALID, b2 = INVALID;
+    while (true)
     {
-      if (page_at (a).is_empty ()) { a++; continue; }
-      if (other->page_at (b).is_empty ()) { b++; continue; }
-      if (page_map[a].major != other->page_map[b].major ||
-	  !page_at (a).is_equal (&other->page_at (b)))
-	return false;
-      a++;
-      b++;
+      bool more = next_range (&a1, &a2);
+      if (more != other->next_range (&b1, &b2)) return false;
+      if (!more) return true;
+      if (a1 != b1 || a2 != b2) return false;
     }
-    for (; a < na; a++)
-      if (!page_at (a).is_empty ()) { return false; }
-    for (; b < nb; b++)
-      if (!other->page_at (b).is_empty ()) { return false; }
-
-    return true;
   }
 
   bool is_subset (const hb_set_t *larger_set) const
   {
-    if (get_population () > larger_set->get_population ())
-      return false;
-
-    /* TODO Optimize to use pages. */
-    hb_codepoint_t c = INVALID;
-    while (next (&c))
-      if (!larger_set->has (c))
-	return false;
-
-    return true;
-  }
+    if (likely (inverted == larger_set->inverted &&
+		!ranges.length && !larger_set->ranges.length))
+      return inverted ? larger_set->s.is_subset (&s) : s.is_subset (&larger_set->s);
 
-  void compact (unsigned int length)
-  {
-    hb_vector_t<uint32_t> old_index_to_page_map_index;
-    old_index_to_page_map_index.resize(pages.length);
-    for (uint32_t i = 0; i < old_index_to_page_map_index.length; i++)
-      old_index_to_page_map_index[i] = 0xFFFFFFFF;
-
-    for (uint32_t i = 0; i < length; i++)
-      old_index_to_page_map_index[page_map[i].index] =  i;
-
-    compact_pages (old_index_to_page_map_index);
-  }
-
-  void compact_pages (const hb_vector_t<uint32_t>& old_index_to_page_map_index)
-  {
-    unsigned int write_index = 0;
-    for (unsigned int i = 0; i < pages.length; i++)
+    if (!inverted && larger_set->inverted)
     {
-      if (old_index_to_page_map_index[i] == 0xFFFFFFFF) continue;
-
-      if (write_index < i)
-	pages[write_index] = pages[i];
+      /* A is a subset of ~B if A and B don't intersect. */
+      hb_codepoint_t first = INVALID, last = INVALID;
+      while (next_range (&first, &last))
+	if (larger_set->s.intersects (first, last))
+	  return false;
+      return true;
+    }
 
-      page_map[old_index_to_page_map_index[i]].index = write_index;
-      write_index++;
+    /* Otherwise, each range of A has to lie within a range of B. */
+    hb_codepoint_t first = INVALID, last = INVALID;
+    while (next_range (&first, &last))
+    {
+      hb_codepoint_t b1, b2 = first - 1;
+      if (!larger_set->next_range (&b1, &b2) || b1 != first || b2 < last)
+	return false;
     }
+    return true;
   }
 
-  template <typename Op>
-  void process (const Op& op, const hb_set_t *other)
+  void union_ (const hb_set_t *other)
   {
-    if (unlikely (!successful)) return;
-
-    dirty ();
-
-    unsigned int na = pages.length;
-    unsigned int nb = other->pages.length;
-    unsigned int next_page = na;
-
-    unsigned int count = 0, newCount = 0;
-    unsigned int a = 0, b = 0;
-    unsigned int write_index = 0;
-    for (; a < na && b < nb; )
+    if (unlikely (ranges.length || other->ranges.length) &&
+	!inverted && !other->inverted)
     {
-      if (page_map[a].major == other->page_map[b].major)
-      {
-	if (!Op::passthru_left)
-	{
-	  // Move page_map entries that we're keeping from the left side set
-	  // to the front of the page_map vector. This isn't necessary if
-	  // passthru_left is set since no left side pages will be removed
-	  // in that case.
-	  if (write_index < a)
-	    page_map[write_index] = page_map[a];
-	  write_index++;
-	}
-
-	count++;
-	a++;
-	b++;
-      }
-      else if (page_map[a].major < other->page_map[b].major)
+      if (is_empty ())
       {
-	if (Op::passthru_left)
-	  count++;
-	a++;
-      }
-      else
-      {
-	if (Op::passthru_right)
-	  count++;
-	b++;
+	set (other);
+	return;
       }
+      hb_codepoint_t first = INVALID, last = INVALID;
+      while (other->next_range (&first, &last))
+	add_range (first, last);
+      return;
     }
-    if (Op::passthru_left)
-      count += na - a;
-    if (Op::passthru_right)
-      count += nb - b;
 
-    if (!Op::passthru_left)
+    _materialize ();
+    hb_bit_set_t scratch;
+    const hb_bit_set_t *o = other->_bits (&scratch);
+    if (unlikely (scratch.in_error ())) { s.successful = false; return; }
+    if (likely (inverted == other->inverted))
     {
-      na  = write_index;
-      next_page = write_index;
-      compact (write_index);
+      if (unlikely (inverted))
+	s.process (hb_bitwise_and, o);
+      else
+	s.process (hb_bitwise_or, o);
     }
-
-    if (!resize (count))
-      return;
-
-    newCount = count;
-
-    /* Process in-place backward. */
-    a = na;
-    b = nb;
-    for (; a && b; )
+    else
     {
-      if (page_map[a - 1].major == other->page_map[b - 1].major)
-      {
-	a--;
-	b--;
-	count--;
-	page_map[count] = page_map[a];
-	page_at (count).v = op (page_at (a).v, other->page_at (b).v);
-      }
-      else if (page_map[a - 1].major > other->page_map[b - 1].major)
-      {
-	a--;
-	if (Op::passthru_left)
-	{
-	  count--;
-	  page_map[count] = page_map[a];
-	}
-      }
+      if (unlikely (inverted))
+	s.process (hb_bitwise_sub, o);
       else
-      {
-	b--;
-	if (Op::passthru_right)
-	{
-	  count--;
-	  page_map[count].major = other->page_map[b].major;
-	  page_map[count].index = next_page++;
-	  page_at (count).v = other->page_at (b).v;
-	}
-      }
+	s.process (hb_bitwise_lt, o);
     }
-    if (Op::passthru_left)
-      while (a)
-      {
-	a--;
-	count--;
-	page_map[count] = page_map [a];
-      }
-    if (Op::passthru_right)
-      while (b)
-      {
-	b--;
-	count--;
-	page_map[count].major = other->page_map[b].major;
-	page_map[count].index = next_page++;
-	page_at (count).v = other->page_at (b).v;
-      }
-    assert (!count);
-    if (pages.length > newCount)
-      resize (newCount);
-  }
-
-  void union_ (const hb_set_t *other)
-  {
-    process (hb_bitwise_or, other);
+    if (likely (s.successful))
+      inverted = inverted || other->inverted;
   }
   void intersect (const hb_set_t *other)
   {
-    process (hb_bitwise_and, other);
+    _materialize ();
+    hb_bit_set_t scratch;
+    const hb_bit_set_t *o = other->_bits (&scratch);
+    if (unlikely (scratch.in_error ())) { s.successful = false; return; }
+    if (likely (inverted == other->inverted))
+    {
+      if (unlikely (inverted))
+	s.process (hb_bitwise_or, o);
+      else
+	s.process (hb_bitwise_and, o);
+    }
+    else
+    {
+      if (unlikely (inverted))
+	s.process (hb_bitwise_lt, o);
+      else
+	s.process (hb_bitwise_sub, o);
+    }
+    if (likely (s.successful))
+      inverted = inverted && other->inverted;
   }
   void subtract (const hb_set_t *other)
   {
-    process (hb_bitwise_sub, other);
+    _materialize ();
+    hb_bit_set_t scratch;
+    const hb_bit_set_t *o = other->_bits (&scratch);
+    if (unlikely (scratch.in_error ())) { s.successful = false; return; }
+    if (likely (inverted == other->inverted))
+    {
+      if (unlikely (inverted))
+	s.process (hb_bitwise_lt, o);
+      else
+	s.process (hb_bitwise_sub, o);
+    }
+    else
+    {
+      if (unlikely (inverted))
+	s.process (hb_bitwise_or, o);
+      else
+	s.process (hb_bitwise_and, o);
+    }
+    if (likely (s.successful))
+      inverted = inverted && !other->inverted;
   }
   void symmetric_difference (const hb_set_t *other)
   {
-    process (hb_bitwise_xor, other);
+    _materialize ();
+    hb_bit_set_t scratch;
+    const hb_bit_set_t *o = other->_bits (&scratch);
+    if (unlikely (scratch.in_error ())) { s.successful = false; return; }
+    s.process (hb_bitwise_xor, o);
+    if (likely (s.successful))
+      inverted = inverted ^ other->inverted;
   }
+
   bool next (hb_codepoint_t *codepoint) const
   {
-    if (unlikely (*codepoint == INVALID)) {
-      *codepoint = get_min ();
-      return *codepoint != INVALID;
-    }
-
-    page_map_t map = {get_major (*codepoint), 0};
-    unsigned int i;
-    page_map.bfind (map, &i, HB_BFIND_NOT_FOUND_STORE_CLOSEST);
-    if (i < page_map.length && page_map[i].major == map.major)
+    if (unlikely (ranges.length))
     {
-      if (pages[page_map[i].index].next (codepoint))
+      hb_codepoint_t g = *codepoint + 1; /* INVALID starts at zero. */
+      unsigned i = _range_ending_at_or_after (g);
+      if (i == ranges.length)
       {
-	*codepoint += page_map[i].major * page_t::PAGE_BITS;
-	return true;
+	*codepoint = INVALID;
+	return false;
       }
-      i++;
+      *codepoint = hb_max (g, ranges[i].first);
+      return true;
     }
-    for (; i < page_map.length; i++)
+    if (likely (!inverted)) return s.next (codepoint);
+
+    hb_codepoint_t old = *codepoint;
+    if (unlikely (old + 1 == INVALID))
     {
-      hb_codepoint_t m = pages[page_map[i].index].get_min ();
-      if (m != INVALID)
-      {
-	*codepoint = page_map[i].major * page_t::PAGE_BITS + m;
-	return true;
-      }
+      *codepoint = INVALID;
+      return false;
+    }
+
+    hb_codepoint_t v = old;
+    s.next (&v);
+    if (old + 1 < v)
+    {
+      *codepoint = old + 1;
+      return true;
     }
-    *codepoint = INVALID;
-    return false;
+
+    /* old + 1 is stored; skip past its run. */
+    v = old;
+    s.next_range (&old, &v);
+
+    *codepoint = v + 1;
+    return *codepoint != INVALID;
   }
   bool previous (hb_codepoint_t *codepoint) const
   {
-    if (unlikely (*codepoint == INVALID)) {
-      *codepoint = get_max ();
-      return *codepoint != INVALID;
-    }
-
-    page_map_t map = {get_major (*codepoint), 0};
-    unsigned int i;
-    page_map.bfind (map, &i, HB_BFIND_NOT_FOUND_STORE_CLOSEST);
-    if (i < page_map.length && page_map[i].major == map.major)
+    if (unlikely (ranges.length))
     {
-      if (pages[page_map[i].index].previous (codepoint))
+      hb_codepoint_t g = *codepoint - 1; /* INVALID starts at the top. */
+      unsigned i = g == INVALID ? 0 : _range_starting_after (g);
+      if (!i)
       {
-	*codepoint += page_map[i].major * page_t::PAGE_BITS;
-	return true;
+	*codepoint = INVALID;
+	return false;
       }
+      *codepoint = hb_min (g, ranges[i - 1].last);
+      return true;
     }
-    i--;
-    for (; (int) i >= 0; i--)
+    if (likely (!inverted)) return s.previous (codepoint);
+
+    hb_codepoint_t old = *codepoint;
+    if (unlikely (old == 0))
     {
-      hb_codepoint_t m = pages[page_map[i].index].get_max ();
-      if (m != INVALID)
-      {
-	*codepoint = page_map[i].major * page_t::PAGE_BITS + m;
-	return true;
-      }
+      *codepoint = INVALID;
+      return false;
     }
-    *codepoint = INVALID;
-    return false;
+
+    hb_codepoint_t v = old;
+    s.previous (&v);
+    if (v == INVALID || old - 1 > v)
+    {
+      *codepoint = old - 1;
+      return true;
+    }
+
+    /* old - 1 is stored; skip past its run. */
+    v = old;
+    s.previous_range (&v, &old);
+
+    *codepoint = v - 1;
+    return *codepoint != INVALID;
   }
   bool next_range (hb_codepoint_t *first, hb_codepoint_t *last) const
   {
-    hb_codepoint_t i;
+    if (unlikely (ranges.length))
+    {
+      hb_codepoint_t g = *last;
+      if (!next (&g))
+      {
+	*last = *first = INVALID;
+	return false;
+      }
+      *first = g;
+      *last = ranges[_range_ending_at_or_after (g)].last;
+      return true;
+    }
+    if (likely (!inverted)) return s.next_range (first, last);
 
-    i = *last;
-    if (!next (&i))
+    if (!next (last))
     {
       *last = *first = INVALID;
       return false;
     }
 
-    /* TODO Speed up. */
-    *last = *first = i;
-    while (next (&i) && i == *last + 1)
-      (*last)++;
-
+    *first = *last;
+    s.next (last);
+    (*last)--;
     return true;
   }
   bool previous_range (hb_codepoint_t *first, hb_codepoint_t *last) const
   {
-    hb_codepoint_t i;
+    if (unlikely (ranges.length))
+    {
+      hb_codepoint_t g = *first;
+      if (!previous (&g))
+      {
+	*last = *first = INVALID;
+	return false;
+      }
+      *last = g;
+      *first = ranges[_range_starting_after (g) - 1].first;
+      return true;
+    }
+    if (likely (!inverted)) return s.previous_range (first, last);
 
-    i = *first;
-    if (!previous (&i))
+    if (!previous (first))
     {
       *last = *first = INVALID;
       return false;
     }
 
-    /* TODO Speed up. */
-    *last = *first = i;
-    while (previous (&i) && i == *first - 1)
-      (*first)--;
-
+    *last = *first;
+    s.previous (first);
+    (*first)++;
     return true;
   }
 
   unsigned int get_population () const
   {
-    if (population != UINT_MAX)
+    if (unlikely (ranges.length))
+    {
+      unsigned population = 0;
+      for (unsigned i = 0; i < ranges.length; i++)
+	population += ranges[i].last - ranges[i].first + 1;
       return population;
-
-    unsigned int pop = 0;
-    unsigned int count = pages.length;
-    for (unsigned int i = 0; i < count; i++)
-      pop += pages[i].get_population ();
-
-    population = pop;
-    return pop;
+    }
+    return inverted ? INVALID - s.get_population () : s.get_population ();
   }
   hb_codepoint_t get_min () const
   {
-    unsigned int count = pages.length;
-    for (unsigned int i = 0; i < count; i++)
-      if (!page_at (i).is_empty ())
-	return page_map[i].major * page_t::PAGE_BITS + page_at (i).get_min ();
-    return INVALID;
+    if (likely (!inverted && !ranges.length)) return s.get_min ();
+    hb_codepoint_t v = INVALID;
+    next (&v);
+    return v;
   }
   hb_codepoint_t get_max () const
   {
-    unsigned int count = pages.length;
-    for (int i = count - 1; i >= 0; i++)
-      if (!page_at (i).is_empty ())
-	return page_map[(unsigned) i].major * page_t::PAGE_BITS + page_at (i).get_max ();
-    return INVALID;
+    if (likely (!inverted && !ranges.length)) return s.get_max ();
+    hb_codepoint_t v = INVALID;
+    previous (&v);
+    return v;
   }
 
   static constexpr hb_codepoint_t INVALID = HB_SET_VALUE_INVALID;
 
+  private:
+  /* Ranges spanning more pages than this start a range list. */
+  static constexpr unsigned MIN_RANGE_PAGES = 8;
+  /* Range lists that would grow longer than this move into the bitmap. */
+  static constexpr unsigned MAX_RANGES = 64;
+
+  /* Pages needed to store [a, b]. */
+  static unsigned _range_pages (hb_codepoint_t a, hb_codepoint_t b)
+  {
+    constexpr unsigned PAGE_BITS = hb_bit_set_t::page_t::PAGE_BITS;
+    return b / PAGE_BITS - a / PAGE_BITS + 1;
+  }
+
+  /* Index of the first range that ends at or after g. */
+  unsigned _range_ending_at_or_after (hb_codepoint_t g) const
+  {
+    unsigned lo = 0, hi = ranges.length;
+    while (lo < hi)
+    {
+      unsigned mid = (lo + hi) / 2;
+      if (ranges[mid].last < g) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+  /* Index of the first range that starts after g. */
+  unsigned _range_starting_after (hb_codepoint_t g) const
+  {
+    unsigned lo = 0, hi = ranges.length;
+    while (lo < hi)
+    {
+      unsigned mid = (lo + hi) / 2;
+      if (ranges[mid].first <= g) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  void _ranges_failed ()
+  {
+    ranges.fini ();
+    s.successful = false;
+  }
+
+  /* Moves a range list into the bitmap. */
+  void _materialize ()
+  {
+    if (likely (!ranges.length)) return;
+    for (unsigned i = 0; i < ranges.length; i++)
+      s.add_range (ranges[i].first, ranges[i].last);
+    ranges.shrink (0);
+  }
+
+  /* The bitmap of a set that is not a range list; otherwise, scratch
+   * filled with the ranges. */
+  const hb_bit_set_t *_bits (hb_bit_set_t *scratch) const
+  {
+    if (likely (!ranges.length)) return &s;
+    for (unsigned i = 0; i < ranges.length; i++)
+      scratch->add_range (ranges[i].first, ranges[i].last);
+    return scratch;
+  }
+
+  /* Replaces ranges [lo, hi) with count new ones. */
+  void _replace_ranges (unsigned lo, unsigned hi, const range_t *items, unsigned count)
+  {
+    unsigned old_length = ranges.length;
+    unsigned new_length = old_length - (hi - lo) + count;
+    if (new_length > old_length && unlikely (!ranges.resize (new_length)))
+    {
+      _ranges_failed ();
+      return;
+    }
+    memmove (static_cast<void *> (ranges.arrayZ + lo + count),
+	     static_cast<void *> (ranges.arrayZ + hi),
+	     (old_length - hi) * sizeof (range_t));
+    for (unsigned i = 0; i < count; i++)
+      ranges[lo + i] = items[i];
+    ranges.shrink (new_length);
+  }
+
+  bool _add_to_ranges (hb_codepoint_t a, hb_codepoint_t b)
+  {
+    if (unlikely (!s.successful)) return true;
+    if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
+    if (unlikely (ranges.length >= MAX_RANGES))
+    {
+      _materialize ();
+      return s.add_range (a, b);
+    }
+
+    /* Ranges overlapping or adjacent to [a, b] merge into it. */
+    unsigned lo = a ? _range_ending_at_or_after (a - 1) : 0;
+    unsigned hi = _range_starting_after (b + 1);
+    range_t merged = {a, b};
+    if (lo < hi)
+    {
+      merged.first = hb_min (a, ranges[lo].first);
+      merged.last = hb_max (b, ranges[hi - 1].last);
+    }
+    _replace_ranges (lo, hi, &merged, 1);
+    return s.successful;
+  }
+
+  void _del_from_ranges (hb_codepoint_t a, hb_codepoint_t b)
+  {
+    if (unlikely (!s.successful)) return;
+    if (unlikely (a > b || a == INVALID)) return;
+    b = hb_min (b, INVALID - 1);
+    if (unlikely (ranges.length >= MAX_RANGES))
+    {
+      _materialize ();
+      s.del_range (a, b);
+      return;
+    }
+
+    /* The ranges [a, b] touches keep what lies outside of it. */
+    unsigned lo = _range_ending_at_or_after (a);
+    unsigned hi = _range_starting_after (b);
+    if (lo >= hi) return;
+    range_t kept[2];
+    unsigned count = 0;
+    if (ranges[lo].first < a)
+      kept[count++] = {ranges[lo].first, a - 1};
+    if (ranges[hi - 1].last > b)
+      kept[count++] = {b + 1, ranges[hi - 1].last};
+    _replace_ranges (lo, hi, kept, count);
+  }
+
+  /* Replaces the ranges with the gaps between them. */
+  void _invert_ranges ()
+  {
+    if (unlikely (!s.successful)) return;
+    if (unlikely (ranges.length >= MAX_RANGES))
+    {
+      _materialize ();
+      inverted = true;
+      return;
+    }
+
+    hb_vector_t<range_t> gaps;
+    hb_codepoint_t start = 0;
+    for (unsigned i = 0; i < ranges.length; i++)
+    {
+      if (ranges[i].first > start)
+	gaps.push (range_t {start, ranges[i].first - 1});
+      start = ranges[i].last + 1;
+    }
+    if (start != INVALID)
+      gaps.push (range_t {start, INVALID - 1});
+    if (unlikely (gaps.in_error ()))
+    {
+      _ranges_failed ();
+      return;
+    }
+    ranges = hb_move (gaps);
+  }
+
+  public:
   /*
    * Iterator implementation.
    */
@@ -816,8 +692,10 @@ struct hb_set_t
     {
       if (init)
       {
-	l = s->get_population () + 1;
-	__next__ ();
+	/* Population of a full inverted set is INVALID; adding one for the
+	 * first __next__ () would wrap. */
+	s->next (&v);
+	l = s->get_population ();
       }
     }
 
@@ -838,46 +716,6 @@ struct hb_set_t
   };
   iter_t iter () const { return iter_t (*this); }
   operator iter_t () const { return iter (); }
-
-  protected:
-
-  page_t *page_for_insert (hb_codepoint_t g)
-  {
-    page_map_t map = {get_major (g), pages.length};
-    unsigned int i;
-    if (!page_map.bfind (map, &i, HB_BFIND_NOT_FOUND_STORE_CLOSEST))
-    {
-      if (!resize (pages.length + 1))
-	return nullptr;
-
-      pages[map.index].init0 ();
-      memmove (page_map + i + 1,
-	       page_map + i,
-	       (page_map.length - 1 - i) * page_map.item_size);
-      page_map[i] = map;
-    }
-    return &pages[page_map[i].index];
-  }
-  page_t *page_for (hb_codepoint_t g)
-  {
-    page_map_t key = {get_major (g)};
-    const page_map_t *found = page_map.bsearch (key);
-    if (found)
-      return &pages[found->index];
-    return nullptr;
-  }
-  const page_t *page_for (hb_codepoint_t g) const
-  {
-    page_map_t key = {get_major (g)};
-    const page_map_t *found = page_map.bsearch (key);
-    if (found)
-      return &pages[found->index];
-    return nullptr;
-  }
-  page_t &page_at (unsigned int i) { return pages[page_map[i].index]; }
-  const page_t &page_at (unsigned int i) const { return pages[page_map[i].index]; }
-  unsigned int get_major (hb_codepoint_t g) const { return g / page_t::PAGE_BITS; }
-  hb_codepoint_t major_start (unsigned int major) const { return major * page_t::PAGE_BITS; }
 };
 
 
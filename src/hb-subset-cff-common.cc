@@ -224,4 +224,527 @@ hb_serialize_cff_fdselect (hb_serialize_context_t *c,
 }
 
 
+/*
+ * Subroutinizer.
+ *
+ * Charstrings are split into tokens: an operator with its operands (and
+ * hint mask bytes, if any).  Every token boundary sits at an empty
+ * argument stack, so any run of tokens can be moved into a subroutine.
+ * Repeated runs are found with a suffix array over the token ids of all
+ * glyphs and are picked greedily by their estimated savings.
+ *
+ * Subroutines never call each other, so the call depth is one, well
+ * within the Type2 nesting limit.
+ */
+
+struct cs_token_t
+{
+  unsigned int start;	/* Offset of the token in its charstring. */
+  unsigned int length;
+  bool barrier;		/* Never moved into a subroutine. */
+};
+
+/* Appends the tokens of @str to @tokens.  Fails on anything the
+ * flatteners don't produce; the caller keeps such glyphs as they are. */
+static bool
+_tokenize_charstring (const str_buff_t &str,
+		      bool is_cff2,
+		      unsigned int region_count,
+		      hb_vector_t<cs_token_t> &tokens /* IN/OUT */)
+{
+  unsigned int first_token = tokens.length;
+  unsigned int start = 0;
+  unsigned int num_args = 0;
+  unsigned int num_stems = 0;
+  int last_int = 0;
+  bool last_is_int = false;
+  unsigned int i = 0;
+  while (i < str.length)
+  {
+    unsigned char b0 = str[i];
+    if (b0 >= 32 || b0 == OpCode_shortint)
+    {
+      unsigned int size;
+      last_is_int = true;
+      if (b0 == OpCode_fixedcs)
+      {
+	size = 5;
+	last_is_int = false;
+      }
+      else if (b0 == OpCode_shortint)
+      {
+	size = 3;
+	if (likely (i + size <= str.length))
+	  last_int = (int16_t) ((str[i + 1] << 8) | str[i + 2]);
+      }
+      else if (b0 >= OpCode_TwoByteNegInt0)
+      {
+	size = 2;
+	if (likely (i + size <= str.length))
+	  last_int = -(int) (b0 - OpCode_TwoByteNegInt0) * 256 - str[i + 1] - 108;
+      }
+      else if (b0 >= OpCode_TwoBytePosInt0)
+      {
+	size = 2;
+	if (likely (i + size <= str.length))
+	  last_int = (int) (b0 - OpCode_TwoBytePosInt0) * 256 + str[i + 1] + 108;
+      }
+      else
+      {
+	size = 1;
+	last_int = (int) b0 - 139;
+      }
+      if (unlikely (i + size > str.length)) return false;
+      i += size;
+      num_args++;
+      continue;
+    }
+
+    op_code_t op = b0;
+    i++;
+    if (b0 == OpCode_escape)
+    {
+      if (unlikely (i >= str.length)) return false;
+      op = Make_OpCode_ESC (str[i]);
+      i++;
+    }
+
+    bool barrier = !is_cff2 && tokens.length == first_token; /* may carry the width */
+    switch (op)
+    {
+      case OpCode_hstem:
+      case OpCode_hstemhm:
+      case OpCode_vstem:
+      case OpCode_vstemhm:
+	num_stems += num_args / 2;
+	break;
+
+      case OpCode_hintmask:
+      case OpCode_cntrmask:
+	num_stems += num_args / 2;
+	i += (num_stems + 7) / 8;
+	if (unlikely (i > str.length)) return false;
+	break;
+
+      case OpCode_blendcs:
+	if (unlikely (!is_cff2)) return false;
+	/* blend leaves its n results on the stack; the token goes on. */
+	if (unlikely (!last_is_int || last_int < 0 ||
+		      num_args < 1 + (unsigned int) last_int * (region_count + 1)))
+	  return false;
+	num_args -= 1 + (unsigned int) last_int * region_count;
+	last_is_int = false;
+	continue;
+
+      case OpCode_endchar:
+      case OpCode_vsindexcs:
+	barrier = true;
+	break;
+
+      case OpCode_hflex:
+      case OpCode_flex:
+      case OpCode_hflex1:
+      case OpCode_flex1:
+	break;
+
+      case OpCode_callsubr:
+      case OpCode_callgsubr:
+      case OpCode_return:
+	return false;
+
+      default:
+	/* Arithmetic operators don't clear the stack. */
+	if (unlikely (Is_OpCode_ESC (op))) return false;
+	break;
+    }
+
+    cs_token_t *token = tokens.push ();
+    token->start = start;
+    token->length = i - start;
+    token->barrier = barrier;
+    start = i;
+    num_args = 0;
+    last_is_int = false;
+  }
+
+  if (unlikely (start != str.length)) return false;
+  return !tokens.in_error ();
+}
+
+struct cs_subr_candidate_t
+{
+  unsigned int lb;	/* Range of the suffix array. */
+  unsigned int rb;
+  unsigned int length;	/* In tokens. */
+  int savings;
+
+  static int cmp (const void *pa, const void *pb)
+  {
+    const cs_subr_candidate_t *a = (const cs_subr_candidate_t *) pa;
+    const cs_subr_candidate_t *b = (const cs_subr_candidate_t *) pb;
+    if (a->savings != b->savings) return a->savings > b->savings ? -1 : 1;
+    if (a->length != b->length) return a->length > b->length ? -1 : 1;
+    return a->lb < b->lb ? -1 : a->lb > b->lb ? 1 : 0;
+  }
+};
+
+static int
+_cmp_token_bytes (const void *pa, const void *pb, void *arg)
+{
+  const hb_ubytes_t *bytes = (const hb_ubytes_t *) arg;
+  return bytes[*(const unsigned int *) pa].cmp (bytes[*(const unsigned int *) pb]);
+}
+
+static int
+_cmp_unsigned (const void *pa, const void *pb)
+{
+  unsigned int a = *(const unsigned int *) pa;
+  unsigned int b = *(const unsigned int *) pb;
+  return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/* Prefix doubling with counting sorts; ids in @seq are < @alphabet. */
+static bool
+_build_suffix_array (const hb_vector_t<unsigned int> &seq,
+		     unsigned int alphabet,
+		     hb_vector_t<unsigned int> &sa /* OUT */)
+{
+  unsigned int n = seq.length;
+  hb_vector_t<unsigned int> rank_buf, tmp_buf, count;
+  if (unlikely (!sa.resize (n) || !rank_buf.resize (n) || !tmp_buf.resize (n) ||
+		!count.resize (hb_max (n, alphabet))))
+    return false;
+  unsigned int *rank = rank_buf.arrayZ;
+  unsigned int *tmp = tmp_buf.arrayZ;
+
+  unsigned int m = alphabet;
+  for (unsigned int i = 0; i < n; i++) rank[i] = seq[i];
+  for (unsigned int i = 0; i < m; i++) count[i] = 0;
+  for (unsigned int i = 0; i < n; i++) count[rank[i]]++;
+  for (unsigned int i = 1; i < m; i++) count[i] += count[i - 1];
+  for (unsigned int i = n; i--;) sa[--count[rank[i]]] = i;
+
+  for (unsigned int k = 1; ; k <<= 1)
+  {
+    /* Order by the second half, then stable sort by the first. */
+    unsigned int p = 0;
+    for (unsigned int i = n - hb_min (k, n); i < n; i++) tmp[p++] = i;
+    for (unsigned int j = 0; j < n; j++) if (sa[j] >= k) tmp[p++] = sa[j] - k;
+
+    for (unsigned int i = 0; i < m; i++) count[i] = 0;
+    for (unsigned int i = 0; i < n; i++) count[rank[i]]++;
+    for (unsigned int i = 1; i < m; i++) count[i] += count[i - 1];
+    for (unsigned int i = n; i--;) sa[--count[rank[tmp[i]]]] = tmp[i];
+
+    tmp[sa[0]] = 0;
+    m = 1;
+    for (unsigned int i = 1; i < n; i++)
+    {
+      unsigned int a = sa[i - 1], b = sa[i];
+      bool same = rank[a] == rank[b] &&
+		  (a + k < n ? (int) rank[a + k] : -1) == (b + k < n ? (int) rank[b + k] : -1);
+      tmp[b] = same ? m - 1 : m++;
+    }
+    unsigned int *t = rank; rank = tmp; tmp = t;
+    if (m == n) break;
+  }
+  return true;
+}
+
+static unsigned int
+_subr_bias (unsigned int count)
+{
+  if (count < 1240) return 107;
+  if (count < 33900) return 1131;
+  return 32768;
+}
+
+/* Bytes taken by the biased subroutine number @v. */
+static unsigned int
+_biased_number_size (int v)
+{
+  if (-107 <= v && v <= 107) return 1;
+  if (-1131 <= v && v <= 1131) return 2;
+  return 3;
+}
+
+/* Bytes taken by a call to the subroutine with the @rank'th shortest
+ * number under @bias: 215 one-byte numbers, then two-byte ones (1024 of
+ * them with bias 107, 2048 otherwise), then three-byte ones. */
+static unsigned int
+_subr_call_cost (unsigned int rank, unsigned int bias)
+{
+  unsigned int two_byte_end = bias == 107 ? 1239 : 2263;
+  if (rank < 215) return 2;
+  if (rank < two_byte_end) return 3;
+  return 4;
+}
+
+/**
+ * hb_subroutinize_cff_charstrings
+ * Moves charstring sequences that repeat across @charstrings into new
+ * global subroutines.  @charstrings must not call subroutines, i.e. come
+ * from a flattener.  @region_counts gives the blend region count of each
+ * CFF2 glyph and may be empty if no charstring blends.
+ *
+ * Return value: false on allocation failure.
+ **/
+bool
+hb_subroutinize_cff_charstrings (str_buff_vec_t &charstrings /* IN/OUT */,
+				 str_buff_vec_t &subrs /* OUT */,
+				 bool is_cff2,
+				 hb_array_t<const unsigned int> region_counts)
+{
+  unsigned int num_glyphs = charstrings.length;
+
+  /* Token sequence of all glyphs, each glyph followed by a separator. */
+  hb_vector_t<cs_token_t> tokens;
+  hb_vector_t<unsigned int> glyph_starts;
+  for (unsigned int gid = 0; gid < num_glyphs; gid++)
+  {
+    unsigned int first = tokens.length;
+    glyph_starts.push (first + gid);
+    unsigned int region_count = gid < region_counts.length ? region_counts[gid] : 0;
+    if (!_tokenize_charstring (charstrings[gid], is_cff2, region_count, tokens))
+    {
+      if (unlikely (tokens.in_error ())) return false;
+      tokens.shrink (first);
+      if (charstrings[gid].length)
+      {
+	cs_token_t *token = tokens.push ();
+	token->start = 0;
+	token->length = charstrings[gid].length;
+	token->barrier = true;
+      }
+    }
+  }
+  glyph_starts.push (tokens.length + num_glyphs);
+
+  unsigned int n = tokens.length + num_glyphs;
+  hb_vector_t<hb_ubytes_t> bytes;	/* Per position; empty for separators. */
+  hb_vector_t<bool> unique;		/* Barriers and separators. */
+  hb_vector_t<unsigned int> pre;	/* Byte prefix sums. */
+  if (unlikely (tokens.in_error () || glyph_starts.in_error () ||
+		!bytes.resize (n) || !unique.resize (n) || !pre.resize (n + 1)))
+    return false;
+  {
+    unsigned int t = 0;
+    for (unsigned int gid = 0; gid < num_glyphs; gid++)
+    {
+      const str_buff_t &str = charstrings[gid];
+      unsigned int p = glyph_starts[gid];
+      for (; p + 1 < glyph_starts[gid + 1]; p++, t++)
+      {
+	bytes[p] = hb_ubytes_t (str.arrayZ + tokens[t].start, tokens[t].length);
+	unique[p] = tokens[t].barrier;
+      }
+      bytes[p] = hb_ubytes_t ();
+      unique[p] = true;
+    }
+  }
+  pre[0] = 0;
+  for (unsigned int p = 0; p < n; p++) pre[p + 1] = pre[p] + bytes[p].length;
+
+  /* Equal tokens get equal ids; barriers and separators get unique ones. */
+  hb_vector_t<unsigned int> seq, order;
+  if (unlikely (!seq.resize (n))) return false;
+  for (unsigned int p = 0; p < n; p++)
+    if (!unique[p]) order.push (p);
+  if (unlikely (order.in_error ())) return false;
+  hb_qsort (order.arrayZ, order.length, sizeof (order[0]), _cmp_token_bytes, bytes.arrayZ);
+  unsigned int alphabet = 0;
+  for (unsigned int i = 0; i < order.length; i++)
+  {
+    if (i && bytes[order[i - 1]].cmp (bytes[order[i]])) alphabet++;
+    seq[order[i]] = alphabet;
+  }
+  if (order.length) alphabet++;
+  for (unsigned int p = 0; p < n; p++)
+    if (unique[p]) seq[p] = alphabet++;
+  order.fini ();
+
+  if (!n) return true;
+  hb_vector_t<unsigned int> sa;
+  if (unlikely (!_build_suffix_array (seq, alphabet, sa))) return false;
+
+  /* Kasai: lcp[i] is the common prefix length of sa[i - 1] and sa[i]. */
+  hb_vector_t<unsigned int> lcp;
+  {
+    hb_vector_t<unsigned int> inv;
+    if (unlikely (!lcp.resize (n + 1) || !inv.resize (n))) return false;
+    for (unsigned int i = 0; i < n; i++) inv[sa[i]] = i;
+    unsigned int h = 0;
+    lcp[0] = lcp[n] = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+      if (!inv[i]) { h = 0; continue; }
+      unsigned int j = sa[inv[i] - 1];
+      while (i + h < n && j + h < n && seq[i + h] == seq[j + h] && !unique[i + h]) h++;
+      lcp[inv[i]] = h;
+      if (h) h--;
+    }
+  }
+
+  /* Each lcp interval is a run repeating at every suffix in it.  Calls
+   * cost at least a one-byte number and callgsubr. */
+  const unsigned int call_cost = 2;
+  const unsigned int subr_overhead = is_cff2 ? 2 : 3; /* Offset and return. */
+  hb_vector_t<cs_subr_candidate_t> candidates;
+  {
+    struct interval_t { unsigned int lcp, lb; };
+    hb_vector_t<interval_t> stack;
+    interval_t *root = stack.push ();
+    root->lcp = root->lb = 0;
+    for (unsigned int i = 1; i <= n; i++)
+    {
+      unsigned int lb = i - 1;
+      while (stack.length && lcp[i] < stack[stack.length - 1].lcp)
+      {
+	interval_t top = stack[stack.length - 1];
+	stack.pop ();
+	lb = top.lb;
+	unsigned int length = top.lcp;
+	unsigned int count = i - top.lb;
+	unsigned int size = pre[sa[top.lb] + length] - pre[sa[top.lb]];
+	int savings = (int) (count * (size > call_cost ? size - call_cost : 0)) - (int) (size + subr_overhead);
+	if (size > call_cost && savings > 0 && size < 0x10000)
+	{
+	  cs_subr_candidate_t *c = candidates.push ();
+	  c->lb = top.lb;
+	  c->rb = i - 1;
+	  c->length = length;
+	  c->savings = savings;
+	}
+      }
+      if (!stack.length || lcp[i] > stack[stack.length - 1].lcp)
+      {
+	interval_t *top = stack.push ();
+	top->lcp = lcp[i];
+	top->lb = lb;
+      }
+    }
+    if (unlikely (stack.in_error () || candidates.in_error ())) return false;
+  }
+  lcp.fini ();
+  candidates.qsort (cs_subr_candidate_t::cmp);
+
+  /* Greedily claim non-overlapping occurrences.  Calls are priced with the
+   * bias of the final subroutine count, which is only known afterwards;
+   * repeat with the resulting bias until it settles. */
+  struct subr_t { unsigned int pos, length, calls; };
+  hb_vector_t<subr_t> picked;
+  hb_vector_t<bool> claimed;
+  hb_vector_t<int> call_at;
+  hb_vector_t<unsigned int> occurrences;
+  if (unlikely (!claimed.resize (n) || !call_at.resize (n))) return false;
+  unsigned int bias = _subr_bias (0);
+  for (unsigned int pass = 0; pass < 3; pass++)
+  {
+    picked.resize (0);
+    for (unsigned int p = 0; p < n; p++)
+    {
+      claimed[p] = false;
+      call_at[p] = -1;
+    }
+    for (const cs_subr_candidate_t &c : candidates)
+    {
+      if (picked.length >= 0xFFFF) break;
+      occurrences.resize (0);
+      for (unsigned int i = c.lb; i <= c.rb; i++) occurrences.push (sa[i]);
+      if (unlikely (occurrences.in_error ())) return false;
+      occurrences.qsort (_cmp_unsigned);
+
+      unsigned int count = 0, end = 0;
+      for (unsigned int i = 0; i < occurrences.length; i++)
+      {
+	unsigned int p = occurrences[i];
+	bool free = p >= end && !claimed[p] && !claimed[p + c.length - 1];
+	for (unsigned int j = p + 1; free && j + 1 < p + c.length; j++)
+	  free = !claimed[j];
+	if (!free) continue;
+	occurrences[count++] = p;
+	end = p + c.length;
+      }
+      unsigned int size = pre[occurrences[0] + c.length] - pre[occurrences[0]];
+      unsigned int cost = _subr_call_cost (picked.length, bias);
+      if (count < 2 || size <= cost ||
+	  (int) (count * (size - cost)) <= (int) (size + subr_overhead))
+	continue;
+
+      for (unsigned int i = 0; i < count; i++)
+      {
+	unsigned int p = occurrences[i];
+	for (unsigned int j = p; j < p + c.length; j++) claimed[j] = true;
+	call_at[p] = picked.length;
+      }
+      subr_t *subr = picked.push ();
+      subr->pos = occurrences[0];
+      subr->length = c.length;
+      subr->calls = count;
+    }
+    if (unlikely (picked.in_error ())) return false;
+    if (_subr_bias (picked.length) == bias) break;
+    bias = _subr_bias (picked.length);
+  }
+  if (unlikely (picked.in_error ())) return false;
+  candidates.fini ();
+  occurrences.fini ();
+
+  /* Most called subroutines get the shortest numbers under the final
+   * bias; with bias 1131 or 32768 those are not the lowest indices. */
+  bias = _subr_bias (picked.length);
+  hb_vector_t<unsigned int> by_calls, by_size, subr_index;
+  if (unlikely (!by_calls.resize (picked.length) || !by_size.resize (picked.length) ||
+		!subr_index.resize (picked.length)))
+    return false;
+  for (unsigned int i = 0; i < picked.length; i++)
+  {
+    by_calls[i] = (0xFFFFu - hb_min (picked[i].calls, 0xFFFFu)) << 16 | i;
+    by_size[i] = _biased_number_size ((int) i - (int) bias) << 16 | i;
+  }
+  by_calls.qsort (_cmp_unsigned);
+  by_size.qsort (_cmp_unsigned);
+  for (unsigned int i = 0; i < picked.length; i++)
+    subr_index[by_calls[i] & 0xFFFF] = by_size[i] & 0xFFFF;
+
+  if (unlikely (!subrs.resize (picked.length))) return false;
+  for (unsigned int i = 0; i < picked.length; i++)
+  {
+    str_buff_t &subr = subrs[subr_index[i]];
+    subr.init ();
+    str_encoder_t encoder (subr);
+    for (unsigned int p = picked[i].pos; p < picked[i].pos + picked[i].length; p++)
+      encoder.copy_str (bytes[p]);
+    if (!is_cff2) encoder.encode_op (OpCode_return);
+    if (unlikely (encoder.is_error ())) return false;
+  }
+
+  /* Tokens point into the old charstrings; replace them once all are done. */
+  str_buff_vec_t subroutinized;
+  if (unlikely (!subroutinized.resize (num_glyphs))) return false;
+  bool ret = true;
+  for (unsigned int gid = 0; gid < num_glyphs && ret; gid++)
+  {
+    str_encoder_t encoder (subroutinized[gid]);
+    for (unsigned int p = glyph_starts[gid]; p + 1 < glyph_starts[gid + 1];)
+    {
+      if (call_at[p] >= 0)
+      {
+	encoder.encode_int ((int) subr_index[call_at[p]] - (int) bias);
+	encoder.encode_op (OpCode_callgsubr);
+	p += picked[call_at[p]].length;
+      }
+      else
+	encoder.copy_str (bytes[p++]);
+    }
+    ret = !encoder.is_error ();
+  }
+  if (ret)
+    for (unsigned int gid = 0; gid < num_glyphs; gid++)
+      charstrings[gid] = hb_move (subroutinized[gid]);
+  subroutinized.fini ();
+  return ret;
+}
+
+
 #endif
@@ -238,6 +238,14 @@ struct subr_flattener_t
   {
     if (!flat_charstrings.resize (plan->num_output_glyphs ()))
       return false;
+    /* When instancing, blends are evaluated at the pinned location. */
+    const int *coords = nullptr;
+    unsigned int num_coords = 0;
+    if (plan->is_instancing ())
+    {
+      coords = plan->instance_font->coords;
+      num_coords = plan->instance_font->num_coords;
+    }
     for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
       flat_charstrings[i].init ();
     for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
@@ -254,7 +262,7 @@ struct subr_flattener_t
       if (unlikely (fd >= acc.fdCount))
 	return false;
       cs_interpreter_t<ENV, OPSET, flatten_param_t> interp;
-      interp.env.init (str, acc, fd);
+      interp.env.init (str, acc, fd, coords, num_coords);
       flatten_param_t  param = { flat_charstrings[i], plan->drop_hints };
       if (unlikely (!interp.interpret (param)))
 	return false;
@@ -958,6 +966,12 @@ hb_plan_subset_cff_fdselect (const hb_subset_plan_t *plan,
 			    hb_vector_t<CFF::code_pair_t> &fdselect_ranges /* OUT */,
 			    hb_inc_bimap_t &fdmap /* OUT */);
 
+HB_INTERNAL bool
+hb_subroutinize_cff_charstrings (CFF::str_buff_vec_t &charstrings /* IN/OUT */,
+				 CFF::str_buff_vec_t &subrs /* OUT */,
+				 bool is_cff2,
+				 hb_array_t<const unsigned int> region_counts);
+
 HB_INTERNAL bool
 hb_serialize_cff_fdselect (hb_serialize_context_t *c,
 			  unsigned int num_glyphs,
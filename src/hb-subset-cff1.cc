@@ -536,7 +536,8 @@ struct cff_subset_plan {
     num_glyphs = plan->num_output_glyphs ();
     orig_fdcount = acc.fdCount;
     drop_hints = plan->drop_hints;
-    desubroutinize = plan->desubroutinize;
+    /* New subroutines are computed from flattened charstrings. */
+    desubroutinize = plan->desubroutinize || plan->subroutinize;
 
     /* check whether the subset renumbers any glyph IDs */
     gid_renum = false;
@@ -604,6 +605,11 @@ struct cff_subset_plan {
 		    flattener(acc, plan);
       if (!flattener.flatten (subset_charstrings))
 	return false;
+
+      if (plan->subroutinize &&
+	  !hb_subroutinize_cff_charstrings (subset_charstrings, subset_globalsubrs,
+					    false, hb_array_t<const unsigned int> ()))
+	return false;
     }
     else
     {
@@ -59,6 +59,9 @@ struct cff2_top_dict_op_serializer_t : cff_top_dict_op_serializer_t<>
     switch (opstr.op)
     {
       case OpCode_vstore:
+	/* No variation store left when instancing. */
+	if (!info.var_store_link)
+	  return_trace (true);
 	return_trace (FontDict::serialize_link4_op(c, opstr.op, info.var_store_link));
 
       default:
@@ -67,8 +70,31 @@ struct cff2_top_dict_op_serializer_t : cff_top_dict_op_serializer_t<>
   }
 };
 
+struct cff2_private_dict_op_serializer_t : cff_private_dict_op_serializer_t
+{
+  /* Private dict blends aren't evaluated; when instancing, the hint values
+   * that may carry them are dropped along with vsindex. */
+  cff2_private_dict_op_serializer_t (bool desubroutinize_, bool drop_hints_, bool instancing_)
+    : cff_private_dict_op_serializer_t (desubroutinize_, drop_hints_ || instancing_),
+      instancing (instancing_) {}
+
+  bool serialize (hb_serialize_context_t *c,
+		  const op_str_t &opstr,
+		  objidx_t subrs_link) const
+  {
+    if (instancing && opstr.op == OpCode_vsindexdict)
+      return true;
+    return cff_private_dict_op_serializer_t::serialize (c, opstr, subrs_link);
+  }
+
+  protected:
+  const bool  instancing;
+};
+
 struct cff2_cs_opset_flatten_t : cff2_cs_opset_t<cff2_cs_opset_flatten_t, flatten_param_t>
 {
+  static constexpr bool keep_blend_deltas = true;
+
   static void flush_args_and_op (op_code_t op, cff2_cs_interp_env_t &env, flatten_param_t& param)
   {
     switch (op)
@@ -101,7 +127,8 @@ struct cff2_cs_opset_flatten_t : cff2_cs_opset_t<cff2_cs_opset_flatten_t, flatte
   {
     for (unsigned int i = 0; i < env.argStack.get_count ();)
     {
-      const blend_arg_t &arg = env.argStack[i];
+      /* Folds the blend in when interpreting at a location. */
+      const blend_arg_t &arg = env.eval_arg (i);
       if (arg.blending ())
       {
 	if (unlikely (!((arg.numValues > 0) && (env.argStack.get_count () >= arg.numValues))))
@@ -239,7 +266,8 @@ struct cff2_subset_plan {
       subset_fdselect_size (0),
       subset_fdselect_format (0),
       drop_hints (false),
-      desubroutinize (false)
+      desubroutinize (false),
+      instancing (false)
   {
     subset_fdselect_ranges.init ();
     fdmap.init ();
@@ -263,7 +291,10 @@ struct cff2_subset_plan {
     orig_fdcount = acc.fdArray->count;
 
     drop_hints = plan->drop_hints;
-    desubroutinize = plan->desubroutinize;
+    instancing = plan->is_instancing ();
+    /* Blends are only evaluated by the flattener, and new subroutines
+     * are computed from flattened charstrings. */
+    desubroutinize = plan->desubroutinize || plan->subroutinize || instancing;
 
     if (desubroutinize)
     {
@@ -272,6 +303,10 @@ struct cff2_subset_plan {
 		    flattener(acc, plan);
       if (!flattener.flatten (subset_charstrings))
 	return false;
+
+      if (plan->subroutinize &&
+	  !subroutinize (acc, plan))
+	return false;
     }
     else
     {
@@ -318,6 +353,29 @@ struct cff2_subset_plan {
     return true;
   }
 
+  bool subroutinize (const OT::cff2::accelerator_subset_t &acc,
+		     hb_subset_plan_t *plan)
+  {
+    /* Blend operand counts depend on the region count of each glyph. */
+    hb_vector_t<unsigned int> region_counts;
+    if (!instancing && acc.varStore != &Null (CFF2VariationStore))
+    {
+      if (unlikely (!region_counts.resize (plan->num_output_glyphs ())))
+	return false;
+      for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
+      {
+	hb_codepoint_t glyph;
+	region_counts[i] = 0;
+	if (!plan->old_gid_for_new_gid (i, &glyph)) continue;
+	unsigned int fd = acc.fdSelect->get_fd (glyph);
+	if (unlikely (fd >= acc.privateDicts.length)) continue;
+	region_counts[i] = acc.varStore->varStore.get_region_index_count (acc.privateDicts[fd].ivs);
+      }
+    }
+    return hb_subroutinize_cff_charstrings (subset_charstrings, subset_globalsubrs,
+					    true, region_counts.as_array ());
+  }
+
   cff2_sub_table_info_t info;
 
   unsigned int    orig_fdcount;
@@ -334,6 +392,7 @@ struct cff2_subset_plan {
 
   bool	    drop_hints;
   bool	    desubroutinize;
+  bool	    instancing;
 };
 
 static bool _serialize_cff2 (hb_serialize_context_t *c,
@@ -367,7 +426,7 @@ static bool _serialize_cff2 (hb_serialize_context_t *c,
       PrivateDict *pd = c->start_embed<PrivateDict> ();
       if (unlikely (!pd)) return false;
       c->push ();
-      cff_private_dict_op_serializer_t privSzr (plan.desubroutinize, plan.drop_hints);
+      cff2_private_dict_op_serializer_t privSzr (plan.desubroutinize, plan.drop_hints, plan.instancing);
       if (likely (pd->serialize (c, acc.privateDicts[i], privSzr, subrs_link)))
       {
 	unsigned fd = plan.fdmap[i];
@@ -428,7 +487,7 @@ static bool _serialize_cff2 (hb_serialize_context_t *c,
   }
 
   /* variation store */
-  if (acc.varStore != &Null (CFF2VariationStore))
+  if (acc.varStore != &Null (CFF2VariationStore) && !plan.instancing)
   {
     c->push ();
     CFF2VariationStore *dest = c->start_embed<CFF2VariationStore> ();
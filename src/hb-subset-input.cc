@@ -51,8 +51,10 @@ hb_subset_input_create_or_fail ()
   input->drop_tables = hb_set_create ();
   input->drop_hints = false;
   input->desubroutinize = false;
+  input->subroutinize = false;
   input->retain_gids = false;
   input->name_legacy = false;
+  input->axes_location.init ();
 
   hb_tag_t default_drop_tables[] = {
     // Layout disabled by default
@@ -119,6 +121,7 @@ hb_subset_input_destroy (hb_subset_input_t *subset_input)
   hb_set_destroy (subset_input->name_ids);
   hb_set_destroy (subset_input->name_languages);
   hb_set_destroy (subset_input->drop_tables);
+  subset_input->axes_location.fini ();
 
   free (subset_input);
 }
@@ -191,6 +194,39 @@ hb_subset_input_get_desubroutinize (hb_subset_input_t *subset_input)
   return subset_input->desubroutinize;
 }
 
+/**
+ * hb_subset_input_set_subroutinize:
+ * @subset_input: a subset_input.
+ * @subroutinize: If true the subsetter computes new subroutines for the
+ * CFF/CFF2 charstrings of the subset.
+ *
+ * Charstrings are flattened and sequences repeating across the retained
+ * glyphs are moved into new global subroutines, replacing any the font
+ * had.  This takes precedence over hb_subset_input_set_desubroutinize().
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_input_set_subroutinize (hb_subset_input_t *subset_input,
+				  hb_bool_t subroutinize)
+{
+  subset_input->subroutinize = subroutinize;
+}
+
+/**
+ * hb_subset_input_get_subroutinize:
+ * @subset_input: a subset_input.
+ *
+ * Return value: whether new subroutines are computed for CFF/CFF2 output.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_subset_input_get_subroutinize (hb_subset_input_t *subset_input)
+{
+  return subset_input->subroutinize;
+}
+
 /**
  * hb_subset_input_set_retain_gids:
  * @subset_input: a subset_input.
@@ -227,3 +263,77 @@ hb_subset_input_get_name_legacy (hb_subset_input_t *subset_input)
 {
   return subset_input->name_legacy;
 }
+
+#ifndef HB_NO_VAR
+/**
+ * hb_subset_input_pin_axis_location:
+ * @subset_input: a subset_input.
+ * @face: the face that is going to be subset.
+ * @axis_tag: tag of the axis to pin.
+ * @axis_value: location on the axis, in design-space coordinates.
+ *
+ * Requests that the subsetter instance the font at @axis_value on
+ * @axis_tag.  @axis_value is clamped to the axis range of @face.
+ *
+ * Once any axis is pinned, the subset is a static instance: axes that
+ * were not pinned explicitly are pinned at their default location,
+ * glyph outlines, metrics and GPOS/GDEF values have the variation
+ * deltas applied, and the variation tables are dropped.
+ *
+ * Return value: %true if @face has an axis with @axis_tag.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_subset_input_pin_axis_location (hb_subset_input_t *subset_input,
+				   hb_face_t         *face,
+				   hb_tag_t           axis_tag,
+				   float              axis_value)
+{
+  hb_ot_var_axis_info_t axis_info;
+  if (!hb_ot_var_find_axis_info (face, axis_tag, &axis_info))
+    return false;
+
+  float value = hb_clamp (axis_value, axis_info.min_value, axis_info.max_value);
+
+  for (unsigned int i = 0; i < subset_input->axes_location.length; i++)
+    if (subset_input->axes_location[i].tag == axis_tag)
+    {
+      subset_input->axes_location[i].value = value;
+      return true;
+    }
+
+  hb_variation_t *location = subset_input->axes_location.push ();
+  if (unlikely (subset_input->axes_location.in_error ()))
+    return false;
+
+  location->tag = axis_tag;
+  location->value = value;
+  return true;
+}
+
+/**
+ * hb_subset_input_pin_axis_to_default:
+ * @subset_input: a subset_input.
+ * @face: the face that is going to be subset.
+ * @axis_tag: tag of the axis to pin.
+ *
+ * Pins @axis_tag at its default location.  See
+ * hb_subset_input_pin_axis_location().
+ *
+ * Return value: %true if @face has an axis with @axis_tag.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_subset_input_pin_axis_to_default (hb_subset_input_t *subset_input,
+				     hb_face_t         *face,
+				     hb_tag_t           axis_tag)
+{
+  hb_ot_var_axis_info_t axis_info;
+  if (!hb_ot_var_find_axis_info (face, axis_tag, &axis_info))
+    return false;
+
+  return hb_subset_input_pin_axis_location (subset_input, face, axis_tag, axis_info.default_value);
+}
+#endif
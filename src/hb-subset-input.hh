@@ -46,8 +46,12 @@ struct hb_subset_input_t
 
   bool drop_hints;
   bool desubroutinize;
+  bool subroutinize;
   bool retain_gids;
   bool name_legacy;
+
+  /* Axes pinned with hb_subset_input_pin_axis_location(), in design space. */
+  hb_vector_t<hb_variation_t> axes_location;
   /* TODO
    *
    * features
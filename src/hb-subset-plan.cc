@@ -37,6 +37,35 @@
 #include "hb-ot-var-fvar-table.hh"
 #include "hb-ot-stat-table.hh"
 
+struct hb_subset_closure_accelerators_t
+{
+  void init (hb_face_t *face)
+  {
+    cmap.init (face);
+    glyf.init (face);
+#ifndef HB_NO_SUBSET_CFF
+    cff.init (face);
+#endif
+    colr.init (face);
+  }
+
+  void fini ()
+  {
+    colr.fini ();
+#ifndef HB_NO_SUBSET_CFF
+    cff.fini ();
+#endif
+    glyf.fini ();
+    cmap.fini ();
+  }
+
+  OT::cmap::accelerator_t cmap;
+  OT::glyf::accelerator_t glyf;
+#ifndef HB_NO_SUBSET_CFF
+  OT::cff1::accelerator_t cff;
+#endif
+  OT::COLR::accelerator_t colr;
+};
 
 #ifndef HB_NO_SUBSET_CFF
 static inline void
@@ -69,17 +98,13 @@ _remap_indexes (const hb_set_t *indexes,
 
 static inline void
 _gsub_closure_glyphs_lookups_features (hb_face_t *face,
+				       const hb_set_t *all_lookup_indices,
 				       hb_set_t *gids_to_retain,
 				       hb_map_t *gsub_lookups,
 				       hb_map_t *gsub_features)
 {
   hb_set_t lookup_indices;
-  hb_ot_layout_collect_lookups (face,
-				HB_OT_TAG_GSUB,
-				nullptr,
-				nullptr,
-				nullptr,
-				&lookup_indices);
+  lookup_indices.set (all_lookup_indices);
   hb_ot_layout_lookups_substitute_closure (face,
 					   &lookup_indices,
 					   gids_to_retain);
@@ -102,17 +127,13 @@ _gsub_closure_glyphs_lookups_features (hb_face_t *face,
 
 static inline void
 _gpos_closure_lookups_features (hb_face_t      *face,
+				const hb_set_t *all_lookup_indices,
 				const hb_set_t *gids_to_retain,
 				hb_map_t       *gpos_lookups,
 				hb_map_t       *gpos_features)
 {
   hb_set_t lookup_indices;
-  hb_ot_layout_collect_lookups (face,
-				HB_OT_TAG_GPOS,
-				nullptr,
-				nullptr,
-				nullptr,
-				&lookup_indices);
+  lookup_indices.set (all_lookup_indices);
 #ifdef HB_EXPERIMENTAL_API
   hb_ot_layout_closure_lookups (face,
 				HB_OT_TAG_GPOS,
@@ -134,10 +155,12 @@ _gpos_closure_lookups_features (hb_face_t      *face,
 #ifndef HB_NO_VAR
 static inline void
   _collect_layout_variation_indices (hb_face_t *face,
+				     hb_font_t *instance_font,
 				     const hb_set_t *glyphset,
 				     const hb_map_t *gpos_lookups,
 				     hb_set_t  *layout_variation_indices,
-				     hb_map_t  *layout_variation_idx_map)
+				     hb_map_t  *layout_variation_idx_map,
+				     hb_hashmap_t<unsigned, int> *layout_variation_idx_delta_map)
 {
   hb_blob_ptr_t<OT::GDEF> gdef = hb_sanitize_context_t ().reference_table<OT::GDEF> (face);
   hb_blob_ptr_t<OT::GPOS> gpos = hb_sanitize_context_t ().reference_table<OT::GPOS> (face);
@@ -154,24 +177,24 @@ static inline void
   if (hb_ot_layout_has_positioning (face))
     gpos->collect_variation_indices (&c);
 
-  gdef->remap_layout_variation_indices (layout_variation_indices, layout_variation_idx_map);
-  
+  if (instance_font)
+  {
+    /* The instance keeps no variation store; the values take the deltas. */
+    const OT::VariationStore &var_store = gdef->get_var_store ();
+    for (unsigned idx : layout_variation_indices->iter ())
+    {
+      float delta = var_store.get_delta (idx, instance_font->coords, instance_font->num_coords);
+      layout_variation_idx_delta_map->set (idx, (int) roundf (delta));
+    }
+  }
+  else
+    gdef->remap_layout_variation_indices (layout_variation_indices, layout_variation_idx_map);
+
   gdef.destroy ();
   gpos.destroy ();
 }
 #endif
 
-static inline void
-_cmap_closure (hb_face_t           *face,
-	       const hb_set_t      *unicodes,
-	       hb_set_t            *glyphset)
-{
-  OT::cmap::accelerator_t cmap;
-  cmap.init (face);
-  cmap.table->closure_glyphs (unicodes, glyphset);
-  cmap.fini ();
-}
-
 static inline void
 _remove_invalid_gids (hb_set_t *glyphs,
 		      unsigned int num_glyphs)
@@ -186,31 +209,38 @@ _remove_invalid_gids (hb_set_t *glyphs,
 
 static void
 _populate_gids_to_retain (hb_subset_plan_t* plan,
+			  const hb_subset_base_plan_t *base,
 			  const hb_set_t *unicodes,
-			  const hb_set_t *input_glyphs_to_retain,
-			  bool close_over_gsub,
-			  bool close_over_gpos,
-                          bool close_over_gdef)
+			  const hb_set_t *input_glyphs_to_retain)
 {
-  OT::cmap::accelerator_t cmap;
-  OT::glyf::accelerator_t glyf;
-#ifndef HB_NO_SUBSET_CFF
-  OT::cff1::accelerator_t cff;
-#endif
-  OT::COLR::accelerator_t colr;
-  cmap.init (plan->source);
-  glyf.init (plan->source);
+  const OT::cmap::accelerator_t &cmap = base->accelerators->cmap;
+  const OT::glyf::accelerator_t &glyf = base->accelerators->glyf;
 #ifndef HB_NO_SUBSET_CFF
-  cff.init (plan->source);
+  const OT::cff1::accelerator_t &cff = base->accelerators->cff;
 #endif
-  colr.init (plan->source);
+  const OT::COLR::accelerator_t &colr = base->accelerators->colr;
 
   plan->_glyphset_gsub->add (0); // Not-def
   hb_set_union (plan->_glyphset_gsub, input_glyphs_to_retain);
 
+  /* Walk the cmap instead of an input that has more codepoints than the
+   * font has glyphs, such as all of Unicode. */
+  hb_set_t cmap_unicodes;
+  const hb_set_t *candidates = unicodes;
+  if (unicodes->get_population () > plan->source->get_num_glyphs ())
+  {
+    cmap.collect_unicodes (&cmap_unicodes, UINT_MAX);
+    /* Symbol fonts map these too; see get_glyph_from_symbol (). */
+    cmap_unicodes.add_range (0, 0xFFu);
+    candidates = &cmap_unicodes;
+  }
+
   hb_codepoint_t cp = HB_SET_VALUE_INVALID;
-  while (unicodes->next (&cp))
+  while (candidates->next (&cp))
   {
+    if (candidates != unicodes && !unicodes->has (cp))
+      continue;
+
     hb_codepoint_t gid;
     if (!cmap.get_nominal_glyph (cp, &gid))
     {
@@ -222,15 +252,15 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
     plan->_glyphset_gsub->add (gid);
   }
 
-  _cmap_closure (plan->source, plan->unicodes, plan->_glyphset_gsub);
+  cmap.table->closure_glyphs (plan->unicodes, plan->_glyphset_gsub);
 
 #ifndef HB_NO_SUBSET_LAYOUT
-  if (close_over_gsub)
+  if (base->close_over_gsub)
     // closure all glyphs/lookups/features needed for GSUB substitutions.
-    _gsub_closure_glyphs_lookups_features (plan->source, plan->_glyphset_gsub, plan->gsub_lookups, plan->gsub_features);
+    _gsub_closure_glyphs_lookups_features (plan->source, base->gsub_lookup_indices, plan->_glyphset_gsub, plan->gsub_lookups, plan->gsub_features);
 
-  if (close_over_gpos)
-    _gpos_closure_lookups_features (plan->source, plan->_glyphset_gsub, plan->gpos_lookups, plan->gpos_features);
+  if (base->close_over_gpos)
+    _gpos_closure_lookups_features (plan->source, base->gpos_lookup_indices, plan->_glyphset_gsub, plan->gpos_lookups, plan->gpos_features);
 #endif
   _remove_invalid_gids (plan->_glyphset_gsub, plan->source->get_num_glyphs ());
 
@@ -251,50 +281,43 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
   _remove_invalid_gids (plan->_glyphset, plan->source->get_num_glyphs ());
 
 #ifndef HB_NO_VAR
-  if (close_over_gdef)
-    _collect_layout_variation_indices (plan->source, plan->_glyphset, plan->gpos_lookups, plan->layout_variation_indices, plan->layout_variation_idx_map);
-#endif
-
-#ifndef HB_NO_SUBSET_CFF
-  cff.fini ();
+  /* Instancing folds the deltas into GPOS too, even if GDEF is dropped. */
+  if (base->close_over_gdef || (base->is_instancing () && base->close_over_gpos))
+    _collect_layout_variation_indices (plan->source, plan->instance_font, plan->_glyphset, plan->gpos_lookups,
+				       plan->layout_variation_indices, plan->layout_variation_idx_map,
+				       &plan->_layout_variation_idx_delta_map);
 #endif
-  glyf.fini ();
-  cmap.fini ();
 }
 
 static void
-_create_old_gid_to_new_gid_map (const hb_face_t *face,
-				bool             retain_gids,
-				const hb_set_t  *all_gids_to_retain,
-				hb_map_t        *glyph_map, /* OUT */
-				hb_map_t        *reverse_glyph_map, /* OUT */
-				unsigned int    *num_glyphs /* OUT */)
+_create_old_gid_to_new_gid_map (const hb_face_t  *face,
+				bool              retain_gids,
+				const hb_set_t   *all_gids_to_retain,
+				hb_glyph_bimap_t *glyph_map, /* OUT */
+				unsigned int     *num_glyphs /* OUT */)
 {
+  /* Invalid gids were removed, so old gids are bounded by the source's
+   * num_glyphs and new gids by the old ones. */
+  unsigned int max_glyph = all_gids_to_retain->is_empty () ? 0 : all_gids_to_retain->get_max ();
+
   if (!retain_gids)
   {
+    glyph_map->resize (max_glyph + 1, all_gids_to_retain->get_population ());
     + hb_enumerate (hb_iter (all_gids_to_retain), (hb_codepoint_t) 0)
-    | hb_sink (reverse_glyph_map)
+    | hb_map (&hb_pair_t<hb_codepoint_t, hb_codepoint_t>::reverse)
+    | hb_sink (glyph_map)
     ;
-    *num_glyphs = reverse_glyph_map->get_population ();
+    *num_glyphs = glyph_map->get_population ();
   } else {
+    glyph_map->resize (max_glyph + 1, max_glyph + 1);
     + hb_iter (all_gids_to_retain)
     | hb_map ([] (hb_codepoint_t _) {
 		return hb_pair_t<hb_codepoint_t, hb_codepoint_t> (_, _);
 	      })
-    | hb_sink (reverse_glyph_map)
-    ;
-
-    unsigned max_glyph =
-    + hb_iter (all_gids_to_retain)
-    | hb_reduce (hb_max, 0u)
+    | hb_sink (glyph_map)
     ;
     *num_glyphs = max_glyph + 1;
   }
-
-  + reverse_glyph_map->iter ()
-  | hb_map (&hb_pair_t<hb_codepoint_t, hb_codepoint_t>::reverse)
-  | hb_sink (glyph_map)
-  ;
 }
 
 static void
@@ -309,10 +332,239 @@ _nameid_closure (hb_face_t *face,
 #endif
 }
 
+/* Sets @font to a font at the pinned location, or nullptr if not
+ * instancing.  Returns false on allocation failure. */
+static bool
+_create_instance_font (hb_face_t               *face,
+		       const hb_subset_input_t *input,
+		       hb_font_t              **font /* OUT */)
+{
+  *font = nullptr;
+#ifndef HB_NO_VAR
+  if (!input->axes_location.length || !hb_ot_var_has_data (face))
+    return true;
+
+  hb_font_t *instance = hb_font_create (face);
+  if (unlikely (instance == hb_font_get_empty ()))
+    return false;
+  hb_font_set_variations (instance,
+			  input->axes_location.arrayZ,
+			  input->axes_location.length);
+  if (unlikely (instance->num_coords != hb_ot_var_get_axis_count (face)))
+  {
+    hb_font_destroy (instance);
+    return false;
+  }
+  *font = instance;
+#endif
+  return true;
+}
+
+static bool
+_should_drop_table (const hb_subset_base_plan_t *base, hb_tag_t tag)
+{
+  if (base->drop_tables->has (tag))
+    return true;
+
+  switch (tag)
+  {
+  case HB_TAG ('c','v','a','r'): /* hint variation table */
+    return base->drop_hints || base->is_instancing ();
+
+  case HB_TAG ('c','v','t',' '): /* hint table, fallthrough */
+  case HB_TAG ('f','p','g','m'): /* hint table, fallthrough */
+  case HB_TAG ('p','r','e','p'): /* hint table, fallthrough */
+  case HB_TAG ('h','d','m','x'): /* hint table, fallthrough */
+  case HB_TAG ('V','D','M','X'): /* hint table, fallthrough */
+    return base->drop_hints;
+
+  case HB_TAG ('f','v','a','r'): /* variation table, fallthrough */
+  case HB_TAG ('a','v','a','r'): /* variation table, fallthrough */
+  case HB_TAG ('S','T','A','T'): /* variation table, fallthrough */
+  case HB_TAG ('g','v','a','r'): /* variation table, fallthrough */
+  case HB_TAG ('H','V','A','R'): /* variation table, fallthrough */
+  case HB_TAG ('V','V','A','R'): /* variation table, fallthrough */
+  case HB_TAG ('M','V','A','R'): /* variation table, fallthrough */
+    return base->is_instancing ();
+
+#ifdef HB_NO_SUBSET_LAYOUT
+    // Drop Layout Tables if requested.
+  case HB_OT_TAG_GDEF:
+  case HB_OT_TAG_GPOS:
+  case HB_OT_TAG_GSUB:
+  case HB_TAG ('m','o','r','x'):
+  case HB_TAG ('m','o','r','t'):
+  case HB_TAG ('k','e','r','x'):
+  case HB_TAG ('k','e','r','n'):
+    return true;
+#endif
+
+  default:
+    return false;
+  }
+}
+
+static void
+_collect_table_tags (hb_subset_base_plan_t *base)
+{
+  hb_tag_t table_tags[32];
+  unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
+  while ((hb_face_get_table_tags (base->source, offset, &num_tables, table_tags), num_tables))
+  {
+    for (unsigned i = 0; i < num_tables; ++i)
+      if (!_should_drop_table (base, table_tags[i]))
+	base->table_tags.push (table_tags[i]);
+    offset += num_tables;
+  }
+}
+
+static void
+_collect_lookups (hb_face_t *face,
+		  hb_tag_t   table_tag,
+		  hb_set_t  *lookup_indices /* OUT */)
+{
+  hb_ot_layout_collect_lookups (face,
+				table_tag,
+				nullptr,
+				nullptr,
+				nullptr,
+				lookup_indices);
+}
+
+/**
+ * hb_subset_base_plan_create_or_fail:
+ * @source: font face data to be subset.
+ * @input: input to take the subset options from.
+ *
+ * Computes the part of a subset plan that only depends on @source and the
+ * options of @input (hinting, subroutines, name ids, dropped tables, pinned
+ * axes, ...), but not on its unicode or glyph sets.  The result can be used
+ * with hb_subset_with_base_plan() to subset @source to different unicode
+ * and glyph sets without repeating that work.  Later changes to @input do
+ * not affect the base plan.
+ *
+ * Return value: (transfer full): New base plan, or %NULL on allocation
+ * failure.  Destroy with hb_subset_base_plan_destroy().
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_base_plan_t *
+hb_subset_base_plan_create_or_fail (hb_face_t         *source,
+				    hb_subset_input_t *input)
+{
+  if (unlikely (!source || !input)) return nullptr;
+
+  hb_subset_base_plan_t *base = hb_object_create<hb_subset_base_plan_t> ();
+  if (unlikely (!base)) return nullptr;
+
+  base->accelerators =
+    (hb_subset_closure_accelerators_t *) calloc (1, sizeof (hb_subset_closure_accelerators_t));
+  if (unlikely (!base->accelerators))
+  {
+    hb_subset_base_plan_destroy (base);
+    return nullptr;
+  }
+  base->accelerators->init (source);
+
+  base->drop_hints = input->drop_hints;
+  base->desubroutinize = input->desubroutinize;
+  base->subroutinize = input->subroutinize;
+  base->retain_gids = input->retain_gids;
+  base->name_legacy = input->name_legacy;
+  base->close_over_gsub = !input->drop_tables->has (HB_OT_TAG_GSUB);
+  base->close_over_gpos = !input->drop_tables->has (HB_OT_TAG_GPOS);
+  base->close_over_gdef = !input->drop_tables->has (HB_OT_TAG_GDEF);
+  base->source = hb_face_reference (source);
+  base->name_ids = hb_set_create ();
+  base->name_ids->set (input->name_ids);
+  _nameid_closure (source, base->name_ids);
+  base->name_languages = hb_set_create ();
+  base->name_languages->set (input->name_languages);
+  base->drop_tables = hb_set_create ();
+  base->drop_tables->set (input->drop_tables);
+  base->table_tags.init ();
+  bool success = _create_instance_font (source, input, &base->instance_font);
+  if (likely (success && !base->drop_tables->in_error ()))
+    _collect_table_tags (base);
+
+  base->gsub_lookup_indices = hb_set_create ();
+  base->gpos_lookup_indices = hb_set_create ();
+#ifndef HB_NO_SUBSET_LAYOUT
+  if (base->close_over_gsub)
+    _collect_lookups (source, HB_OT_TAG_GSUB, base->gsub_lookup_indices);
+  if (base->close_over_gpos)
+    _collect_lookups (source, HB_OT_TAG_GPOS, base->gpos_lookup_indices);
+#endif
+
+  success = success &&
+	    !base->name_ids->in_error () &&
+	    !base->name_languages->in_error () &&
+	    !base->drop_tables->in_error () &&
+	    !base->table_tags.in_error () &&
+	    !base->gsub_lookup_indices->in_error () &&
+	    !base->gpos_lookup_indices->in_error ();
+#ifndef HB_NO_SUBSET_CFF
+  /* The CFF accelerator is left invalid if it fails to allocate. */
+  success = success &&
+	    (!base->has_table (HB_OT_TAG_cff1) || base->accelerators->cff.is_valid ());
+#endif
+
+  if (unlikely (!success))
+  {
+    hb_subset_base_plan_destroy (base);
+    return nullptr;
+  }
+
+  return base;
+}
+
+/**
+ * hb_subset_base_plan_reference: (skip)
+ * @base_plan: a base plan.
+ *
+ * Return value: @base_plan, with its reference count increased.
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_base_plan_t *
+hb_subset_base_plan_reference (hb_subset_base_plan_t *base_plan)
+{
+  return hb_object_reference (base_plan);
+}
+
+/**
+ * hb_subset_base_plan_destroy:
+ * @base_plan: a base plan.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_base_plan_destroy (hb_subset_base_plan_t *base_plan)
+{
+  if (!hb_object_destroy (base_plan)) return;
+
+  if (base_plan->accelerators)
+  {
+    base_plan->accelerators->fini ();
+    free (base_plan->accelerators);
+  }
+  hb_set_destroy (base_plan->gsub_lookup_indices);
+  hb_set_destroy (base_plan->gpos_lookup_indices);
+  base_plan->table_tags.fini ();
+  if (base_plan->instance_font)
+    hb_font_destroy (base_plan->instance_font);
+  hb_set_destroy (base_plan->drop_tables);
+  hb_set_destroy (base_plan->name_languages);
+  hb_set_destroy (base_plan->name_ids);
+  hb_face_destroy (base_plan->source);
+
+  free (base_plan);
+}
+
 /**
  * hb_subset_plan_create:
- * Computes a plan for subsetting the supplied face according
- * to a provided input. The plan describes
+ * Computes a plan for subsetting the face of the supplied base plan
+ * to the given unicodes and glyphs. The plan describes
  * which tables and glyphs should be retained.
  *
  * Return value: New subset plan.
@@ -320,48 +572,47 @@ _nameid_closure (hb_face_t *face,
  * Since: 1.7.5
  **/
 hb_subset_plan_t *
-hb_subset_plan_create (hb_face_t         *face,
-		       hb_subset_input_t *input)
+hb_subset_plan_create (hb_subset_base_plan_t *base,
+		       const hb_set_t        *unicodes,
+		       const hb_set_t        *glyphs)
 {
   hb_subset_plan_t *plan = hb_object_create<hb_subset_plan_t> ();
 
-  plan->drop_hints = input->drop_hints;
-  plan->desubroutinize = input->desubroutinize;
-  plan->retain_gids = input->retain_gids;
-  plan->name_legacy = input->name_legacy;
+  plan->drop_hints = base->drop_hints;
+  plan->desubroutinize = base->desubroutinize;
+  plan->subroutinize = base->subroutinize;
+  plan->retain_gids = base->retain_gids;
+  plan->name_legacy = base->name_legacy;
   plan->unicodes = hb_set_create ();
-  plan->name_ids = hb_set_reference (input->name_ids);
-  _nameid_closure (face, plan->name_ids);
-  plan->name_languages = hb_set_reference (input->name_languages);
-  plan->glyphs_requested = hb_set_reference (input->glyphs);
-  plan->drop_tables = hb_set_reference (input->drop_tables);
-  plan->source = hb_face_reference (face);
+  plan->name_ids = hb_set_reference (base->name_ids);
+  plan->name_languages = hb_set_reference (base->name_languages);
+  plan->glyphs_requested = hb_set_create ();
+  plan->glyphs_requested->set (glyphs);
+  plan->drop_tables = hb_set_reference (base->drop_tables);
+  plan->source = hb_face_reference (base->source);
   plan->dest = hb_face_builder_create ();
 
   plan->_glyphset = hb_set_create ();
   plan->_glyphset_gsub = hb_set_create ();
   plan->codepoint_to_glyph = hb_map_create ();
-  plan->glyph_map = hb_map_create ();
-  plan->reverse_glyph_map = hb_map_create ();
+  plan->glyph_bimap.init ();
+  plan->glyph_map = &plan->glyph_bimap.forward_map ();
+  plan->reverse_glyph_map = &plan->glyph_bimap.backward_map ();
   plan->gsub_lookups = hb_map_create ();
   plan->gpos_lookups = hb_map_create ();
   plan->gsub_features = hb_map_create ();
   plan->gpos_features = hb_map_create ();
   plan->layout_variation_indices = hb_set_create ();
   plan->layout_variation_idx_map = hb_map_create ();
+  plan->_layout_variation_idx_delta_map.init ();
+  plan->instance_font = base->instance_font ? hb_font_reference (base->instance_font) : nullptr;
 
-  _populate_gids_to_retain (plan,
-			    input->unicodes,
-			    input->glyphs,
-			    !input->drop_tables->has (HB_OT_TAG_GSUB),
-			    !input->drop_tables->has (HB_OT_TAG_GPOS),
-                            !input->drop_tables->has (HB_OT_TAG_GDEF));
+  _populate_gids_to_retain (plan, base, unicodes, glyphs);
 
-  _create_old_gid_to_new_gid_map (face,
-				  input->retain_gids,
+  _create_old_gid_to_new_gid_map (plan->source,
+				  base->retain_gids,
 				  plan->_glyphset,
-				  plan->glyph_map,
-				  plan->reverse_glyph_map,
+				  &plan->glyph_bimap,
 				  &plan->_num_output_glyphs);
 
   return plan;
@@ -385,8 +636,7 @@ hb_subset_plan_destroy (hb_subset_plan_t *plan)
   hb_face_destroy (plan->source);
   hb_face_destroy (plan->dest);
   hb_map_destroy (plan->codepoint_to_glyph);
-  hb_map_destroy (plan->glyph_map);
-  hb_map_destroy (plan->reverse_glyph_map);
+  plan->glyph_bimap.fini ();
   hb_set_destroy (plan->_glyphset);
   hb_set_destroy (plan->_glyphset_gsub);
   hb_map_destroy (plan->gsub_lookups);
@@ -395,6 +645,9 @@ hb_subset_plan_destroy (hb_subset_plan_t *plan)
   hb_map_destroy (plan->gpos_features);
   hb_set_destroy (plan->layout_variation_indices);
   hb_map_destroy (plan->layout_variation_idx_map);
+  plan->_layout_variation_idx_delta_map.fini ();
+  if (plan->instance_font)
+    hb_font_destroy (plan->instance_font);
 
 
   free (plan);
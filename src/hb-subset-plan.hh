@@ -33,14 +33,76 @@
 #include "hb-subset-input.hh"
 
 #include "hb-map.hh"
+#include "hb-bimap.hh"
 #include "hb-set.hh"
 
+struct hb_subset_closure_accelerators_t;
+
+/*
+ * The part of a subset plan that only depends on the source face and the
+ * subset options, not on the requested unicodes or glyphs.  Computed once by
+ * hb_subset_base_plan_create_or_fail() and shared by any number of
+ * hb_subset_with_base_plan() calls.
+ */
+struct hb_subset_base_plan_t
+{
+  hb_object_header_t header;
+
+  bool drop_hints : 1;
+  bool desubroutinize : 1;
+  bool subroutinize : 1;
+  bool retain_gids : 1;
+  bool name_legacy : 1;
+  bool close_over_gsub : 1;
+  bool close_over_gpos : 1;
+  bool close_over_gdef : 1;
+
+  hb_face_t *source;
+
+  // name_ids we would like to retain, closed over STAT and fvar references.
+  hb_set_t *name_ids;
+
+  // name_languages we would like to retain
+  hb_set_t *name_languages;
+
+  // Tables which should be dropped.
+  hb_set_t *drop_tables;
+
+  // Tables to subset, in source order.
+  hb_vector_t<hb_tag_t> table_tags;
+
+  // All GSUB/GPOS lookups; the starting point of the lookup closures.
+  hb_set_t *gsub_lookup_indices;
+  hb_set_t *gpos_lookup_indices;
+
+  // Table accelerators used to compute glyph closures.
+  hb_subset_closure_accelerators_t *accelerators;
+
+  // Font set to the pinned axis location when instancing, nullptr otherwise.
+  hb_font_t *instance_font;
+
+ public:
+
+  inline bool
+  is_instancing () const
+  {
+    return instance_font;
+  }
+
+  inline bool
+  has_table (hb_tag_t tag) const
+  {
+    return table_tags.find (tag);
+  }
+};
+
 struct hb_subset_plan_t
 {
   hb_object_header_t header;
 
   bool drop_hints : 1;
   bool desubroutinize : 1;
+  bool subroutinize : 1;
   bool retain_gids : 1;
   bool name_legacy : 1;
 
@@ -62,9 +124,11 @@ struct hb_subset_plan_t
   // The glyph subset
   hb_map_t *codepoint_to_glyph;
 
-  // Old -> New glyph id mapping
-  hb_map_t *glyph_map;
-  hb_map_t *reverse_glyph_map;
+  // Old <-> New glyph id mapping; glyph_map and reverse_glyph_map point
+  // to its two directions.
+  hb_glyph_bimap_t glyph_bimap;
+  const hb_dense_map_t *glyph_map;
+  const hb_dense_map_t *reverse_glyph_map;
 
   // Plan is only good for a specific source/dest so keep them with it
   hb_face_t *source;
@@ -86,6 +150,12 @@ struct hb_subset_plan_t
   hb_set_t *layout_variation_indices;
   //Old -> New layout item variation store delta set index mapping
   hb_map_t *layout_variation_idx_map;
+  //Layout item variation store delta set index -> delta at the instance,
+  //rounded to design units; only filled when instancing
+  hb_hashmap_t<unsigned, int> _layout_variation_idx_delta_map;
+
+  // Font set to the pinned axis location when instancing, nullptr otherwise.
+  hb_font_t *instance_font;
 
  public:
 
@@ -159,6 +229,26 @@ struct hb_subset_plan_t
     return true;
   }
 
+  /*
+   * Whether the output is a static instance of a variable source font.
+   */
+  inline bool
+  is_instancing () const
+  {
+    return instance_font;
+  }
+
+  /*
+   * When instancing, the deltas to fold into the GDEF/GPOS values that
+   * device tables vary, as the instance keeps no variation store; nullptr
+   * otherwise.
+   */
+  inline const hb_hashmap_t<unsigned, int> *
+  layout_variation_idx_delta_map () const
+  {
+    return is_instancing () ? &_layout_variation_idx_delta_map : nullptr;
+  }
+
   inline bool
   add_table (hb_tag_t tag,
 	     hb_blob_t *contents)
@@ -176,8 +266,9 @@ struct hb_subset_plan_t
 typedef struct hb_subset_plan_t hb_subset_plan_t;
 
 HB_INTERNAL hb_subset_plan_t *
-hb_subset_plan_create (hb_face_t           *face,
-		       hb_subset_input_t   *input);
+hb_subset_plan_create (hb_subset_base_plan_t *base,
+		       const hb_set_t        *unicodes,
+		       const hb_set_t        *glyphs);
 
 HB_INTERNAL void
 hb_subset_plan_destroy (hb_subset_plan_t *plan);
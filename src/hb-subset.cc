@@ -53,7 +53,7 @@
 
 
 static unsigned
-_plan_estimate_subset_table_size (hb_subset_plan_t *plan, unsigned table_len)
+_plan_estimate_subset_table_size (hb_subset_plan_t *plan, hb_tag_t tag, unsigned table_len)
 {
   unsigned src_glyphs = plan->source->get_num_glyphs ();
   unsigned dst_glyphs = plan->glyphset ()->get_population ();
@@ -61,7 +61,12 @@ _plan_estimate_subset_table_size (hb_subset_plan_t *plan, unsigned table_len)
   if (unlikely (!src_glyphs))
     return 512 + table_len;
 
-  return 512 + (unsigned) (table_len * sqrt ((double) dst_glyphs / src_glyphs));
+  unsigned estimate = 512 + (unsigned) (table_len * sqrt ((double) dst_glyphs / src_glyphs));
+  /* Every glyf glyph may gain a padding byte; leave room for those, such that
+   * large glyf tables don't run out of room and get subsetted twice. */
+  if (tag == HB_OT_TAG_glyf)
+    estimate += dst_glyphs;
+  return estimate;
 }
 
 template<typename TableType>
@@ -78,7 +83,7 @@ _subset (hb_subset_plan_t *plan)
     hb_vector_t<char> buf;
     /* TODO Not all tables are glyph-related.  'name' table size for example should not be
      * affected by number of glyphs.  Accommodate that. */
-    unsigned buf_size = _plan_estimate_subset_table_size (plan, source_blob->length);
+    unsigned buf_size = _plan_estimate_subset_table_size (plan, tag, source_blob->length);
     DEBUG_MSG (SUBSET, nullptr, "OT::%c%c%c%c initial estimated table size: %u bytes.", HB_UNTAG (tag), buf_size);
     if (unlikely (!buf.alloc (buf_size)))
     {
@@ -131,55 +136,7 @@ _subset (hb_subset_plan_t *plan)
 }
 
 static bool
-_is_table_present (hb_face_t *source, hb_tag_t tag)
-{
-  hb_tag_t table_tags[32];
-  unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
-  while ((hb_face_get_table_tags (source, offset, &num_tables, table_tags), num_tables))
-  {
-    for (unsigned i = 0; i < num_tables; ++i)
-      if (table_tags[i] == tag)
-	return true;
-    offset += num_tables;
-  }
-  return false;
-}
-
-static bool
-_should_drop_table (hb_subset_plan_t *plan, hb_tag_t tag)
-{
-  if (plan->drop_tables->has (tag))
-    return true;
-
-  switch (tag)
-  {
-  case HB_TAG ('c','v','a','r'): /* hint table, fallthrough */
-  case HB_TAG ('c','v','t',' '): /* hint table, fallthrough */
-  case HB_TAG ('f','p','g','m'): /* hint table, fallthrough */
-  case HB_TAG ('p','r','e','p'): /* hint table, fallthrough */
-  case HB_TAG ('h','d','m','x'): /* hint table, fallthrough */
-  case HB_TAG ('V','D','M','X'): /* hint table, fallthrough */
-    return plan->drop_hints;
-
-#ifdef HB_NO_SUBSET_LAYOUT
-    // Drop Layout Tables if requested.
-  case HB_OT_TAG_GDEF:
-  case HB_OT_TAG_GPOS:
-  case HB_OT_TAG_GSUB:
-  case HB_TAG ('m','o','r','x'):
-  case HB_TAG ('m','o','r','t'):
-  case HB_TAG ('k','e','r','x'):
-  case HB_TAG ('k','e','r','n'):
-    return true;
-#endif
-
-  default:
-    return false;
-  }
-}
-
-static bool
-_subset_table (hb_subset_plan_t *plan, hb_tag_t tag)
+_subset_table (const hb_subset_base_plan_t *base, hb_subset_plan_t *plan, hb_tag_t tag)
 {
   DEBUG_MSG (SUBSET, nullptr, "subset %c%c%c%c", HB_UNTAG (tag));
   switch (tag)
@@ -188,7 +145,7 @@ _subset_table (hb_subset_plan_t *plan, hb_tag_t tag)
   case HB_OT_TAG_hdmx: return _subset<const OT::hdmx> (plan);
   case HB_OT_TAG_name: return _subset<const OT::name> (plan);
   case HB_OT_TAG_head:
-    if (_is_table_present (plan->source, HB_OT_TAG_glyf) && !_should_drop_table (plan, HB_OT_TAG_glyf))
+    if (base->has_table (HB_OT_TAG_glyf))
       return true; /* skip head, handled by glyf */
     return _subset<const OT::head> (plan);
   case HB_OT_TAG_hhea: return true; /* skip hhea, handled by hmtx */
@@ -240,25 +197,44 @@ hb_subset (hb_face_t *source, hb_subset_input_t *input)
 {
   if (unlikely (!input || !source)) return hb_face_get_empty ();
 
-  hb_subset_plan_t *plan = hb_subset_plan_create (source, input);
+  hb_subset_base_plan_t *base = hb_subset_base_plan_create_or_fail (source, input);
+  hb_face_t *result = hb_subset_with_base_plan (base, input->unicodes, input->glyphs);
+  hb_subset_base_plan_destroy (base);
+  return result;
+}
+
+/**
+ * hb_subset_with_base_plan:
+ * @base_plan: base plan from hb_subset_base_plan_create_or_fail().
+ * @unicodes: (nullable): codepoints to retain.
+ * @glyphs: (nullable): glyph ids to retain.
+ *
+ * Subsets the font face of @base_plan, with the options it was created
+ * with, to @unicodes and @glyphs.  Equivalent to hb_subset() with an input
+ * that has those sets, but the face and option dependent work was done
+ * once, when creating @base_plan.
+ *
+ * Return value: (transfer full): The subset face.
+ *
+ * Since: REPLACEME
+ **/
+hb_face_t *
+hb_subset_with_base_plan (hb_subset_base_plan_t *base_plan,
+			  const hb_set_t        *unicodes,
+			  const hb_set_t        *glyphs)
+{
+  if (unlikely (!base_plan)) return hb_face_get_empty ();
+  if (!unicodes) unicodes = hb_set_get_empty ();
+  if (!glyphs) glyphs = hb_set_get_empty ();
+
+  hb_subset_plan_t *plan = hb_subset_plan_create (base_plan, unicodes, glyphs);
 
-  hb_set_t tags_set;
   bool success = true;
-  hb_tag_t table_tags[32];
-  unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
-  while ((hb_face_get_table_tags (source, offset, &num_tables, table_tags), num_tables))
+  for (hb_tag_t tag : base_plan->table_tags)
   {
-    for (unsigned i = 0; i < num_tables; ++i)
-    {
-      hb_tag_t tag = table_tags[i];
-      if (_should_drop_table (plan, tag) && !tags_set.has (tag)) continue;
-      tags_set.add (tag);
-      success = _subset_table (plan, tag);
-      if (unlikely (!success)) goto end;
-    }
-    offset += num_tables;
+    success = _subset_table (base_plan, plan, tag);
+    if (unlikely (!success)) break;
   }
-end:
 
   hb_face_t *result = success ? hb_face_reference (plan->dest) : hb_face_get_empty ();
   hb_subset_plan_destroy (plan);
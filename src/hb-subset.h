@@ -75,6 +75,12 @@ hb_subset_input_set_desubroutinize (hb_subset_input_t *subset_input,
 HB_EXTERN hb_bool_t
 hb_subset_input_get_desubroutinize (hb_subset_input_t *subset_input);
 
+HB_EXTERN void
+hb_subset_input_set_subroutinize (hb_subset_input_t *subset_input,
+				  hb_bool_t subroutinize);
+HB_EXTERN hb_bool_t
+hb_subset_input_get_subroutinize (hb_subset_input_t *subset_input);
+
 HB_EXTERN void
 hb_subset_input_set_retain_gids (hb_subset_input_t *subset_input,
 				 hb_bool_t retain_gids);
@@ -87,10 +93,45 @@ hb_subset_input_set_name_legacy (hb_subset_input_t *subset_input,
 HB_EXTERN hb_bool_t
 hb_subset_input_get_name_legacy (hb_subset_input_t *subset_input);
 
+HB_EXTERN hb_bool_t
+hb_subset_input_pin_axis_location (hb_subset_input_t *subset_input,
+				   hb_face_t         *face,
+				   hb_tag_t           axis_tag,
+				   float              axis_value);
+
+HB_EXTERN hb_bool_t
+hb_subset_input_pin_axis_to_default (hb_subset_input_t *subset_input,
+				     hb_face_t         *face,
+				     hb_tag_t           axis_tag);
+
 /* hb_subset () */
 HB_EXTERN hb_face_t *
 hb_subset (hb_face_t *source, hb_subset_input_t *input);
 
+/*
+ * hb_subset_base_plan_t
+ *
+ * Per face and options work, reusable across subsets of different
+ * unicodes and glyphs.
+ */
+
+typedef struct hb_subset_base_plan_t hb_subset_base_plan_t;
+
+HB_EXTERN hb_subset_base_plan_t *
+hb_subset_base_plan_create_or_fail (hb_face_t         *source,
+				    hb_subset_input_t *input);
+
+HB_EXTERN hb_subset_base_plan_t *
+hb_subset_base_plan_reference (hb_subset_base_plan_t *base_plan);
+
+HB_EXTERN void
+hb_subset_base_plan_destroy (hb_subset_base_plan_t *base_plan);
+
+HB_EXTERN hb_face_t *
+hb_subset_with_base_plan (hb_subset_base_plan_t *base_plan,
+			  const hb_set_t        *unicodes,
+			  const hb_set_t        *glyphs);
+
 
 HB_END_DECLS
 
@@ -47,6 +47,35 @@ main (int argc, char **argv)
   bm.clear ();
   assert (bm.get_population () == 0);
 
+  hb_glyph_bimap_t  gbm;
+
+  assert (gbm.is_empty () == true);
+  gbm.resize (8, 4);
+  assert (gbm.get_population () == 0);
+  gbm.set (7, 0);
+  gbm.set (2, 1);
+  gbm.set (20, 2);
+  assert (gbm.get_population () == 3);
+  assert (gbm[7] == 0);
+  assert (gbm[20] == 2);
+  assert (gbm.has (3) == false);
+  assert (gbm.has (100) == false);
+  assert (gbm.backward (1) == 2);
+  assert (gbm.backward (3) == HB_MAP_VALUE_INVALID);
+  gbm.set (2, 3);
+  assert (gbm.get_population () == 3);
+  assert (gbm[2] == 3);
+  assert (gbm.forward_map ().keys ().len () == 3);
+  assert ((*gbm.forward_map ().iter ()).first == 2);
+  assert (*gbm.forward_map ().values () == 3);
+  gbm.del (7);
+  assert (gbm.has (7) == false);
+  assert (gbm.backward (0) == HB_MAP_VALUE_INVALID);
+  assert (gbm.get_population () == 2);
+  gbm.clear ();
+  assert (gbm.get_population () == 0);
+  assert (gbm.has (20) == false);
+
   hb_inc_bimap_t  ibm;
 
   assert (ibm.add (13) == 0);
@@ -142,6 +142,12 @@ main (int argc, char **argv)
   hb_set_t st;
   st << 1 << 15 << 43;
   test_iterable (st);
+  assert (hb_len (st.iter ()) == 3);
+  hb_set_t full;
+  full.invert ();
+  assert (hb_len (full.iter ()) == HB_SET_VALUE_INVALID);
+  full.del (7);
+  assert (hb_len (full.iter ()) == HB_SET_VALUE_INVALID - 1);
   hb_sorted_array_t<int> sa;
   (void) static_cast<hb_iter_t<hb_sorted_array_t<int>, hb_sorted_array_t<int>::item_t>&> (sa);
   (void) static_cast<hb_iter_t<hb_sorted_array_t<int>, hb_sorted_array_t<int>::__item_t__>&> (sa);
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2020  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ */
+
+#include "hb.hh"
+#include "hb-set.hh"
+#include "hb-set-digest.hh"
+
+/* Builds an adaptive digest of every @step'th glyph in [@first, @last]
+ * and checks that it picked @kind, has every member, and rejects some
+ * of the glyphs in between. */
+static void
+test_adaptive (hb_codepoint_t first, hb_codepoint_t last, unsigned step,
+	       hb_set_digest_adaptive_t::kind_t kind)
+{
+  hb_set_t set;
+  for (hb_codepoint_t g = first; g <= last; g += step)
+    set.add (g);
+
+  hb_set_digest_adaptive_t digest;
+  digest.init (set);
+  assert (digest.get_kind () == kind);
+  assert (digest.get_false_positives () <= digest.get_samples ());
+
+  for (hb_codepoint_t g = HB_SET_VALUE_INVALID; set.next (&g);)
+    assert (digest.may_have (g));
+
+  unsigned non_members = 0, rejected = 0;
+  for (hb_codepoint_t g = 0; g <= last + step; g++)
+  {
+    if (set.has (g)) continue;
+    non_members++;
+    if (!digest.may_have (g)) rejected++;
+  }
+  assert (non_members);
+  assert (rejected);
+  if (kind == hb_set_digest_adaptive_t::BITMAP)
+    assert (rejected == non_members);
+
+  digest.fini ();
+}
+
+int
+main (int argc, char **argv)
+{
+  /* A handful of glyphs: the lowest bits filter them well enough. */
+  test_adaptive (10, 40, 10, hb_set_digest_adaptive_t::LOWEST_BITS);
+
+  /* Every third glyph sets every lowest bit, but the span is small enough
+   * for an exact bitmap. */
+  test_adaptive (100, 6100, 3, hb_set_digest_adaptive_t::BITMAP);
+
+  /* Same pattern over a span too wide for a bitmap. */
+  test_adaptive (100, 60100, 7, hb_set_digest_adaptive_t::BLOOM);
+
+  /* An empty set has nothing, and stays on the lowest bits. */
+  {
+    hb_set_t set;
+    hb_set_digest_adaptive_t digest;
+    digest.init (set);
+    assert (digest.get_kind () == hb_set_digest_adaptive_t::LOWEST_BITS);
+    assert (!digest.may_have (0));
+    assert (!digest.may_have (1000));
+    digest.fini ();
+  }
+
+  return 0;
+}
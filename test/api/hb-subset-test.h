@@ -107,6 +107,92 @@ hb_subset_test_check (hb_face_t *expected,
   hb_blob_destroy (actual_blob);
 }
 
+/* Subsets @source to @codepoints with subroutinization and checks that
+ * flattening the result gives @expected back.  Returns the subroutinized
+ * subset. */
+static inline hb_face_t *
+hb_subset_test_check_subroutinize (hb_face_t      *source,
+				   hb_face_t      *expected,
+				   const hb_set_t *codepoints,
+				   hb_tag_t        table)
+{
+  hb_subset_input_t *input;
+  hb_face_t *subset, *subr, *desubr;
+  hb_blob_t *subset_blob;
+
+  input = hb_subset_test_create_input (codepoints);
+  hb_subset_input_set_subroutinize (input, true);
+  subset = hb_subset_test_create_subset (source, input);
+  subset_blob = hb_face_reference_blob (subset);
+  subr = hb_face_create (subset_blob, 0);
+  hb_blob_destroy (subset_blob);
+  hb_face_destroy (subset);
+
+  input = hb_subset_test_create_input (codepoints);
+  hb_subset_input_set_desubroutinize (input, true);
+  desubr = hb_subset_test_create_subset (subr, input);
+  hb_subset_test_check (expected, desubr, table);
+  hb_face_destroy (desubr);
+
+  return subr;
+}
+
+/* Checks that shaping @text with @instance, an instance of @source pinned
+ * at @value on @axis, gives the glyph positions and extents of @source at
+ * that location. */
+static inline void
+hb_subset_test_check_instance (hb_face_t  *source,
+			       hb_face_t  *instance,
+			       hb_tag_t    axis,
+			       float       value,
+			       const char *text)
+{
+  hb_variation_t variation = { axis, value };
+  hb_font_t *source_font = hb_font_create (source);
+  hb_font_t *instance_font = hb_font_create (instance);
+  hb_buffer_t *source_buffer = hb_buffer_create ();
+  hb_buffer_t *instance_buffer = hb_buffer_create ();
+  hb_glyph_info_t *source_info, *instance_info;
+  hb_glyph_position_t *source_pos, *instance_pos;
+  unsigned int source_len, instance_len, i;
+
+  hb_font_set_variations (source_font, &variation, 1);
+
+  hb_buffer_add_utf8 (source_buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (source_buffer);
+  hb_shape (source_font, source_buffer, NULL, 0);
+  hb_buffer_add_utf8 (instance_buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (instance_buffer);
+  hb_shape (instance_font, instance_buffer, NULL, 0);
+
+  source_info = hb_buffer_get_glyph_infos (source_buffer, &source_len);
+  source_pos = hb_buffer_get_glyph_positions (source_buffer, NULL);
+  instance_info = hb_buffer_get_glyph_infos (instance_buffer, &instance_len);
+  instance_pos = hb_buffer_get_glyph_positions (instance_buffer, NULL);
+  g_assert_cmpuint (source_len, ==, instance_len);
+
+  for (i = 0; i < source_len; i++)
+  {
+    hb_glyph_extents_t source_extents, instance_extents;
+
+    g_assert_cmpint (source_pos[i].x_advance, ==, instance_pos[i].x_advance);
+    g_assert_cmpint (source_pos[i].y_advance, ==, instance_pos[i].y_advance);
+    g_assert_cmpint (source_pos[i].x_offset, ==, instance_pos[i].x_offset);
+    g_assert_cmpint (source_pos[i].y_offset, ==, instance_pos[i].y_offset);
+
+    g_assert (hb_font_get_glyph_extents (source_font, source_info[i].codepoint, &source_extents));
+    g_assert (hb_font_get_glyph_extents (instance_font, instance_info[i].codepoint, &instance_extents));
+    g_assert_cmpint (source_extents.x_bearing, ==, instance_extents.x_bearing);
+    g_assert_cmpint (source_extents.y_bearing, ==, instance_extents.y_bearing);
+    g_assert_cmpint (source_extents.width, ==, instance_extents.width);
+    g_assert_cmpint (source_extents.height, ==, instance_extents.height);
+  }
+
+  hb_buffer_destroy (instance_buffer);
+  hb_buffer_destroy (source_buffer);
+  hb_font_destroy (instance_font);
+  hb_font_destroy (source_font);
+}
 
 HB_END_DECLS
 
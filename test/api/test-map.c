@@ -62,6 +62,37 @@ test_map_basic (void)
   hb_map_destroy (m);
 }
 
+static void
+test_map_population (void)
+{
+  hb_map_t *m = hb_map_create ();
+  unsigned int i;
+
+  /* Overwriting and re-adding keys doesn't change the population. */
+  hb_map_set (m, 1, 2);
+  hb_map_set (m, 1, 3);
+  g_assert_cmpint (hb_map_get_population (m), ==, 1);
+  g_assert_cmpint (hb_map_get (m, 1), ==, 3);
+  hb_map_del (m, 1);
+  hb_map_del (m, 1);
+  g_assert_cmpint (hb_map_get_population (m), ==, 0);
+  hb_map_set (m, 1, 4);
+  g_assert_cmpint (hb_map_get_population (m), ==, 1);
+
+  /* Keys that differ only in their high bits. */
+  for (i = 0; i < 5000; i++)
+    hb_map_set (m, i << 16, i);
+  for (i = 0; i < 5000; i += 2)
+    hb_map_del (m, i << 16);
+  g_assert_cmpint (hb_map_get_population (m), ==, 2501);
+  for (i = 0; i < 5000; i++)
+    g_assert_cmpint (hb_map_get (m, i << 16), ==, i & 1 ? i : HB_MAP_VALUE_INVALID);
+  g_assert_cmpint (hb_map_get (m, 1), ==, 4);
+  g_assert (hb_map_allocation_successful (m));
+
+  hb_map_destroy (m);
+}
+
 static void
 test_map_userdata (void)
 {
@@ -110,6 +141,7 @@ main (int argc, char **argv)
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_map_basic);
+  hb_test_add (test_map_population);
   hb_test_add (test_map_userdata);
   hb_test_add (test_map_refcount);
 
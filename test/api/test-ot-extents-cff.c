@@ -120,6 +120,182 @@ test_extents_cff1_seac (void)
   hb_font_destroy (font);
 }
 
+#ifdef HB_EXPERIMENTAL_API
+/* Records the points a glyph is drawn with, and their bounds. */
+typedef struct draw_record_t
+{
+  int points[256];
+  unsigned int length;
+  int x_min, y_min, x_max, y_max;
+} draw_record_t;
+
+static void
+_draw_point (hb_position_t x, hb_position_t y, draw_record_t *record)
+{
+  if (!record->length)
+  {
+    record->x_min = record->x_max = x;
+    record->y_min = record->y_max = y;
+  }
+  record->x_min = MIN (record->x_min, x);
+  record->y_min = MIN (record->y_min, y);
+  record->x_max = MAX (record->x_max, x);
+  record->y_max = MAX (record->y_max, y);
+  g_assert_cmpuint (record->length + 2, <=, G_N_ELEMENTS (record->points));
+  record->points[record->length++] = x;
+  record->points[record->length++] = y;
+}
+
+static void
+_draw_move_to (hb_position_t to_x, hb_position_t to_y, draw_record_t *record)
+{ _draw_point (to_x, to_y, record); }
+
+static void
+_draw_cubic_to (hb_position_t control1_x, hb_position_t control1_y,
+		hb_position_t control2_x, hb_position_t control2_y,
+		hb_position_t to_x, hb_position_t to_y,
+		draw_record_t *record)
+{
+  _draw_point (control1_x, control1_y, record);
+  _draw_point (control2_x, control2_y, record);
+  _draw_point (to_x, to_y, record);
+}
+
+static void
+_draw_close_path (draw_record_t *record HB_UNUSED) {}
+
+/* Draws @glyph and checks that its outline has the bounds its extents
+ * report: CFF extents include the control points. */
+static void
+_draw_and_check_extents (hb_font_t *font, hb_codepoint_t glyph,
+			 draw_record_t *record)
+{
+  hb_draw_funcs_t *funcs = hb_draw_funcs_create ();
+  hb_draw_funcs_set_move_to_func (funcs, (hb_draw_move_to_func_t) _draw_move_to);
+  hb_draw_funcs_set_line_to_func (funcs, (hb_draw_line_to_func_t) _draw_move_to);
+  hb_draw_funcs_set_cubic_to_func (funcs, (hb_draw_cubic_to_func_t) _draw_cubic_to);
+  hb_draw_funcs_set_close_path_func (funcs, (hb_draw_close_path_func_t) _draw_close_path);
+
+  record->length = 0;
+  g_assert (hb_font_draw_glyph (font, glyph, funcs, record));
+  hb_draw_funcs_destroy (funcs);
+  g_assert_cmpuint (record->length, >, 0);
+
+  hb_glyph_extents_t extents;
+  g_assert (hb_font_get_glyph_extents (font, glyph, &extents));
+  g_assert_cmpint (extents.x_bearing, ==, record->x_min);
+  g_assert_cmpint (extents.y_bearing, ==, record->y_max);
+  g_assert_cmpint (extents.width, ==, record->x_max - record->x_min);
+  g_assert_cmpint (extents.height, ==, record->y_min - record->y_max);
+}
+
+static void
+_assert_same_outline (const draw_record_t *a, const draw_record_t *b)
+{
+  g_assert_cmpmem (a->points, a->length * sizeof (int),
+		   b->points, b->length * sizeof (int));
+}
+
+static void
+test_extents_cff1_seac_cached (void)
+{
+  /* Decoded charstrings are cached on the face, so each case below opens
+   * its own.  Agrave and Udieresis are drawn first with nothing cached,
+   * which resolves their seac by decoding the components; then again
+   * with all of it cached. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/cff1_seac.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_ot_font_set_funcs (font);
+
+  draw_record_t agrave, udieresis, warm;
+  _draw_and_check_extents (font, 3, &agrave);
+  g_assert_cmpint (agrave.x_min, ==, 3);
+  g_assert_cmpint (agrave.y_min, ==, 0);
+  g_assert_cmpint (agrave.x_max, ==, 541);
+  g_assert_cmpint (agrave.y_max, ==, 861);
+  _draw_and_check_extents (font, 3, &warm);
+  _assert_same_outline (&agrave, &warm);
+
+  _draw_and_check_extents (font, 4, &udieresis);
+  g_assert_cmpint (udieresis.x_min, ==, 87);
+  g_assert_cmpint (udieresis.y_max, ==, 827);
+  _draw_and_check_extents (font, 4, &warm);
+  _assert_same_outline (&udieresis, &warm);
+  hb_font_destroy (font);
+
+  /* Now decode every other glyph through extents first, so that drawing
+   * the seac glyphs replays components cached by another path. */
+  face = hb_test_open_font_file ("fonts/cff1_seac.otf");
+  font = hb_font_create (face);
+  hb_ot_font_set_funcs (font);
+  unsigned int num_glyphs = hb_face_get_glyph_count (face);
+  hb_face_destroy (face);
+  hb_glyph_extents_t extents;
+  for (hb_codepoint_t g = 0; g < num_glyphs; g++)
+    if (g != 3 && g != 4)
+      hb_font_get_glyph_extents (font, g, &extents);
+
+  _draw_and_check_extents (font, 3, &warm);
+  _assert_same_outline (&agrave, &warm);
+  _draw_and_check_extents (font, 4, &warm);
+  _assert_same_outline (&udieresis, &warm);
+
+  hb_font_destroy (font);
+}
+#endif
+
+static void
+test_extents_cff1_batch (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/cff1_seac.otf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  /* Glyphs in reverse, ending with one out of range. */
+  hb_codepoint_t glyphs[] = { 4, 3, 2, 1, 0, 1000 };
+  hb_glyph_extents_t extents[G_N_ELEMENTS (glyphs)];
+  hb_glyph_extents_t  single;
+  unsigned int i;
+
+  hb_font_get_glyph_extents_batch (font, G_N_ELEMENTS (glyphs),
+				   glyphs, sizeof (glyphs[0]),
+				   extents, sizeof (extents[0]));
+  for (i = 0; i < G_N_ELEMENTS (glyphs); i++)
+  {
+    hb_font_get_glyph_extents (font, glyphs[i], &single);
+    g_assert_cmpint (extents[i].x_bearing, ==, single.x_bearing);
+    g_assert_cmpint (extents[i].y_bearing, ==, single.y_bearing);
+    g_assert_cmpint (extents[i].width, ==, single.width);
+    g_assert_cmpint (extents[i].height, ==, single.height);
+  }
+  g_assert_cmpint (extents[1].width, ==, 538); /* Agrave */
+  g_assert_cmpint (extents[G_N_ELEMENTS (glyphs) - 1].width, ==, 0);
+
+  /* Through a scaled sub-font, every other glyph. */
+  hb_font_t *subfont = hb_font_create_sub_font (font);
+  hb_font_set_scale (subfont, 2000, 3000);
+  hb_font_get_glyph_extents_batch (subfont, G_N_ELEMENTS (glyphs) / 2,
+				   glyphs, 2 * sizeof (glyphs[0]),
+				   extents, sizeof (extents[0]));
+  for (i = 0; i < G_N_ELEMENTS (glyphs) / 2; i++)
+  {
+    hb_font_get_glyph_extents (subfont, glyphs[2 * i], &single);
+    g_assert_cmpint (extents[i].x_bearing, ==, single.x_bearing);
+    g_assert_cmpint (extents[i].y_bearing, ==, single.y_bearing);
+    g_assert_cmpint (extents[i].width, ==, single.width);
+    g_assert_cmpint (extents[i].height, ==, single.height);
+  }
+  g_assert_cmpint (extents[0].width, ==, 2 * 471); /* Udieresis */
+  g_assert_cmpint (extents[0].height, ==, 3 * -839);
+
+  hb_font_destroy (subfont);
+  hb_font_destroy (font);
+}
+
 static void
 test_extents_cff2 (void)
 {
@@ -215,6 +391,53 @@ test_extents_cff2_vsindex_named_instance (void)
   hb_font_destroy (font);
 }
 
+static void
+test_extents_cff2_change_coords (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype_vsindex.otf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  /* Blend scalars are cached on the font; make sure changing the
+   * coordinates of a font already used for extents is honored. */
+  hb_glyph_extents_t  extents;
+  float coords[2] = { 800.0f, 50.0f };
+  hb_font_set_var_coords_design (font, coords, 2);
+  hb_bool_t result = hb_font_get_glyph_extents (font, 1, &extents);
+  g_assert (result);
+  g_assert_cmpint (extents.x_bearing, ==, 12);
+  g_assert_cmpint (extents.width, ==, 652);
+
+  hb_font_set_var_named_instance (font, 6); // 6 (BlackMediumContrast): 900, 50
+  result = hb_font_get_glyph_extents (font, 1, &extents);
+  g_assert (result);
+  g_assert_cmpint (extents.x_bearing, ==, 13);
+  g_assert_cmpint (extents.width, ==, 653);
+
+  hb_font_set_var_coords_design (font, coords, 2);
+  result = hb_font_get_glyph_extents (font, 2, &extents);
+  g_assert (result);
+  g_assert_cmpint (extents.x_bearing, ==, 8);
+  g_assert_cmpint (extents.width, ==, 649);
+
+  hb_font_set_var_coords_design (font, NULL, 0);
+  result = hb_font_get_glyph_extents (font, 1, &extents);
+  g_assert (result);
+  hb_glyph_extents_t  default_extents;
+  hb_font_t *default_font = hb_font_create (hb_font_get_face (font));
+  hb_ot_font_set_funcs (default_font);
+  result = hb_font_get_glyph_extents (default_font, 1, &default_extents);
+  g_assert (result);
+  g_assert_cmpint (extents.x_bearing, ==, default_extents.x_bearing);
+  g_assert_cmpint (extents.width, ==, default_extents.width);
+  hb_font_destroy (default_font);
+
+  hb_font_destroy (font);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -223,9 +446,14 @@ main (int argc, char **argv)
   hb_test_add (test_extents_cff1);
   hb_test_add (test_extents_cff1_flex);
   hb_test_add (test_extents_cff1_seac);
+#ifdef HB_EXPERIMENTAL_API
+  hb_test_add (test_extents_cff1_seac_cached);
+#endif
+  hb_test_add (test_extents_cff1_batch);
   hb_test_add (test_extents_cff2);
   hb_test_add (test_extents_cff2_vsindex);
   hb_test_add (test_extents_cff2_vsindex_named_instance);
+  hb_test_add (test_extents_cff2_change_coords);
 
   return hb_test_run ();
 }
@@ -207,6 +207,44 @@ test_extents_tt_var_comp (void)
   hb_font_destroy (font);
 }
 
+static void
+test_extents_tt_var_comp_batch (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansVariable-Roman.modcomp.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  float coords[1] = { 800.0f };
+  hb_font_set_var_coords_design (font, coords, 1);
+
+  /* Composites at different depths share the batch's point buffers. */
+  hb_codepoint_t glyphs[] = { 4, 2, 3, 0, 1000, 2 };
+  hb_glyph_extents_t extents[G_N_ELEMENTS (glyphs)];
+  hb_font_get_glyph_extents_batch (font, G_N_ELEMENTS (glyphs),
+				   glyphs, sizeof (glyphs[0]),
+				   extents, sizeof (extents[0]));
+
+  for (unsigned int i = 0; i < G_N_ELEMENTS (glyphs); i++)
+  {
+    hb_glyph_extents_t single = {0};
+    hb_font_get_glyph_extents (font, glyphs[i], &single);
+    g_assert_cmpint (extents[i].x_bearing, ==, single.x_bearing);
+    g_assert_cmpint (extents[i].y_bearing, ==, single.y_bearing);
+    g_assert_cmpint (extents[i].width, ==, single.width);
+    g_assert_cmpint (extents[i].height, ==, single.height);
+  }
+
+  g_assert_cmpint (extents[1].x_bearing, ==, 19);
+  g_assert_cmpint (extents[1].y_bearing, ==, 663);
+  g_assert_cmpint (extents[1].width, ==, 519);
+  g_assert_cmpint (extents[1].height, ==, -895);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_advance_tt_var_comp_v (void)
 {
@@ -234,6 +272,63 @@ test_advance_tt_var_comp_v (void)
   hb_font_destroy (font);
 }
 
+static void
+check_v_origins_batch (hb_font_t *font)
+{
+  hb_codepoint_t glyphs[] = { 2, 3, 4, 2, 1000 };
+  hb_position_t x[G_N_ELEMENTS (glyphs)], y[G_N_ELEMENTS (glyphs)];
+  unsigned int count = hb_font_get_glyph_v_origins (font, G_N_ELEMENTS (glyphs),
+						    glyphs, sizeof (glyphs[0]),
+						    x, sizeof (x[0]),
+						    y, sizeof (y[0]));
+  g_assert_cmpuint (count, ==, G_N_ELEMENTS (glyphs));
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    hb_position_t single_x, single_y;
+    g_assert (hb_font_get_glyph_v_origin (font, glyphs[i], &single_x, &single_y));
+    g_assert_cmpint (x[i], ==, single_x);
+    g_assert_cmpint (y[i], ==, single_y);
+  }
+}
+
+static void
+test_advance_tt_var_comp_v_origins (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansVariable-Roman.modcomp.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  hb_position_t x, y;
+  float coords[1] = { 800.0f };
+  hb_font_set_var_coords_design (font, coords, 1);
+  check_v_origins_batch (font);
+
+  hb_font_get_glyph_origin_for_direction (font, 2, HB_DIRECTION_TTB, &x, &y);
+  g_assert_cmpint (x, ==, 292);
+  g_assert_cmpint (y, ==, 1013);
+
+  /* Origins derived from the outlines follow coordinate and scale changes. */
+  coords[0] = 200.0f;
+  hb_font_set_var_coords_design (font, coords, 1);
+  check_v_origins_batch (font);
+  hb_font_get_glyph_origin_for_direction (font, 2, HB_DIRECTION_TTB, &x, &y);
+  g_assert_cmpint (y, !=, 1013);
+
+  hb_font_set_scale (font, 2000, 2000);
+  check_v_origins_batch (font);
+
+  hb_font_t *sub_font = hb_font_create_sub_font (font);
+  hb_font_set_scale (sub_font, 500, 1500);
+  check_v_origins_batch (sub_font);
+  hb_font_destroy (sub_font);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_advance_tt_var_gvar_infer (void)
 {
@@ -251,6 +346,46 @@ test_advance_tt_var_gvar_infer (void)
   hb_font_destroy (font);
 }
 
+static void
+test_extents_tt_var_reinstance (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansVariable-Roman.modcomp.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  /* Instance the same glyph again and again, as when animating axes.
+   * The first frame fills the cache of decoded deltas, so every frame is
+   * checked against the values the uncached decoder gives. */
+  static const struct
+  {
+    float wght;
+    hb_position_t advance;
+    hb_glyph_extents_t extents;
+  } frames[] = {
+    { 800.0f, 584, { 19, 663, 519, -895 } },
+    {   0.0f, 562, { 30, 672, 466, -878 } },
+    { 400.0f, 571, { 26, 668, 487, -884 } },
+    { 800.0f, 584, { 19, 663, 519, -895 } },
+  };
+  for (unsigned int round = 0; round < 2; round++)
+    for (unsigned int i = 0; i < G_N_ELEMENTS (frames); i++)
+    {
+      hb_glyph_extents_t extents;
+      hb_font_set_var_coords_design (font, &frames[i].wght, 1);
+      g_assert_cmpint (hb_font_get_glyph_h_advance (font, 2), ==, frames[i].advance);
+      g_assert (hb_font_get_glyph_extents (font, 2, &extents));
+      g_assert_cmpint (extents.x_bearing, ==, frames[i].extents.x_bearing);
+      g_assert_cmpint (extents.y_bearing, ==, frames[i].extents.y_bearing);
+      g_assert_cmpint (extents.width, ==, frames[i].extents.width);
+      g_assert_cmpint (extents.height, ==, frames[i].extents.height);
+    }
+
+  hb_font_destroy (font);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -261,8 +396,11 @@ main (int argc, char **argv)
   hb_test_add (test_advance_tt_var_hvarvvar);
   hb_test_add (test_advance_tt_var_anchor);
   hb_test_add (test_extents_tt_var_comp);
+  hb_test_add (test_extents_tt_var_comp_batch);
   hb_test_add (test_advance_tt_var_comp_v);
+  hb_test_add (test_advance_tt_var_comp_v_origins);
   hb_test_add (test_advance_tt_var_gvar_infer);
+  hb_test_add (test_extents_tt_var_reinstance);
 
   return hb_test_run ();
 }
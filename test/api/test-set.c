@@ -121,6 +121,15 @@ test_set_basic (void)
   hb_set_del (s, 800);
   g_assert (!hb_set_has (s, 800));
 
+  g_assert_cmpint (hb_set_get_max (s), ==, 799);
+
+  hb_set_clear (s);
+  hb_set_add (s, 600);
+  hb_set_add (s, 1600);
+  hb_set_del (s, 1600);
+  g_assert_cmpint (hb_set_get_max (s), ==, 600);
+  g_assert_cmpint (hb_set_get_population (s), ==, 1);
+
   hb_set_destroy (s);
 }
 
@@ -440,6 +449,33 @@ test_set_iter (void)
   g_assert_cmpint (first, ==, HB_SET_VALUE_INVALID);
   g_assert_cmpint (last,  ==, HB_SET_VALUE_INVALID);
 
+  /* Ranges spanning several pages, around an emptied page. */
+  hb_set_clear (s);
+  hb_set_add_range (s, 100, 3000);
+  hb_set_add (s, 4000);
+  hb_set_del (s, 4000);
+  hb_set_add_range (s, 5000, 5000);
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 100);
+  g_assert_cmpint (last,  ==, 3000);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 5000);
+  g_assert_cmpint (last,  ==, 5000);
+  g_assert (!hb_set_next_range (s, &first, &last));
+
+  next = 4500;
+  g_assert (hb_set_previous (s, &next));
+  g_assert_cmpint (next, ==, 3000);
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 100);
+  g_assert_cmpint (last,  ==, 3000);
+  g_assert (!hb_set_previous_range (s, &first, &last));
+
   hb_set_destroy (s);
 }
 
@@ -517,6 +553,227 @@ test_set_delrange (void)
   hb_set_destroy (s);
 }
 
+static void
+test_set_invert (void)
+{
+  hb_codepoint_t next, first, last;
+  hb_set_t *s = hb_set_create ();
+  hb_set_t *o = hb_set_create ();
+
+  hb_set_add (s, 13);
+  hb_set_add_range (s, 10, 15);
+  hb_set_add (s, 1100);
+  hb_set_invert (s);
+
+  test_not_empty (s);
+  g_assert (!hb_set_has (s, 10));
+  g_assert (!hb_set_has (s, 1100));
+  g_assert (hb_set_has (s, 9));
+  g_assert (hb_set_has (s, 16));
+  g_assert (hb_set_has (s, HB_SET_VALUE_INVALID - 1));
+  g_assert (!hb_set_has (s, HB_SET_VALUE_INVALID));
+  g_assert_cmpint (hb_set_get_population (s), ==, HB_SET_VALUE_INVALID - 7);
+  g_assert_cmpint (hb_set_get_min (s), ==, 0);
+  g_assert_cmpint (hb_set_get_max (s), ==, HB_SET_VALUE_INVALID - 1);
+
+  next = 9;
+  g_assert (hb_set_next (s, &next));
+  g_assert_cmpint (next, ==, 16);
+  next = 16;
+  g_assert (hb_set_previous (s, &next));
+  g_assert_cmpint (next, ==, 9);
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (last,  ==, 9);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 16);
+  g_assert_cmpint (last,  ==, 1099);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 1101);
+  g_assert_cmpint (last,  ==, HB_SET_VALUE_INVALID - 1);
+  g_assert (!hb_set_next_range (s, &first, &last));
+
+  /* Adding and deleting on an inverted set. */
+  hb_set_add (s, 12);
+  hb_set_del_range (s, 0, 5);
+  g_assert (hb_set_has (s, 12));
+  g_assert (!hb_set_has (s, 3));
+  g_assert_cmpint (hb_set_get_min (s), ==, 6);
+
+  /* Algebra between inverted and plain sets. */
+  hb_set_add_range (o, 0, 20);
+  hb_set_intersect (s, o);
+  g_assert_cmpint (hb_set_get_population (s), ==, 10);
+  g_assert (hb_set_is_subset (s, o));
+  hb_set_invert (o);
+  g_assert (!hb_set_is_subset (s, o));
+  hb_set_union (s, o);
+  g_assert (!hb_set_has (s, 0));
+  g_assert (hb_set_has (s, 6));
+  g_assert (hb_set_has (s, 21));
+  g_assert (!hb_set_has (s, 13));
+
+  hb_set_invert (s);
+  hb_set_clear (o);
+  hb_set_add_range (o, 0, 5);
+  hb_set_add_range (o, 10, 11);
+  hb_set_add_range (o, 13, 15);
+  g_assert (hb_set_is_equal (s, o));
+
+  /* Inverting twice is a no-op. */
+  hb_set_invert (o);
+  g_assert (!hb_set_is_equal (s, o));
+  hb_set_invert (o);
+  g_assert (hb_set_is_equal (s, o));
+
+  /* Clearing drops the inversion. */
+  hb_set_clear (s);
+  test_empty (s);
+
+  /* Covering almost every codepoint doesn't need memory for them all. */
+  hb_set_add_range (s, 1, HB_SET_VALUE_INVALID - 1);
+  g_assert (hb_set_allocation_successful (s));
+  g_assert (!hb_set_has (s, 0));
+  g_assert (hb_set_has (s, 1));
+  g_assert_cmpint (hb_set_get_population (s), ==, HB_SET_VALUE_INVALID - 1);
+
+  hb_set_destroy (o);
+  hb_set_destroy (s);
+}
+
+static void
+test_set_ranges (void)
+{
+  hb_codepoint_t next, first, last;
+  hb_set_t *s = hb_set_create ();
+  hb_set_t *o = hb_set_create ();
+  unsigned int i;
+
+  /* All of Unicode, as a range list. */
+  hb_set_add_range (s, 0, 0x10FFFF);
+  test_not_empty (s);
+  g_assert (hb_set_allocation_successful (s));
+  g_assert (hb_set_has (s, 0));
+  g_assert (hb_set_has (s, 0x10FFFF));
+  g_assert (!hb_set_has (s, 0x110000));
+  g_assert (!hb_set_has (s, HB_SET_VALUE_INVALID));
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x110000);
+  g_assert_cmpint (hb_set_get_min (s), ==, 0);
+  g_assert_cmpint (hb_set_get_max (s), ==, 0x10FFFF);
+
+  /* Adding and deleting splits and merges ranges. */
+  hb_set_del_range (s, 0x1000, 0x1FFF);
+  hb_set_del (s, 0x30000);
+  hb_set_add (s, 0x110001);
+  g_assert (!hb_set_has (s, 0x1000));
+  g_assert (!hb_set_has (s, 0x1FFF));
+  g_assert (hb_set_has (s, 0x2000));
+  g_assert (!hb_set_has (s, 0x30000));
+  g_assert (hb_set_has (s, 0x110001));
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x110000 - 0x1000);
+  g_assert_cmpint (hb_set_get_max (s), ==, 0x110001);
+
+  next = 0xFFF;
+  g_assert (hb_set_next (s, &next));
+  g_assert_cmpint (next, ==, 0x2000);
+  g_assert (hb_set_previous (s, &next));
+  g_assert_cmpint (next, ==, 0xFFF);
+  next = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_previous (s, &next));
+  g_assert_cmpint (next, ==, 0x110001);
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (last,  ==, 0xFFF);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0x2000);
+  g_assert_cmpint (last,  ==, 0x2FFFF);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0x30001);
+  g_assert_cmpint (last,  ==, 0x10FFFF);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0x110001);
+  g_assert_cmpint (last,  ==, 0x110001);
+  g_assert (!hb_set_next_range (s, &first, &last));
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0x30001);
+  g_assert_cmpint (last,  ==, 0x10FFFF);
+
+  hb_set_add_range (s, 0x1000, 0x1FFF);
+  hb_set_add (s, 0x30000);
+  hb_set_add (s, 0x110000);
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (last,  ==, 0x110001);
+  g_assert (!hb_set_next_range (s, &first, &last));
+
+  /* Inverting keeps a range list. */
+  hb_set_invert (s);
+  g_assert (!hb_set_has (s, 0x110001));
+  g_assert (hb_set_has (s, 0x110002));
+  g_assert_cmpint (hb_set_get_min (s), ==, 0x110002);
+  g_assert_cmpint (hb_set_get_population (s), ==, HB_SET_VALUE_INVALID - 0x110002);
+  hb_set_invert (s);
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x110002);
+
+  /* Comparing and combining with bitmaps. */
+  hb_set_clear (s);
+  hb_set_add_range (s, 0, 0x10FFFF);
+  hb_set_add_range (o, 0, 0x10FFF);
+  hb_set_add (o, 0x10FFFF);
+  g_assert (hb_set_is_subset (o, s));
+  g_assert (!hb_set_is_subset (s, o));
+  hb_set_add_range (o, 0x11000, 0x10FFFE);
+  g_assert (hb_set_is_equal (o, s));
+  g_assert (hb_set_is_equal (s, o));
+
+  hb_set_clear (o);
+  hb_set_add_range (o, 0x20, 0x7F);
+  hb_set_add (o, 0x110005);
+  hb_set_intersect (o, s);
+  g_assert_cmpint (hb_set_get_population (o), ==, 0x60);
+  hb_set_union (o, s);
+  g_assert (hb_set_is_equal (o, s));
+  hb_set_clear (o);
+  hb_set_add_range (o, 0x80, 0x10FFFF);
+  hb_set_subtract (o, s);
+  test_empty (o);
+
+  /* Union of range lists. */
+  hb_set_clear (s);
+  hb_set_clear (o);
+  hb_set_add_range (s, 0, 0xFFFF);
+  hb_set_add_range (o, 0x20000, 0x2FFFF);
+  hb_set_union (s, o);
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x20000);
+  hb_set_union (s, s);
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x20000);
+  hb_set_add (o, 5);
+  hb_set_union (s, o);
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x20000);
+
+  /* Many small holes move the ranges into the bitmap. */
+  hb_set_clear (s);
+  hb_set_add_range (s, 0, 0x10FFFF);
+  for (i = 0; i < 200; i++)
+    hb_set_del (s, i * 2);
+  g_assert (hb_set_allocation_successful (s));
+  g_assert_cmpint (hb_set_get_population (s), ==, 0x110000 - 200);
+  for (i = 0; i < 400; i++)
+    g_assert (hb_set_has (s, i) == (i % 2 == 1));
+  g_assert (hb_set_has (s, 0x10FFFF));
+
+  hb_set_destroy (o);
+  hb_set_destroy (s);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -527,6 +784,8 @@ main (int argc, char **argv)
   hb_test_add (test_set_iter);
   hb_test_add (test_set_empty);
   hb_test_add (test_set_delrange);
+  hb_test_add (test_set_invert);
+  hb_test_add (test_set_ranges);
 
   hb_test_add (test_set_intersect_empty);
   hb_test_add (test_set_intersect_page_reduction);
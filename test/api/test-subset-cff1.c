@@ -114,6 +114,134 @@ test_subset_cff1_desubr (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+test_subset_cff1_subr (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/SourceSansPro-Regular.abc.otf");
+  hb_face_t *face_ac = hb_test_open_font_file ("fonts/SourceSansPro-Regular.ac.nosubrs.otf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_ac_subr;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'c');
+  face_ac_subr = hb_subset_test_check_subroutinize (face_abc, face_ac, codepoints,
+						    HB_TAG ('C','F','F',' '));
+  hb_set_destroy (codepoints);
+
+  hb_face_destroy (face_ac_subr);
+  hb_face_destroy (face_abc);
+  hb_face_destroy (face_ac);
+}
+
+/* Minimal CFF1 reader: returns the charstring of @gid in @cff. */
+static const uint8_t *
+_index_get (const uint8_t *index, const uint8_t *end, unsigned i,
+	    unsigned *length, const uint8_t **index_end)
+{
+  unsigned count, off_size, j, start = 0, stop = 0, last = 0;
+  g_assert (index + 3 <= end);
+  count = index[0] << 8 | index[1];
+  off_size = index[2];
+  g_assert (1 <= off_size && off_size <= 4);
+  g_assert (index + 3 + (count + 1) * off_size <= end);
+  for (j = 0; j < off_size; j++)
+  {
+    start = start << 8 | index[3 + i * off_size + j];
+    stop = stop << 8 | index[3 + (i + 1) * off_size + j];
+    last = last << 8 | index[3 + count * off_size + j];
+  }
+  index += 3 + (count + 1) * off_size - 1;
+  g_assert (i < count && start <= stop && index + last <= end);
+  if (index_end) *index_end = index + last;
+  *length = stop - start;
+  return index + start;
+}
+
+static const uint8_t *
+_cff1_get_charstring (hb_blob_t *cff, hb_codepoint_t gid, unsigned *length)
+{
+  unsigned cff_length, top_length, charstrings = 0;
+  const uint8_t *data = (const uint8_t *) hb_blob_get_data (cff, &cff_length);
+  const uint8_t *end = data + cff_length;
+  const uint8_t *names, *top_dicts, *top;
+  int operand = 0;
+
+  g_assert (cff_length >= 4);
+  names = data + data[2];
+  _index_get (names, end, 0, &top_length, &top_dicts);
+  top = _index_get (top_dicts, end, 0, &top_length, NULL);
+  for (const uint8_t *p = top; p < top + top_length;)
+  {
+    uint8_t b0 = *p++;
+    if (b0 == 28) { operand = (int16_t) (p[0] << 8 | p[1]); p += 2; }
+    else if (b0 == 29) { operand = (int32_t) ((unsigned) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]); p += 4; }
+    else if (b0 == 30) { while (p < top + top_length && (*p & 0x0F) != 0x0F && (*p & 0xF0) != 0xF0) p++; p++; }
+    else if (b0 >= 32 && b0 <= 246) operand = b0 - 139;
+    else if (b0 >= 247 && b0 <= 250) operand = (b0 - 247) * 256 + *p++ + 108;
+    else if (b0 >= 251 && b0 <= 254) operand = -(b0 - 251) * 256 - *p++ - 108;
+    else if (b0 == 12) p++;
+    else if (b0 == 17) charstrings = operand;
+  }
+  g_assert (charstrings);
+  return _index_get (data + charstrings, end, gid, length, NULL);
+}
+
+/* Length of the operands and operator of the first charstring operator. */
+static unsigned
+_first_token_length (const uint8_t *charstring, unsigned length)
+{
+  unsigned i = 0;
+  while (i < length)
+  {
+    uint8_t b0 = charstring[i];
+    if (b0 == 28) i += 3;
+    else if (b0 == 255) i += 5;
+    else if (b0 >= 247) i += 2;
+    else if (b0 >= 32) i++;
+    else return i + (b0 == 12 ? 2 : 1);
+  }
+  return length;
+}
+
+static void
+test_subset_cff1_subr_width (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansPro-Regular.otf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_subset_input_t *input;
+  hb_face_t *face_desubr, *face_subr;
+  hb_blob_t *cff_desubr, *cff_subr;
+  hb_set_add_range (codepoints, 'A', 'Z');
+  hb_set_add_range (codepoints, 'a', 'z');
+  input = hb_subset_test_create_input (codepoints);
+  hb_subset_input_set_desubroutinize (input, true);
+  face_desubr = hb_subset_test_create_subset (face, input);
+  face_subr = hb_subset_test_check_subroutinize (face, face_desubr, codepoints,
+						 HB_TAG ('C','F','F',' '));
+  hb_set_destroy (codepoints);
+
+  /* The first operator of every glyph may carry its width and must not
+   * be moved into a subroutine. */
+  cff_desubr = hb_face_reference_table (face_desubr, HB_TAG ('C','F','F',' '));
+  cff_subr = hb_face_reference_table (face_subr, HB_TAG ('C','F','F',' '));
+  for (hb_codepoint_t gid = 0; gid < hb_face_get_glyph_count (face_desubr); gid++)
+  {
+    unsigned length, subr_length, token_length;
+    const uint8_t *charstring = _cff1_get_charstring (cff_desubr, gid, &length);
+    const uint8_t *subr_charstring = _cff1_get_charstring (cff_subr, gid, &subr_length);
+    token_length = _first_token_length (charstring, length);
+    g_assert_cmpuint (subr_length, >=, token_length);
+    g_assert_cmpmem (charstring, token_length, subr_charstring, token_length);
+  }
+
+  hb_blob_destroy (cff_subr);
+  hb_blob_destroy (cff_desubr);
+  hb_face_destroy (face_subr);
+  hb_face_destroy (face_desubr);
+  hb_face_destroy (face);
+}
+
 static void
 test_subset_cff1_desubr_strip_hints (void)
 {
@@ -345,6 +473,8 @@ main (int argc, char **argv)
   hb_test_add (test_subset_cff1);
   hb_test_add (test_subset_cff1_strip_hints);
   hb_test_add (test_subset_cff1_desubr);
+  hb_test_add (test_subset_cff1_subr);
+  hb_test_add (test_subset_cff1_subr_width);
   hb_test_add (test_subset_cff1_desubr_strip_hints);
   hb_test_add (test_subset_cff1_j);
   hb_test_add (test_subset_cff1_j_strip_hints);
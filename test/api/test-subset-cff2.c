@@ -114,6 +114,25 @@ test_subset_cff2_desubr (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+test_subset_cff2_subr (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_face_t *face_ac = hb_test_open_font_file ("fonts/AdobeVFPrototype.ac.nosubrs.otf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_ac_subr;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'c');
+  face_ac_subr = hb_subset_test_check_subroutinize (face_abc, face_ac, codepoints,
+						    HB_TAG ('C','F','F','2'));
+  hb_set_destroy (codepoints);
+
+  hb_face_destroy (face_ac_subr);
+  hb_face_destroy (face_abc);
+  hb_face_destroy (face_ac);
+}
+
 static void
 test_subset_cff2_desubr_strip_hints (void)
 {
@@ -161,6 +180,38 @@ test_subset_cff2_retaingids (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+test_subset_cff2_pin_axis (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_subset_input_t *input;
+  hb_face_t *face_abc_subset;
+  hb_blob_t *cff2, *fvar;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'b');
+  hb_set_add (codepoints, 'c');
+  input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+  g_assert (hb_subset_input_pin_axis_location (input, face_abc, HB_TAG ('w','g','h','t'), 900.f));
+  face_abc_subset = hb_subset_test_create_subset (face_abc, input);
+  g_assert (face_abc_subset != hb_face_get_empty ());
+
+  /* The blends are evaluated at the pinned location, and no variation
+   * data is left. */
+  cff2 = hb_face_reference_table (face_abc_subset, HB_TAG ('C','F','F','2'));
+  g_assert_cmpuint (hb_blob_get_length (cff2), >, 0);
+  hb_blob_destroy (cff2);
+  fvar = hb_face_reference_table (face_abc_subset, HB_TAG ('f','v','a','r'));
+  g_assert_cmpuint (hb_blob_get_length (fvar), ==, 0);
+  hb_blob_destroy (fvar);
+  hb_subset_test_check_instance (face_abc, face_abc_subset, HB_TAG ('w','g','h','t'), 900.f, "abcacb");
+
+  hb_face_destroy (face_abc_subset);
+  hb_face_destroy (face_abc);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -170,8 +221,10 @@ main (int argc, char **argv)
   hb_test_add (test_subset_cff2);
   hb_test_add (test_subset_cff2_strip_hints);
   hb_test_add (test_subset_cff2_desubr);
+  hb_test_add (test_subset_cff2_subr);
   hb_test_add (test_subset_cff2_desubr_strip_hints);
   hb_test_add (test_subset_cff2_retaingids);
+  hb_test_add (test_subset_cff2_pin_axis);
 
   return hb_test_run ();
 }
@@ -84,6 +84,34 @@ test_subset_gpos_pairpos1_vf (void)
 #endif
 }
 
+static void
+test_subset_gpos_pairpos1_vf_pin_axis (void)
+{
+#ifdef HB_EXPERIMENTAL_API
+  hb_face_t *face_wa = hb_test_open_font_file ("fonts/AdobeVFPrototype.WA.gpos.otf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_wa_subset;
+  hb_set_add (codepoints, 'W');
+  hb_set_add (codepoints, 'A');
+
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G', 'P', 'O', 'S'));
+  g_assert (hb_subset_input_pin_axis_location (input, face_wa, HB_TAG ('w','g','h','t'), 900.f));
+
+  face_wa_subset = hb_subset_test_create_subset (face_wa, input);
+  g_assert (face_wa_subset != hb_face_get_empty ());
+
+  /* The kerning device tables are folded into the pair values. */
+  hb_subset_test_check_instance (face_wa, face_wa_subset, HB_TAG ('w','g','h','t'), 900.f, "AWAW");
+
+  hb_face_destroy (face_wa_subset);
+  hb_face_destroy (face_wa);
+#endif
+}
+
 int
 main (int argc, char **argv)
 {
@@ -91,6 +119,7 @@ main (int argc, char **argv)
 
   hb_test_add (test_subset_gpos_lookup_subtable);
   hb_test_add (test_subset_gpos_pairpos1_vf);
+  hb_test_add (test_subset_gpos_pairpos1_vf_pin_axis);
 
   return hb_test_run ();
 }
@@ -90,6 +90,189 @@ test_subset_gvar_retaingids (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+test_subset_gvar_pin_axis (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/SourceSansVariable-Roman.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_abc_subset;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'b');
+  hb_set_add (codepoints, 'c');
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  g_assert (hb_subset_input_pin_axis_location (input, face_abc, HB_TAG ('w','g','h','t'), 900.f));
+  g_assert (!hb_subset_input_pin_axis_location (input, face_abc, HB_TAG ('w','d','t','h'), 100.f));
+  face_abc_subset = hb_subset_test_create_subset (face_abc, input);
+  hb_set_destroy (codepoints);
+
+  hb_blob_t *gvar = hb_face_reference_table (face_abc_subset, HB_TAG ('g','v','a','r'));
+  hb_blob_t *fvar = hb_face_reference_table (face_abc_subset, HB_TAG ('f','v','a','r'));
+  g_assert (!hb_blob_get_length (gvar));
+  g_assert (!hb_blob_get_length (fvar));
+  hb_blob_destroy (gvar);
+  hb_blob_destroy (fvar);
+
+  hb_font_t *font = hb_font_create (face_abc);
+  hb_variation_t variation = { HB_TAG ('w','g','h','t'), 900.f };
+  hb_font_set_variations (font, &variation, 1);
+  hb_font_t *font_subset = hb_font_create (face_abc_subset);
+
+  /* head bounding box and hhea.advanceWidthMax describe the instanced glyphs. */
+  int x_min = 0, y_min = 0, x_max = 0, y_max = 0;
+  unsigned max_advance = 0;
+  hb_bool_t has_bounds = false;
+  for (hb_codepoint_t gid = 0; gid < hb_face_get_glyph_count (face_abc_subset); gid++)
+  {
+    hb_glyph_extents_t extents;
+    max_advance = MAX (max_advance, hb_font_get_glyph_h_advance (font_subset, gid));
+    g_assert (hb_font_get_glyph_extents (font_subset, gid, &extents));
+    if (!extents.width && !extents.height)
+      continue;
+    if (!has_bounds)
+    {
+      x_min = extents.x_bearing;
+      y_max = extents.y_bearing;
+      x_max = extents.x_bearing + extents.width;
+      y_min = extents.y_bearing + extents.height;
+    }
+    x_min = MIN (x_min, extents.x_bearing);
+    y_max = MAX (y_max, extents.y_bearing);
+    x_max = MAX (x_max, extents.x_bearing + extents.width);
+    y_min = MIN (y_min, extents.y_bearing + extents.height);
+    has_bounds = true;
+  }
+  g_assert (has_bounds);
+
+  unsigned length;
+  hb_blob_t *head = hb_face_reference_table (face_abc_subset, HB_TAG ('h','e','a','d'));
+  const uint8_t *head_data = (const uint8_t *) hb_blob_get_data (head, &length);
+  g_assert_cmpuint (length, >=, 44);
+  g_assert_cmpint ((int16_t) (head_data[36] << 8 | head_data[37]), ==, x_min);
+  g_assert_cmpint ((int16_t) (head_data[38] << 8 | head_data[39]), ==, y_min);
+  g_assert_cmpint ((int16_t) (head_data[40] << 8 | head_data[41]), ==, x_max);
+  g_assert_cmpint ((int16_t) (head_data[42] << 8 | head_data[43]), ==, y_max);
+  hb_blob_destroy (head);
+
+  hb_blob_t *hhea = hb_face_reference_table (face_abc_subset, HB_TAG ('h','h','e','a'));
+  const uint8_t *hhea_data = (const uint8_t *) hb_blob_get_data (hhea, &length);
+  g_assert_cmpuint (length, >=, 12);
+  g_assert_cmpuint ((unsigned) (hhea_data[10] << 8 | hhea_data[11]), ==, max_advance);
+  hb_blob_destroy (hhea);
+
+  for (hb_codepoint_t u = 'a'; u <= 'c'; u++)
+  {
+    hb_codepoint_t gid, gid_subset;
+    hb_glyph_extents_t extents, extents_subset;
+    g_assert (hb_font_get_nominal_glyph (font, u, &gid));
+    g_assert (hb_font_get_nominal_glyph (font_subset, u, &gid_subset));
+
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, gid), ==,
+		     hb_font_get_glyph_h_advance (font_subset, gid_subset));
+    g_assert (hb_font_get_glyph_extents (font, gid, &extents));
+    g_assert (hb_font_get_glyph_extents (font_subset, gid_subset, &extents_subset));
+    g_assert_cmpint (extents.x_bearing, ==, extents_subset.x_bearing);
+    g_assert_cmpint (extents.y_bearing, ==, extents_subset.y_bearing);
+    g_assert_cmpint (extents.width, ==, extents_subset.width);
+    g_assert_cmpint (extents.height, ==, extents_subset.height);
+  }
+
+  hb_font_destroy (font_subset);
+  hb_font_destroy (font);
+  hb_face_destroy (face_abc_subset);
+  hb_face_destroy (face_abc);
+}
+
+static void
+test_subset_gvar_pin_axis_gdef_variations (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/SourceSansVariable-Roman.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_abc_subset, *face_abc_instance;
+  hb_subset_input_t *input;
+  hb_blob_t *gdef;
+  const char *data;
+  unsigned int length;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'b');
+  hb_set_add (codepoints, 'c');
+
+  input = hb_subset_test_create_input (codepoints);
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','D','E','F'));
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','P','O','S'));
+  face_abc_subset = hb_subset_test_create_subset (face_abc, input);
+
+  input = hb_subset_test_create_input (codepoints);
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','D','E','F'));
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','P','O','S'));
+  g_assert (hb_subset_input_pin_axis_location (input, face_abc, HB_TAG ('w','g','h','t'), 900.f));
+  face_abc_instance = hb_subset_test_create_subset (face_abc, input);
+  g_assert (face_abc_instance != hb_face_get_empty ());
+  hb_set_destroy (codepoints);
+
+  /* The kerning deltas are folded into GPOS, and GDEF keeps no variation
+   * store. */
+#ifdef HB_EXPERIMENTAL_API
+  hb_subset_test_check_instance (face_abc_subset, face_abc_instance, HB_TAG ('w','g','h','t'), 900.f, "abcaacba");
+#endif
+  gdef = hb_face_reference_table (face_abc_instance, HB_TAG ('G','D','E','F'));
+  data = hb_blob_get_data (gdef, &length);
+  g_assert_cmpuint (length, >=, 4);
+  g_assert (data[3] < 3 || (length >= 16 && !data[12] && !data[13] && !data[14] && !data[15]));
+  hb_blob_destroy (gdef);
+
+  hb_face_destroy (face_abc_instance);
+  hb_face_destroy (face_abc_subset);
+  hb_face_destroy (face_abc);
+}
+
+static void
+test_subset_gvar_pin_axis_empty_component (void)
+{
+  /* U+00A0 is a composite of the space glyph, which has no outline. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSerifVariable-Roman.20,61,A0.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *face_subset;
+  hb_set_add (codepoints, 0x20);
+  hb_set_add (codepoints, 0x61);
+  hb_set_add (codepoints, 0xA0);
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+  hb_set_add (hb_subset_input_drop_tables_set (input), HB_TAG ('G','D','E','F'));
+  hb_set_add (hb_subset_input_drop_tables_set (input), HB_TAG ('G','P','O','S'));
+  g_assert (hb_subset_input_pin_axis_location (input, face, HB_TAG ('w','g','h','t'), 900.f));
+  face_subset = hb_subset_test_create_subset (face, input);
+  g_assert_cmpuint (hb_face_get_glyph_count (face_subset), ==, hb_face_get_glyph_count (face));
+
+  hb_font_t *font = hb_font_create (face);
+  hb_variation_t variation = { HB_TAG ('w','g','h','t'), 900.f };
+  hb_font_set_variations (font, &variation, 1);
+  hb_font_t *font_subset = hb_font_create (face_subset);
+
+  for (hb_codepoint_t u = 0x20; u <= 0xA0; u++)
+  {
+    hb_codepoint_t gid, gid_subset;
+    if (!hb_font_get_nominal_glyph (font, u, &gid)) continue;
+    g_assert (hb_font_get_nominal_glyph (font_subset, u, &gid_subset));
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, gid), ==,
+		     hb_font_get_glyph_h_advance (font_subset, gid_subset));
+  }
+
+  hb_codepoint_t nbsp;
+  hb_glyph_extents_t extents;
+  g_assert (hb_font_get_nominal_glyph (font_subset, 0xA0, &nbsp));
+  g_assert (hb_font_get_glyph_extents (font_subset, nbsp, &extents));
+  g_assert_cmpint (extents.width, ==, 0);
+  g_assert_cmpint (extents.height, ==, 0);
+
+  hb_font_destroy (font_subset);
+  hb_font_destroy (font);
+  hb_face_destroy (face_subset);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -98,6 +281,9 @@ main (int argc, char **argv)
   hb_test_add (test_subset_gvar_noop);
   hb_test_add (test_subset_gvar);
   hb_test_add (test_subset_gvar_retaingids);
+  hb_test_add (test_subset_gvar_pin_axis);
+  hb_test_add (test_subset_gvar_pin_axis_gdef_variations);
+  hb_test_add (test_subset_gvar_pin_axis_empty_component);
 
   return hb_test_run ();
 }
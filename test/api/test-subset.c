@@ -95,6 +95,309 @@ test_subset_crash (void)
   hb_face_destroy (face);
 }
 
+static hb_bool_t
+_append_to_byte_array (hb_face_t *face HB_UNUSED,
+		       const char *data,
+		       unsigned int length,
+		       void *user_data)
+{
+  g_byte_array_append ((GByteArray *) user_data, (const guint8 *) data, length);
+  return true;
+}
+
+static hb_bool_t
+_fail_write (hb_face_t *face HB_UNUSED,
+	     const char *data HB_UNUSED,
+	     unsigned int length HB_UNUSED,
+	     void *user_data HB_UNUSED)
+{
+  return false;
+}
+
+static unsigned int
+_read_u16 (const char *p)
+{
+  return ((unsigned int) (unsigned char) p[0] << 8) |
+	 (unsigned int) (unsigned char) p[1];
+}
+
+static unsigned int
+_read_u32 (const char *p)
+{
+  return ((unsigned int) (unsigned char) p[0] << 24) |
+	 ((unsigned int) (unsigned char) p[1] << 16) |
+	 ((unsigned int) (unsigned char) p[2] << 8) |
+	 (unsigned int) (unsigned char) p[3];
+}
+
+static unsigned int
+_checksum (const char *data, unsigned int length)
+{
+  unsigned int sum = 0;
+  unsigned int i;
+  for (i = 0; i + 4 <= length; i += 4)
+    sum += _read_u32 (data + i);
+  if (i < length)
+  {
+    char tail[4] = {0, 0, 0, 0};
+    memcpy (tail, data + i, length - i);
+    sum += _read_u32 (tail);
+  }
+  return sum;
+}
+
+/* Parses the table directory of a serialized builder face back and checks
+ * it against the tables held by the builder. */
+static void
+_check_serialized_font (hb_face_t *builder, const char *data, unsigned int length)
+{
+  static const hb_tag_t required[] = {
+    HB_TAG ('c','m','a','p'), HB_TAG ('g','l','y','f'), HB_TAG ('h','e','a','d'),
+    HB_TAG ('h','h','e','a'), HB_TAG ('h','m','t','x'), HB_TAG ('l','o','c','a'),
+    HB_TAG ('m','a','x','p'),
+  };
+  unsigned int found = 0;
+  unsigned int num_tables, i, j;
+  unsigned int dir_length, expected_length;
+
+  g_assert_cmpuint (length, >=, 12);
+  g_assert_cmpuint (_read_u32 (data), ==, 0x00010000u);
+  num_tables = _read_u16 (data + 4);
+  g_assert_cmpuint (length, >=, 12 + 16 * num_tables);
+
+  dir_length = expected_length = 12 + 16 * num_tables;
+  for (i = 0; i < num_tables; i++)
+  {
+    const char *record = data + 12 + 16 * i;
+    hb_tag_t tag = _read_u32 (record);
+    unsigned int checksum = _read_u32 (record + 4);
+    unsigned int offset = _read_u32 (record + 8);
+    unsigned int table_length = _read_u32 (record + 12);
+    hb_blob_t *table = hb_face_reference_table (builder, tag);
+    unsigned int expected_table_length;
+    const char *expected_table = hb_blob_get_data (table, &expected_table_length);
+    unsigned int expected_checksum;
+
+    if (i)
+      g_assert_cmpuint (_read_u32 (record - 16), <, tag);
+    for (j = 0; j < G_N_ELEMENTS (required); j++)
+      if (required[j] == tag)
+	found++;
+    g_assert_cmpuint (expected_table_length, >, 0);
+    g_assert_cmpuint (offset, >=, dir_length);
+    g_assert_cmpuint (offset % 4, ==, 0);
+    g_assert_cmpuint (table_length, ==, expected_table_length);
+    g_assert_cmpuint (offset + table_length, <=, length);
+    for (j = 0; j < i; j++)
+    {
+      /* Tables must not overlap. */
+      unsigned int other_offset = _read_u32 (data + 12 + 16 * j + 8);
+      unsigned int other_length = _read_u32 (data + 12 + 16 * j + 12);
+      g_assert (offset + table_length <= other_offset ||
+		other_offset + other_length <= offset);
+    }
+
+    if (tag == HB_TAG ('h','e','a','d'))
+    {
+      /* checkSumAdjustment is the only field the writer changes. */
+      g_assert_cmpuint (table_length, >=, 12);
+      g_assert (0 == memcmp (data + offset, expected_table, 8));
+      g_assert (0 == memcmp (data + offset + 12, expected_table + 12, table_length - 12));
+      expected_checksum = _checksum (expected_table, expected_table_length) - _read_u32 (expected_table + 8);
+    }
+    else
+    {
+      g_assert (0 == memcmp (data + offset, expected_table, table_length));
+      expected_checksum = _checksum (expected_table, expected_table_length);
+    }
+    g_assert_cmpuint (checksum, ==, expected_checksum);
+
+    hb_blob_destroy (table);
+    expected_length += (table_length + 3) & ~3u;
+  }
+  g_assert_cmpuint (length, ==, expected_length);
+  g_assert_cmpuint (found, ==, G_N_ELEMENTS (required));
+
+  g_assert_cmphex (_checksum (data, length), ==, 0xB1B0AFBAu);
+}
+
+static void
+test_subset_serialize (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *subset;
+  hb_blob_t *blob;
+  GByteArray *streamed = g_byte_array_new ();
+  unsigned int length;
+  const char *data;
+  char *buffer;
+
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'c');
+  subset = hb_subset_test_create_subset (face, hb_subset_test_create_input (codepoints));
+  hb_set_destroy (codepoints);
+
+  length = hb_face_builder_get_serialized_length (subset);
+
+  g_assert (hb_face_builder_serialize (subset, _append_to_byte_array, streamed));
+  g_assert_cmpuint (streamed->len, ==, length);
+  _check_serialized_font (subset, (const char *) streamed->data, streamed->len);
+  g_assert (!hb_face_builder_serialize (subset, _fail_write, NULL));
+
+  buffer = (char *) g_malloc (length);
+  g_assert_cmpuint (hb_face_builder_serialize_to_buffer (subset, buffer, length), ==, length);
+  _check_serialized_font (subset, buffer, length);
+  g_assert_cmpuint (hb_face_builder_serialize_to_buffer (subset, buffer, length - 1), ==, 0);
+
+  blob = hb_face_reference_blob (subset);
+  data = hb_blob_get_data (blob, &length);
+  _check_serialized_font (subset, data, length);
+
+  g_assert_cmpuint (hb_face_builder_get_serialized_length (face), ==, 0);
+
+  g_free (buffer);
+  g_byte_array_free (streamed, TRUE);
+  hb_blob_destroy (blob);
+  hb_face_destroy (subset);
+  hb_face_destroy (face);
+}
+
+/* Checks a subset derived from @base_plan against hb_subset() with the
+ * options of @input, or the default options if @input is NULL. */
+static void
+_check_base_plan_subset (hb_face_t             *face,
+			 hb_subset_base_plan_t *base_plan,
+			 hb_subset_input_t     *input,
+			 hb_codepoint_t         first,
+			 hb_codepoint_t         last)
+{
+  hb_set_t *codepoints = hb_set_create ();
+  hb_face_t *expected, *actual;
+  hb_blob_t *expected_blob, *actual_blob;
+
+  hb_set_add_range (codepoints, first, last);
+  actual = hb_subset_with_base_plan (base_plan, codepoints, NULL);
+  if (input)
+  {
+    hb_set_clear (hb_subset_input_unicode_set (input));
+    hb_set_union (hb_subset_input_unicode_set (input), codepoints);
+    expected = hb_subset (face, input);
+  }
+  else
+    expected = hb_subset_test_create_subset (face, hb_subset_test_create_input (codepoints));
+  hb_set_destroy (codepoints);
+
+  expected_blob = hb_face_reference_blob (expected);
+  actual_blob = hb_face_reference_blob (actual);
+  g_assert_cmpuint (hb_blob_get_length (expected_blob), >, 0);
+  hb_test_assert_blobs_equal (expected_blob, actual_blob);
+
+  hb_blob_destroy (expected_blob);
+  hb_blob_destroy (actual_blob);
+  hb_face_destroy (expected);
+  hb_face_destroy (actual);
+}
+
+static void
+test_subset_base_plan (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_subset_base_plan_t *base_plan = hb_subset_base_plan_create_or_fail (face, input);
+  hb_set_destroy (codepoints);
+  g_assert (base_plan);
+
+  /* Later changes to the input don't affect the base plan. */
+  hb_subset_input_set_drop_hints (input, true);
+  hb_set_clear (hb_subset_input_nameid_set (input));
+  hb_subset_input_destroy (input);
+
+  _check_base_plan_subset (face, base_plan, NULL, 'a', 'a');
+  _check_base_plan_subset (face, base_plan, NULL, 'a', 'c');
+  _check_base_plan_subset (face, base_plan, NULL, 'b', 'c');
+
+  g_assert (hb_subset_with_base_plan (NULL, NULL, NULL) == hb_face_get_empty ());
+
+  hb_subset_base_plan_destroy (base_plan);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_base_plan_layout (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansPro-Regular.otf");
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_subset_base_plan_t *base_plan;
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','S','U','B'));
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','P','O','S'));
+  hb_set_del (hb_subset_input_drop_tables_set (input), HB_TAG ('G','D','E','F'));
+  hb_subset_input_set_desubroutinize (input, true);
+  base_plan = hb_subset_base_plan_create_or_fail (face, input);
+  g_assert (base_plan);
+
+  /* Two plans from the same base, each with its own layout closure. */
+  _check_base_plan_subset (face, base_plan, input, 'f', 'i');
+  _check_base_plan_subset (face, base_plan, input, 'A', 'Z');
+
+  hb_subset_base_plan_destroy (base_plan);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+/* Checks that subsetting to @unicodes gives the same font as subsetting
+ * to the codepoints the cmap of @face maps. */
+static void
+_check_subset_to_cmap (hb_face_t      *face,
+		       const hb_set_t *unicodes)
+{
+  hb_set_t *cmap_unicodes = hb_set_create ();
+  hb_subset_input_t *input;
+  hb_face_t *expected, *actual;
+  hb_blob_t *expected_blob, *actual_blob;
+
+  hb_face_collect_unicodes (face, cmap_unicodes);
+  expected = hb_subset_test_create_subset (face, hb_subset_test_create_input (cmap_unicodes));
+  hb_set_destroy (cmap_unicodes);
+
+  input = hb_subset_input_create_or_fail ();
+  hb_set_set (hb_subset_input_unicode_set (input), unicodes);
+  actual = hb_subset_test_create_subset (face, input);
+
+  expected_blob = hb_face_reference_blob (expected);
+  actual_blob = hb_face_reference_blob (actual);
+  g_assert_cmpuint (hb_blob_get_length (expected_blob), >, 0);
+  hb_test_assert_blobs_equal (expected_blob, actual_blob);
+
+  hb_blob_destroy (expected_blob);
+  hb_blob_destroy (actual_blob);
+  hb_face_destroy (expected);
+  hb_face_destroy (actual);
+}
+
+static void
+test_subset_all_unicodes (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansPro-Regular.otf");
+  hb_set_t *unicodes = hb_set_create ();
+
+  /* As a range list. */
+  hb_set_add_range (unicodes, 0, 0x10FFFF);
+  _check_subset_to_cmap (face, unicodes);
+
+  /* As an inverted bitmap. */
+  hb_set_clear (unicodes);
+  hb_set_invert (unicodes);
+  _check_subset_to_cmap (face, unicodes);
+
+  hb_set_destroy (unicodes);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -103,6 +406,10 @@ main (int argc, char **argv)
   hb_test_add (test_subset_32_tables);
   hb_test_add (test_subset_no_inf_loop);
   hb_test_add (test_subset_crash);
+  hb_test_add (test_subset_serialize);
+  hb_test_add (test_subset_base_plan);
+  hb_test_add (test_subset_base_plan_layout);
+  hb_test_add (test_subset_all_unicodes);
 
   return hb_test_run();
 }
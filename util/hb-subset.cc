@@ -99,6 +99,11 @@ struct subset_consumer_t
     hb_face_t *face = hb_font_get_face (font);
 
     hb_face_t *new_face = hb_subset (face, input);
+    for (unsigned i = 1; i < subset_options.num_iterations; i++)
+    {
+      hb_face_destroy (new_face);
+      new_face = hb_subset (face, input);
+    }
     hb_blob_t *result = hb_face_reference_blob (new_face);
 
     failed = !hb_blob_get_length (result);
@@ -681,6 +681,7 @@ struct subset_options_t : option_group_t
   subset_options_t (option_parser_t *parser)
   {
     input = hb_subset_input_create_or_fail ();
+    num_iterations = 1;
     add_options (parser);
   }
 
@@ -692,6 +693,7 @@ struct subset_options_t : option_group_t
   void add_options (option_parser_t *parser) override;
 
   hb_subset_input_t *input;
+  unsigned int num_iterations;
 };
 
 /* fallback implementation for scalbn()/scalbnf() for pre-2013 MSVC */